@@ -28,7 +28,7 @@ namespace tinyXMLtest{
 	  assert(t1.getTagName() == t2.getTagName());
 	  assert(t1.getAttributeCount() == t2.getAttributeCount());
 	  for(int i =0; i< t1.getAttributeCount(); ++i){
-	    assert(t1.getAttributeName(i) == t1.getAttributeName(i));
+	    assert(t1.getAttributeName(i) == t2.getAttributeName(i));
 	    assert(t1.getAttributeValue(i) == t2.getAttributeValue(i));
 	  }
 	  break;
@@ -0,0 +1,251 @@
+#include "AsyncParser.h"
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+#include <cstring>
+#include <algorithm>
+#include "Document.h"
+#include "TreeBuilder.h"
+#include "MemoryInputBuffer.h"
+#include "XMLException.h"
+
+namespace tinyXMLpp {
+
+  /**
+   * Coroutine which yields the type of each token of the tokenizer's input, up to and including ENDOFFILE.
+   *
+   *@param t The tokenizer to read from.
+   *@return A generator over the token types.
+   */
+  TokenGenerator tokens(XMLTokenizer& t)
+  {
+    TokenType type;
+    do {
+      type = t.getToken();
+      co_yield type;
+    } while (type != ENDOFFILE);
+  }
+
+  /**
+   * Function which adds bytes after the ones already received. Bytes the tokenizer read long ago are dropped first, keeping
+   * a few for the tokenizer to push back.
+   *
+   *@param bytes The bytes received.
+   *@param length The number of bytes.
+   */
+  void FeedInputBuffer::append(const char* bytes, size_t length)
+  {
+    const size_t putbackSize = 16;
+    size_t read = gptr() - eback();
+
+    if (read > putbackSize && read - putbackSize >= data.size() / 2) {
+      data.erase(data.begin(), data.begin() + (read - putbackSize));
+      read = putbackSize;
+    }
+
+    data.insert(data.end(), bytes, bytes + length);
+    setg(data.data(), data.data() + read, data.data() + data.size());
+  }
+
+  /**
+   * Constructor which starts with no input.
+   */
+  AsyncParser::AsyncParser()
+    : input(&buffer), tokenizer(input), waiting(nullptr), closed(false), started(false), encoding(UTF8),
+      decodeFailed(false)
+  {
+  }
+
+  /**
+   * Function which adds received bytes to the buffer the tokenizer reads. The first bytes are held back until the byte
+   * order mark can be told apart from the document, which is decided by DecodedInput as for the other parsers. UTF-16 is
+   * transcoded up to its last complete character; invalid UTF-16 ends the input the tokenizer sees.
+   *
+   *@param bytes The bytes received.
+   *@param length The number of bytes.
+   */
+  void AsyncParser::append(const char* bytes, size_t length)
+  {
+    if (!started) {
+      undecoded.insert(undecoded.end(), bytes, bytes + length);
+      if (undecoded.size() < 3 && !closed)
+	return;
+
+      MemoryInputBuffer head(undecoded.data(), undecoded.size());
+      std::istream headStream(&head);
+      DecodedInput decoded(headStream);
+      encoding = decoded.getEncoding();
+      undecoded.erase(undecoded.begin(), undecoded.begin() + (head.getPosition() - undecoded.data()));
+      started = true;
+
+      if (encoding == UTF8) {
+	buffer.append(undecoded.data(), undecoded.size());
+	undecoded.clear();
+	return;
+      }
+    }
+    else if (encoding == UTF8) {
+      buffer.append(bytes, length);
+      return;
+    }
+    else {
+      undecoded.insert(undecoded.end(), bytes, bytes + length);
+    }
+
+    if (decodeFailed)
+      return;
+
+    std::vector<char> decoded(undecoded.size() * 3 / 2);
+    char* out = decoded.data();
+    size_t used = transcodeUtf16(reinterpret_cast<const unsigned char*>(undecoded.data()), undecoded.size(),
+	encoding == UTF16BE, closed, out, decodeFailed);
+
+    buffer.append(decoded.data(), out - decoded.data());
+    undecoded.erase(undecoded.begin(), undecoded.begin() + used);
+  }
+
+  /**
+   * Function which tells whether the next token can be read without running out of input. That is the case once the next
+   * text is followed by a '<', or the next tag, comment or CDATA section is followed by its end, and always for the end
+   * tag of a self closing element, which the tokenizer already has.
+   *
+   *@return true if the tokenizer can read the next token.
+   */
+  bool AsyncParser::tokenReady() const
+  {
+    if (closed || tokenizer.hasPendingEndTag())
+      return true;
+
+    const char* p = buffer.current();
+    size_t n = buffer.available();
+    if (n == 0)
+      return false;
+
+    if (*p != '<')
+      return memchr(p, '<', n) != nullptr;
+
+    static const char comment[] = "<!--";
+    static const char cdata[] = "<![CDATA[";
+    const char* end = p + n;
+
+    if (memcmp(p, comment, std::min(n, sizeof(comment) - 1)) == 0) {
+      if (n < sizeof(comment) - 1)
+	return false;
+      return std::search(p + 4, end, "-->", "-->" + 3) != end;
+    }
+
+    if (memcmp(p, cdata, std::min(n, sizeof(cdata) - 1)) == 0) {
+      if (n < sizeof(cdata) - 1)
+	return false;
+      return std::search(p + 9, end, "]]>", "]]>" + 3) != end;
+    }
+
+    /*a tag ends at the first '>' outside of an attribute value*/
+    char quote = 0;
+    for (const char* q = p + 1; q < end; ++q) {
+      if (quote) {
+	if (*q == quote)
+	  quote = 0;
+      }
+      else if (*q == '"' || *q == '\'')
+	quote = *q;
+      else if (*q == '>')
+	return true;
+    }
+    return false;
+  }
+
+  /**
+   * Function which resumes the coroutine waiting for a token, if the token is now complete. The coroutine runs on the
+   * caller's thread until it has to wait again or finishes.
+   */
+  void AsyncParser::resumeWaiting()
+  {
+    if (waiting && tokenReady()) {
+      std::coroutine_handle<> next = waiting;
+      waiting = nullptr;
+      next.resume();
+    }
+  }
+
+  /**
+   * Function which hands the next piece of input to the parser.
+   *
+   *@param bytes The bytes received.
+   *@param length The number of bytes.
+   */
+  void AsyncParser::feed(const char* bytes, size_t length)
+  {
+    if (closed)
+      throw XMLException("Input fed to a parser after it was closed");
+
+    append(bytes, length);
+    resumeWaiting();
+  }
+
+  /**
+   * Function which marks the end of the input. Whatever is still buffered is parsed now.
+   */
+  void AsyncParser::close()
+  {
+    closed = true;
+    append(nullptr, 0);
+    resumeWaiting();
+  }
+
+  /**
+   * Function which reads the next token, once the awaiter knows it is complete.
+   *
+   *@return The type of the token.
+   */
+  TokenType AsyncParser::TokenAwaiter::await_resume()
+  {
+    /*running out of input earlier only meant waiting for more of it*/
+    parser.input.clear();
+    TokenType type = parser.tokenizer.getToken();
+
+    /*the transcoding stopped at invalid UTF-16, which the tokenizer only saw as the end of the input*/
+    if (type == ENDOFFILE && parser.decodeFailed)
+      parser.tokenizer.setError(INVALID_UTF16, parser.tokenizer.getOffset());
+    return type;
+  }
+
+  /**
+   * Function which returns an awaitable for the next token. Awaiting it suspends the coroutine until the token is complete.
+   *
+   *@return The awaitable, which produces the type of the token.
+   */
+  AsyncParser::TokenAwaiter AsyncParser::nextToken()
+  {
+    return TokenAwaiter(*this);
+  }
+
+  /**
+   * Function which returns the tokenizer, to read the values of the last token.
+   *
+   *@return The tokenizer.
+   */
+  const XMLTokenizer& AsyncParser::getTokenizer() const
+  {
+    return tokenizer;
+  }
+
+  /**
+   * Coroutine which parses the input into a Document, suspending whenever it needs more input than has been fed.
+   *
+   *@return A task producing a unique_ptr to the Document.
+   */
+  Task<std::unique_ptr<Document>> AsyncParser::parse()
+  {
+    DocumentSink sink;
+    TreeBuilder builder(sink);
+
+    while (builder.addToken(co_await nextToken(), tokenizer)) {
+    }
+
+    co_return sink.release();
+  }
+
+}
+
+#endif
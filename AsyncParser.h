@@ -0,0 +1,209 @@
+#ifndef __ASYNCPARSER_H__
+#define __ASYNCPARSER_H__
+
+/*Coroutine interface to the tokenizer and parser. Needs a compiler
+  with C++20 coroutines; with older standards this header is empty.*/
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <streambuf>
+#include <istream>
+#include <vector>
+#include <utility>
+#include "XMLTokenizer.h"
+#include "XMLException.h"
+
+namespace tinyXMLpp {
+
+  class Document;
+
+  /*Lazily pulls tokens out of a tokenizer:
+      for (TokenType type : tokens(t)) { ... t.getTagName() ... }
+    The values of each token are read from the tokenizer as usual.
+    The last token produced is ENDOFFILE.*/
+  class TokenGenerator {
+
+    public:
+    struct promise_type {
+      TokenType current;
+      std::exception_ptr error;
+
+      TokenGenerator get_return_object() { return TokenGenerator(std::coroutine_handle<promise_type>::from_promise(*this)); }
+      std::suspend_always initial_suspend() noexcept { return {}; }
+      std::suspend_always final_suspend() noexcept { return {}; }
+      std::suspend_always yield_value(TokenType type) noexcept { current = type; return {}; }
+      void return_void() noexcept {}
+      void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    class iterator {
+      std::coroutine_handle<promise_type> handle;
+
+      public:
+      explicit iterator(std::coroutine_handle<promise_type> handle = nullptr) : handle(handle) {}
+      TokenType operator*() const { return handle.promise().current; }
+      iterator& operator++() { resume(handle); if (handle.done()) handle = nullptr; return *this; }
+      bool operator==(const iterator& other) const { return handle == other.handle; }
+      bool operator!=(const iterator& other) const { return handle != other.handle; }
+    };
+
+    private:
+    std::coroutine_handle<promise_type> handle;
+
+    explicit TokenGenerator(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+    static void resume(std::coroutine_handle<promise_type> handle) {
+      handle.resume();
+      if (handle.promise().error)
+	std::rethrow_exception(handle.promise().error);
+    }
+
+    public:
+    TokenGenerator(TokenGenerator&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    TokenGenerator(const TokenGenerator&) = delete;
+    TokenGenerator& operator=(const TokenGenerator&) = delete;
+    ~TokenGenerator() { if (handle) handle.destroy(); }
+
+    iterator begin() {
+      resume(handle);
+      return handle.done() ? iterator() : iterator(handle);
+    }
+    iterator end() { return iterator(); }
+  };
+
+  TokenGenerator tokens(XMLTokenizer& t);
+
+  /*Result of a coroutine, which other coroutines can co_await. The
+    coroutine starts right away and runs until it first has to wait.
+    Code outside coroutines can poll isReady and then call get.*/
+  template<typename T>
+  class Task {
+
+    public:
+    struct promise_type {
+      std::unique_ptr<T> value;
+      std::exception_ptr error;
+      std::coroutine_handle<> continuation;
+
+      struct FinalAwaiter {
+	bool await_ready() noexcept { return false; }
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+	  std::coroutine_handle<> next = h.promise().continuation;
+	  return next ? next : std::noop_coroutine();
+	}
+	void await_resume() noexcept {}
+      };
+
+      Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+      std::suspend_never initial_suspend() noexcept { return {}; }
+      FinalAwaiter final_suspend() noexcept { return {}; }
+      void return_value(T result) { value.reset(new T(std::move(result))); }
+      void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    private:
+    std::coroutine_handle<promise_type> handle;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+    public:
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() { if (handle) handle.destroy(); }
+
+    bool isReady() const { return handle.done(); }
+
+    /*Returns the result, or rethrows what the coroutine threw*/
+    T get() {
+      if (!handle.done())
+	throw XMLException("Task result requested before the task finished");
+      if (handle.promise().error)
+	std::rethrow_exception(handle.promise().error);
+      return std::move(*handle.promise().value);
+    }
+
+    bool await_ready() const noexcept { return handle.done(); }
+    void await_suspend(std::coroutine_handle<> awaiting) noexcept { handle.promise().continuation = awaiting; }
+    T await_resume() { return get(); }
+  };
+
+  /*Stream buffer holding the bytes received so far. Reading past them
+    reports EOF, which is only final once the input was closed.*/
+  class FeedInputBuffer : public std::streambuf {
+
+    std::vector<char> data;
+
+    public:
+    void append(const char* bytes, size_t length);
+    const char* current() const { return gptr(); }
+    size_t available() const { return egptr() - gptr(); }
+  };
+
+  /*Parses documents that arrive in pieces, without blocking. Input is
+    handed over with feed as it is received, and close marks its end.
+    Whenever the next token is not complete yet, the coroutines waiting
+    on the parser suspend, and feed resumes them once it is.
+
+      AsyncParser parser;
+      Task<std::unique_ptr<Document>> task = parser.parse();
+      ... parser.feed(bytes, n) as data comes in ...
+      parser.close();
+      std::unique_ptr<Document> doc = co_await task;	//or task.get()
+
+    A single thread can drive any number of parsers this way. The
+    parser must outlive its tasks.*/
+  class AsyncParser {
+
+    FeedInputBuffer buffer;
+    std::istream input;
+    XMLTokenizer tokenizer;
+    std::coroutine_handle<> waiting;
+    bool closed;
+    bool started;			//the byte order mark has been read
+    Encoding encoding;
+    std::vector<char> undecoded;	//UTF-16 not transcoded yet
+    bool decodeFailed;
+
+    void append(const char* bytes, size_t length);
+    bool tokenReady() const;
+    void resumeWaiting();
+
+    public:
+    AsyncParser();
+    AsyncParser(const AsyncParser&) = delete;
+    AsyncParser& operator=(const AsyncParser&) = delete;
+
+    /*Hands over the next piece of input. Like the other parsers it
+      reads a byte order mark and transcodes UTF-16 input.*/
+    void feed(const char* bytes, size_t length);
+
+    /*Marks the end of the input*/
+    void close();
+
+    /*Waits until the next token is complete and reads it*/
+    class TokenAwaiter {
+      AsyncParser& parser;
+
+      public:
+      TokenAwaiter(AsyncParser& parser) : parser(parser) {}
+      bool await_ready() const { return parser.tokenReady(); }
+      void await_suspend(std::coroutine_handle<> awaiting) { parser.waiting = awaiting; }
+      TokenType await_resume();
+    };
+    TokenAwaiter nextToken();
+
+    /*The tokenizer holding the values of the last token*/
+    const XMLTokenizer& getTokenizer() const;
+
+    /*Parses the whole input into a Document*/
+    Task<std::unique_ptr<Document>> parse();
+  };
+
+}
+
+#endif
+
+#endif
@@ -1,4 +1,5 @@
 #include "Attribute.h"
+#include "Namespace.h"
 
 namespace tinyXMLpp {
   /**
@@ -7,7 +8,9 @@ namespace tinyXMLpp {
    *@param name 'name' in the name-value pair
    */
   void Attribute::setName (std::string name) {
-    this->name = name;
+    this->name = std::move(name);
+    if (this->owner != nullptr)
+      this->owner->markDirty();
   }
 
   /**
@@ -16,23 +19,58 @@ namespace tinyXMLpp {
    *@param value 'value' in the name-value pair
    */
   void Attribute::setValue (std::string value) {
-    this->value = value;
+    this->value = std::move(value);
+    if (this->owner != nullptr)
+      this->owner->markDirty();
   }
 
   /**
    *Gets the 'name' of the name-value pair of an Attribute
    */
-  std::string Attribute::getName () {
+  const std::string& Attribute::getName () const {
     return this->name;
   }
 
   /**
    *Gets the 'value' of the name-value pair of an Attribute
    */
-  std::string Attribute::getValue () {
+  const std::string& Attribute::getValue () const {
     return this->value;
   }
 
+  /**
+   *Gets the id of the namespace the Attribute is in
+   */
+  uint32_t Attribute::getNamespaceId () const {
+    return this->namespaceId;
+  }
+
+  /**
+   *Gets the URI of the namespace the Attribute is in, empty if it is in none
+   */
+  const std::string& Attribute::getNamespaceURI () const {
+    return NamespaceTable::getURI(this->namespaceId);
+  }
+
+  /**
+   *Sets the namespace of the Attribute, taking a reference of its own to it
+   *
+   *@param id A namespace id from NamespaceTable, which the caller holds a reference to
+   */
+  void Attribute::setNamespaceId (uint32_t id) {
+    NamespaceTable::retain(id);
+    NamespaceTable::release(this->namespaceId);
+    this->namespaceId = id;
+  }
+
+  /**
+   *Gets the name of the Attribute without its prefix
+   */
+  std::string Attribute::getLocalName () const {
+    size_t colon = this->name.find(':');
+    return colon == std::string::npos ? this->name : this->name.substr(colon + 1);
+  }
+
   /**
    *Constructor that takes in name and value as parameters
    *
@@ -42,5 +80,52 @@ namespace tinyXMLpp {
   Attribute::Attribute (const std::string& name, const std::string& value) {
     this->name = name;
     this->value = value;
+    this->owner = nullptr;
+    this->namespaceId = NamespaceTable::NO_NAMESPACE;
+  }
+
+  /**
+   *Constructor that takes over the buffers of name and value instead of copying them
+   *
+   *@param name 'name' in the name-value pair
+   *@param value 'value' in the name-value pair
+   */
+  Attribute::Attribute (std::string&& name, std::string&& value) {
+    this->name = std::move(name);
+    this->value = std::move(value);
+    this->owner = nullptr;
+    this->namespaceId = NamespaceTable::NO_NAMESPACE;
+  }
+
+  /**
+   *Copy constructor. The copy belongs to no element and holds a reference of its own to the namespace.
+   *
+   *@param other The Attribute to copy
+   */
+  Attribute::Attribute (const Attribute& other) {
+    this->name = other.name;
+    this->value = other.value;
+    this->owner = nullptr;
+    this->namespaceId = other.namespaceId;
+    NamespaceTable::retain(this->namespaceId);
+  }
+
+  /**
+   *Copies the name, value and namespace of another Attribute
+   *
+   *@param other The Attribute to copy
+   */
+  Attribute& Attribute::operator= (const Attribute& other) {
+    setName(other.name);
+    setValue(other.value);
+    setNamespaceId(other.namespaceId);
+    return *this;
+  }
+
+  /**
+   *Destructor
+   */
+  Attribute::~Attribute () {
+    NamespaceTable::release(this->namespaceId);
   }
 }
@@ -2,6 +2,7 @@
 #define __ATTRB_H__
 
 #include <string>
+#include <cstdint>
 #include "Node.h"
 
 namespace tinyXMLpp{
@@ -10,12 +11,26 @@ namespace tinyXMLpp{
   {
     std::string name;
     std::string value;
+    Node* owner;		//element holding the attribute, marked dirty on changes
+    uint32_t namespaceId;
+    friend class ElementNode;
     public:
     Attribute(const std::string& name, const std::string& value);
-    std::string getName();
-    std::string getValue();
+    Attribute(std::string&& name, std::string&& value);
+    Attribute(const Attribute& other);
+    Attribute& operator=(const Attribute& other);
+    ~Attribute();
+    const std::string& getName() const;
+    const std::string& getValue() const;
     void setName(std::string);
     void setValue(std::string);
+
+    /*Namespace of the attribute, set by the parser when it resolves
+      prefixes. The name keeps its prefix; getLocalName drops it.*/
+    uint32_t getNamespaceId() const;
+    const std::string& getNamespaceURI() const;
+    void setNamespaceId(uint32_t id);
+    std::string getLocalName() const;
   };
 
 }
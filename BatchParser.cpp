@@ -0,0 +1,169 @@
+#include "BatchParser.h"
+#include "Parser.h"
+#include "XMLException.h"
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+
+namespace tinyXMLpp {
+
+  /**
+   * Constructor
+   *
+   *@param threadCount The number of worker threads. 0 picks one thread per hardware core.
+   */
+  BatchParser::BatchParser(int threadCount)
+  {
+    if (threadCount <= 0)
+      threadCount = std::thread::hardware_concurrency();
+    this->threadCount = threadCount > 0 ? threadCount : 1;
+  }
+
+  /**
+   * Function which returns the number of worker threads used for a batch.
+   *
+   *@return The number of worker threads.
+   */
+  int BatchParser::getThreadCount() const
+  {
+    return this->threadCount;
+  }
+
+  /**
+   * Function which runs a batch on the worker threads. Inputs are handed out one at a time through a shared counter so that
+   * a few large inputs do not leave the other threads idle. Each thread keeps a single Parser for all the inputs it takes.
+   * An exception thrown by onComplete stops the batch: no more inputs are handed out, every thread is joined, and the first
+   * such exception is rethrown on the calling thread.
+   *
+   *@param count The number of inputs in the batch.
+   *@param parseOne Function which parses the input at the given index into the result.
+   *@param onComplete Function called with each finished result.
+   */
+  void BatchParser::run(size_t count, const std::function<void(Parser&, size_t, ParseResult&)>& parseOne,
+      const std::function<void(size_t, ParseResult&)>& onComplete)
+  {
+    std::atomic<size_t> next(0);
+    std::mutex failureLock;
+    std::exception_ptr failure;
+
+    auto worker = [&]() {
+      Parser parser;
+      size_t index;
+      while ((index = next.fetch_add(1)) < count) {
+	ParseResult result;
+	try {
+	  parseOne(parser, index, result);
+	}
+	catch (std::exception& e) {
+	  result.document.reset();
+	  result.error = e.what();
+	}
+	catch (...) {
+	  result.document.reset();
+	  result.error = "unknown exception";
+	}
+	try {
+	  onComplete(index, result);
+	}
+	catch (...) {
+	  std::lock_guard<std::mutex> guard(failureLock);
+	  if (!failure)
+	    failure = std::current_exception();
+	  next.store(count);
+	}
+      }
+    };
+
+    size_t workers = (size_t)this->threadCount < count ? this->threadCount : count;
+    std::vector<std::thread> threads;
+    try {
+      threads.reserve(workers);
+      for (size_t i = 1; i < workers; ++i) {
+	threads.push_back(std::thread(worker));
+      }
+    }
+    catch (...) {
+      /*a thread could not be started, stop the ones running before giving up*/
+      next.store(count);
+      for (size_t i = 0; i < threads.size(); ++i) {
+	threads[i].join();
+      }
+      throw;
+    }
+
+    /*The calling thread works on the batch as well*/
+    if (workers > 0)
+      worker();
+
+    for (size_t i = 0; i < threads.size(); ++i) {
+      threads[i].join();
+    }
+
+    if (failure)
+      std::rethrow_exception(failure);
+  }
+
+  /**
+   * Function which parses a list of XML files concurrently and hands each result to a callback as soon as it is ready.
+   *
+   *@param paths The paths to the input XML files.
+   *@param onComplete Function called from the worker threads with the index of each input and its result.
+   */
+  void BatchParser::parseFiles(const std::vector<std::string>& paths, const std::function<void(size_t, ParseResult&)>& onComplete)
+  {
+    run(paths.size(), [&](Parser& parser, size_t index, ParseResult& result) {
+	result.document = parser.parse(paths[index]);
+	}, onComplete);
+  }
+
+  /**
+   * Function which parses a list of in-memory XML documents concurrently and hands each result to a callback as soon as it
+   * is ready. The buffers are read in place, and malformed ones are reported without throwing.
+   *
+   *@param buffers The XML documents.
+   *@param onComplete Function called from the worker threads with the index of each input and its result.
+   */
+  void BatchParser::parseBuffers(const std::vector<std::string>& buffers, const std::function<void(size_t, ParseResult&)>& onComplete)
+  {
+    run(buffers.size(), [&](Parser& parser, size_t index, ParseResult& result) {
+	Expected<Document> parsed = parser.tryParse(buffers[index].data(), buffers[index].size());
+	if (parsed)
+	  result.document = parsed.release();
+	else
+	  result.error = describeError(parsed.getError());
+	}, onComplete);
+  }
+
+  /**
+   * Function which parses a list of XML files concurrently.
+   *
+   *@param paths The paths to the input XML files.
+   *@return The results, in the same order as paths.
+   */
+  std::vector<ParseResult> BatchParser::parseFiles(const std::vector<std::string>& paths)
+  {
+    std::vector<ParseResult> results(paths.size());
+    parseFiles(paths, [&](size_t index, ParseResult& result) {
+	results[index] = std::move(result);
+	});
+    return results;
+  }
+
+  /**
+   * Function which parses a list of in-memory XML documents concurrently.
+   *
+   *@param buffers The XML documents.
+   *@return The results, in the same order as buffers.
+   */
+  std::vector<ParseResult> BatchParser::parseBuffers(const std::vector<std::string>& buffers)
+  {
+    std::vector<ParseResult> results(buffers.size());
+    parseBuffers(buffers, [&](size_t index, ParseResult& result) {
+	results[index] = std::move(result);
+	});
+    return results;
+  }
+
+}
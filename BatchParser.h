@@ -0,0 +1,48 @@
+#ifndef __BATCHPARSER_H__
+#define __BATCHPARSER_H__
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include "Document.h"
+
+namespace tinyXMLpp {
+
+  /*Outcome of parsing one input of a batch. Exactly one of
+    document and error is set.*/
+  struct ParseResult {
+    std::unique_ptr<Document> document;
+    std::string error;
+
+    bool succeeded() const { return document != nullptr; }
+  };
+
+  class BatchParser {
+
+    int threadCount;
+
+    void run(size_t count, const std::function<void(Parser&, size_t, ParseResult&)>& parseOne,
+	const std::function<void(size_t, ParseResult&)>& onComplete);
+
+    public:
+    /*A thread count of 0 uses one thread per hardware core*/
+    BatchParser(int threadCount = 0);
+
+    int getThreadCount() const;
+
+    /*Parse many inputs concurrently, returning the results in input order*/
+    std::vector<ParseResult> parseFiles(const std::vector<std::string>& paths);
+    std::vector<ParseResult> parseBuffers(const std::vector<std::string>& buffers);
+
+    /*Parse many inputs concurrently, handing each result to onComplete as soon as it is ready.
+      onComplete is called from the worker threads, with the index of the input.
+      If it throws, the batch stops and the exception is rethrown once
+      every thread is done.*/
+    void parseFiles(const std::vector<std::string>& paths, const std::function<void(size_t, ParseResult&)>& onComplete);
+    void parseBuffers(const std::vector<std::string>& buffers, const std::function<void(size_t, ParseResult&)>& onComplete);
+  };
+
+}
+
+#endif
@@ -0,0 +1,131 @@
+#include "Binding.h"
+
+#include <cstdlib>
+#include <cerrno>
+#include <cctype>
+
+namespace tinyXMLpp {
+
+  namespace {
+
+    /*Skips the whitespace around a value, so "\n  42\n" reads as 42*/
+    const char* trimmedStart(const std::string& text)
+    {
+      const char* p = text.c_str();
+      while (isspace((unsigned char)*p))
+	++p;
+      return p;
+    }
+
+    void checkConverted(const std::string& text, const char* start, const char* end)
+    {
+      while (isspace((unsigned char)*end))
+	++end;
+      if (end == start || *end != '\0' || errno == ERANGE)
+	throw XMLException("Cannot convert '" + text + "' to the type of the bound member");
+    }
+
+    template<typename I>
+    void convertSigned(const std::string& text, I& out)
+    {
+      const char* start = trimmedStart(text);
+      char* end;
+      errno = 0;
+      long long value = strtoll(start, &end, 10);
+      checkConverted(text, start, end);
+      out = (I)value;
+      if (out != value)
+	throw XMLException("Value '" + text + "' is out of range for the bound member");
+    }
+
+    template<typename U>
+    void convertUnsigned(const std::string& text, U& out)
+    {
+      const char* start = trimmedStart(text);
+      if (*start == '-')
+	throw XMLException("Cannot convert '" + text + "' to an unsigned member");
+      char* end;
+      errno = 0;
+      unsigned long long value = strtoull(start, &end, 10);
+      checkConverted(text, start, end);
+      out = (U)value;
+      if (out != value)
+	throw XMLException("Value '" + text + "' is out of range for the bound member");
+    }
+
+  }
+
+  /**
+   * Function which stores the text as it is.
+   *
+   *@param text The text of the attribute or element.
+   *@param out The member to be set.
+   */
+  void convertValue(const std::string& text, std::string& out)
+  {
+    out = text;
+  }
+
+  /**
+   * Functions which read the text as a decimal integer. Throw XMLException if the text is not a number or does not fit.
+   *
+   *@param text The text of the attribute or element.
+   *@param out The member to be set.
+   */
+  void convertValue(const std::string& text, int& out) { convertSigned(text, out); }
+  void convertValue(const std::string& text, long& out) { convertSigned(text, out); }
+  void convertValue(const std::string& text, long long& out) { convertSigned(text, out); }
+  void convertValue(const std::string& text, unsigned int& out) { convertUnsigned(text, out); }
+  void convertValue(const std::string& text, unsigned long& out) { convertUnsigned(text, out); }
+  void convertValue(const std::string& text, unsigned long long& out) { convertUnsigned(text, out); }
+
+  /**
+   * Functions which read the text as a floating point number. Throw XMLException if the text is not a number.
+   *
+   *@param text The text of the attribute or element.
+   *@param out The member to be set.
+   */
+  void convertValue(const std::string& text, float& out)
+  {
+    double value;
+    convertValue(text, value);
+    out = (float)value;
+  }
+
+  void convertValue(const std::string& text, double& out)
+  {
+    const char* start = trimmedStart(text);
+    char* end;
+    errno = 0;
+    out = strtod(start, &end);
+    checkConverted(text, start, end);
+  }
+
+  /**
+   * Function which reads the text as a bool. "true" and "1" are true, "false" and "0" are false. Only whitespace may come
+   * before or after the word.
+   *
+   *@param text The text of the attribute or element.
+   *@param out The member to be set.
+   */
+  void convertValue(const std::string& text, bool& out)
+  {
+    const char* start = trimmedStart(text);
+    const char* end = start;
+    while (*end != '\0' && !isspace((unsigned char)*end))
+      ++end;
+    std::string word(start, end);
+    while (isspace((unsigned char)*end))
+      ++end;
+
+    if (*end != '\0')
+      throw XMLException("Cannot convert '" + text + "' to a bool");
+    if (word == "true" || word == "1")
+      out = true;
+    else if (word == "false" || word == "0")
+      out = false;
+    else
+      throw XMLException("Cannot convert '" + text + "' to a bool");
+  }
+
+}
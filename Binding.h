@@ -0,0 +1,235 @@
+#ifndef __BINDING_H__
+#define __BINDING_H__
+
+#include <string>
+#include <tuple>
+#include <cstring>
+#include <istream>
+#include "XMLTokenizer.h"
+#include "XMLException.h"
+#include "Encoding.h"
+
+namespace tinyXMLpp {
+
+  /*Conversions from XML text into the types of bound members. Other
+    types can be bound by declaring a convertValue overload next to
+    the type, where argument dependent lookup will find it.*/
+  void convertValue(const std::string& text, std::string& out);
+  void convertValue(const std::string& text, int& out);
+  void convertValue(const std::string& text, long& out);
+  void convertValue(const std::string& text, long long& out);
+  void convertValue(const std::string& text, unsigned int& out);
+  void convertValue(const std::string& text, unsigned long& out);
+  void convertValue(const std::string& text, unsigned long long& out);
+  void convertValue(const std::string& text, float& out);
+  void convertValue(const std::string& text, double& out);
+  void convertValue(const std::string& text, bool& out);
+
+  /*Maps an attribute of the record element, or the text of one of its
+    child elements, to a member of T*/
+  template<typename T, typename M>
+  struct FieldBinding {
+    const char* name;
+    M T::* member;
+    bool isAttribute;
+  };
+
+  template<typename T, typename M>
+  FieldBinding<T, M> bindAttribute(const char* name, M T::* member)
+  {
+    FieldBinding<T, M> field = { name, member, true };
+    return field;
+  }
+
+  template<typename T, typename M>
+  FieldBinding<T, M> bindElement(const char* name, M T::* member)
+  {
+    FieldBinding<T, M> field = { name, member, false };
+    return field;
+  }
+
+  /*Walks a tuple of FieldBindings at compile time. find returns the
+    index of the field with the given name and kind, or -1, and set
+    stores a value into the field at an index found that way.*/
+  template<size_t I, size_t N>
+  struct FieldTable {
+
+    template<typename Fields>
+    static int find(const Fields& fields, const std::string& name, bool isAttribute)
+    {
+      if (std::get<I>(fields).isAttribute == isAttribute && strcmp(std::get<I>(fields).name, name.c_str()) == 0)
+	return I;
+      return FieldTable<I + 1, N>::find(fields, name, isAttribute);
+    }
+
+    template<typename T, typename Fields>
+    static void set(const Fields& fields, int index, T& record, const std::string& text)
+    {
+      if (index == (int)I)
+	convertValue(text, record.*(std::get<I>(fields).member));
+      else
+	FieldTable<I + 1, N>::set(fields, index, record, text);
+    }
+  };
+
+  template<size_t N>
+  struct FieldTable<N, N> {
+
+    template<typename Fields>
+    static int find(const Fields&, const std::string&, bool)
+    {
+      return -1;
+    }
+
+    template<typename T, typename Fields>
+    static void set(const Fields&, int, T&, const std::string&)
+    {
+    }
+  };
+
+  /*Reads every element named recordName straight into a T, without
+    building a DOM. Attributes of the record element and the text of
+    its direct child elements are stored in the bound members, and
+    everything else inside the record is skipped unread.
+
+    Binding<T, ...> is made with makeBinding:
+      auto binding = makeBinding<Book>("book",
+	  bindAttribute("id", &Book::id),
+	  bindElement("title", &Book::title),
+	  bindElement("price", &Book::price));
+      binding.read(is, [](const Book& b) { ... });*/
+  template<typename T, typename... Fields>
+  class Binding {
+
+    typedef std::tuple<Fields...> FieldTuple;
+    typedef FieldTable<0, sizeof...(Fields)> Table;
+
+    std::string recordName;
+    FieldTuple fields;
+    std::string value;
+
+    void readElementText(XMLTokenizer& t);
+
+    public:
+    Binding(const std::string& recordName, Fields... fields) : recordName(recordName), fields(fields...) {}
+
+    /*Calls onRecord with each record found, returning the number of records*/
+    template<typename Callback>
+    size_t read(XMLTokenizer& t, Callback onRecord);
+
+    template<typename Callback>
+    size_t read(std::istream& is, Callback onRecord);
+  };
+
+  template<typename T, typename... Fields>
+  Binding<T, Fields...> makeBinding(const std::string& recordName, Fields... fields)
+  {
+    return Binding<T, Fields...>(recordName, fields...);
+  }
+
+  /**
+   * Function which collects the text of the element whose start tag was just read, up to its end tag. Nested elements
+   * are skipped without being tokenized.
+   *
+   *@param t The tokenizer, positioned right after the start tag.
+   */
+  template<typename T, typename... Fields>
+  void Binding<T, Fields...>::readElementText(XMLTokenizer& t)
+  {
+    value.clear();
+    while (true) {
+      switch (t.getToken()) {
+	case START_TAG:
+	  t.skipElement();
+	  break;
+	case END_TAG:
+	  return;
+	case TEXT:
+	  value += t.getText();
+	  break;
+	case CDATA:
+	  value += t.getCDATA();
+	  break;
+	case ENDOFFILE:
+	  throw XMLException("Unexpected EOF while reading the value of a bound element");
+	default:
+	  break;
+      }
+    }
+  }
+
+  /**
+   * Function which reads the records from a tokenizer and hands each one to a callback.
+   *
+   *@param t The tokenizer to read from.
+   *@param onRecord Function called with each record, as a const T&.
+   *@return The number of records read.
+   */
+  template<typename T, typename... Fields>
+  template<typename Callback>
+  size_t Binding<T, Fields...>::read(XMLTokenizer& t, Callback onRecord)
+  {
+    size_t count = 0;
+    TokenType type;
+
+    while ((type = t.getToken()) != ENDOFFILE) {
+
+      if (type != START_TAG || t.getTagName() != recordName)
+	continue;
+
+      T record = T();
+      for (int i = 0; i < t.getAttributeCount(); ++i) {
+	int field = Table::find(fields, t.getAttributeName(i), true);
+	if (field >= 0)
+	  Table::set(fields, field, record, t.getAttributeValue(i));
+      }
+
+      bool inRecord = true;
+      while (inRecord) {
+	switch (t.getToken()) {
+	  case START_TAG: {
+	    int field = Table::find(fields, t.getTagName(), false);
+	    if (field >= 0) {
+	      readElementText(t);
+	      Table::set(fields, field, record, value);
+	    }
+	    else
+	      t.skipElement();
+	    break;
+	  }
+	  case END_TAG:
+	    inRecord = false;
+	    break;
+	  case ENDOFFILE:
+	    throw XMLException("Unexpected EOF inside " + recordName + " record");
+	  default:
+	    break;
+	}
+      }
+
+      onRecord(static_cast<const T&>(record));
+      ++count;
+    }
+
+    return count;
+  }
+
+  /**
+   * Function which reads the records from an input stream and hands each one to a callback.
+   *
+   *@param is The input stream holding the XML.
+   *@param onRecord Function called with each record, as a const T&.
+   *@return The number of records read.
+   */
+  template<typename T, typename... Fields>
+  template<typename Callback>
+  size_t Binding<T, Fields...>::read(std::istream& is, Callback onRecord)
+  {
+    DecodedInput input(is);
+    XMLTokenizer t(input.get());
+    return read(t, onRecord);
+  }
+
+}
+
+#endif
@@ -1,15 +1,22 @@
 #include "CDATANode.h"
+#include "Hash.h"
 #include "XMLException.h"
 
 namespace tinyXMLpp {
+
+  namespace {
+    /*"CDAT", keeps the hashes of different node types apart*/
+    const uint64_t HASH_SEED = 0x43444154;
+  }
+
   /**
    *Constructor that takes the cdata section as its argument.
    *
    *@param cdata An entire 'cdata' section from the XML input, passed as text.
    */
-  CDATANode::CDATANode(const std::string &cdata) 
+  CDATANode::CDATANode(std::string cdata) 
   {
-    this->cdata = cdata;
+    this->cdata = std::move(cdata);
   }
 
   /**
@@ -22,6 +29,27 @@ namespace tinyXMLpp {
     return new CDATANode(cdata);
   }
 
+  /**
+   *Function to create a CDATANode, taking over the buffer of the section instead of copying it.
+   *
+   *@param cdata An entire 'cdata' section from the XML input, passed as text.
+   */
+  CDATANode* CDATANode::createCDATANode(std::string&& cdata)
+  {
+    return new CDATANode(std::move(cdata));
+  }
+
+  /**
+   *Function to create a CDATANode owned by a unique_ptr, to be handed to Node::addChildNode.
+   *
+   *@param cdata An entire 'cdata' section from the XML input, passed as text.
+   *@return A unique_ptr to the new CDATANode.
+   */
+  std::unique_ptr<CDATANode> CDATANode::makeCDATANode(std::string cdata)
+  {
+    return std::unique_ptr<CDATANode>(new CDATANode(std::move(cdata)));
+  }
+
   /**
    *Destructor
    */
@@ -76,11 +104,22 @@ namespace tinyXMLpp {
    *Function returns the value of CDATA within the node.
    *
    */
-  std::string CDATANode::getcdata() const
+  const std::string& CDATANode::getcdata() const
   {
     return this->cdata;
   }
 
+  /**
+   *Function to replace the content of the CDATA section.
+   *
+   *@param cdata The new content.
+   */
+  void CDATANode::setcdata(std::string cdata)
+  {
+    this->cdata = std::move(cdata);
+    markDirty();
+  }
+
   /**
    *Function to write the CDATANode as an XML CDATA section into the output stream.
    *
@@ -88,7 +127,38 @@ namespace tinyXMLpp {
    */
   void CDATANode::write(std::ostream& os) const
   {
-    os<< "<![CDATA[" + this->getcdata() + "]]>\n";
+    os<< "<![CDATA[" << this->cdata << "]]>\n";
+  }
+
+  /**
+   *Function to compute the hash of the CDATANode, which depends only on its CDATA.
+   *
+   *@return The hash of the CDATA.
+   */
+  uint64_t CDATANode::computeHash() const
+  {
+    return hashString(this->cdata, HASH_SEED);
+  }
+
+  /**
+   *Function to compare the CDATA of two nodes.
+   *
+   *@param other The node to compare with.
+   *@return true if other is a CDATANode with the same CDATA.
+   */
+  bool CDATANode::hasSameContent(const Node& other) const
+  {
+    const CDATANode* node = dynamic_cast<const CDATANode*>(&other);
+    return node != nullptr && node->cdata == this->cdata;
   }
 
+  /**
+   *Function to copy the node, for Node::clone.
+   *
+   *@return A new CDATANode with the same CDATA.
+   */
+  Node* CDATANode::cloneContent() const
+  {
+    return createCDATANode(this->cdata);
+  }
 }
@@ -9,11 +9,13 @@ namespace tinyXMLpp{
   class CDATANode : public Node {
     std::string cdata;
 
-    CDATANode(const std::string &cdata);
+    CDATANode(std::string cdata);
 
     public:
 
     static CDATANode* createCDATANode(const std::string& cdata);
+    static CDATANode* createCDATANode(std::string&& cdata);
+    static std::unique_ptr<CDATANode> makeCDATANode(std::string cdata);
 
     ~CDATANode();
 
@@ -25,9 +27,16 @@ namespace tinyXMLpp{
 
     void removeChildNode (int index);
 
-    std::string getcdata() const;
+    const std::string& getcdata() const;
+
+    void setcdata(std::string cdata);
 
     void write(std::ostream& os) const;
+
+    protected:
+    uint64_t computeHash() const;
+    bool hasSameContent(const Node& other) const;
+    Node* cloneContent() const;
   };
 
 }
@@ -1,8 +1,14 @@
 #include "CommentNode.h"
+#include "Hash.h"
 #include "XMLException.h"
 
 namespace tinyXMLpp {
 
+  namespace {
+    /*"COMM", keeps the hashes of different node types apart*/
+    const uint64_t HASH_SEED = 0x434F4D4D;
+  }
+
   /**
    *Function to create a CommentNode.
    *
@@ -24,6 +30,28 @@ namespace tinyXMLpp {
     return new CommentNode(content);
   }
 
+  /**
+   *Function to create a CommentNode, taking over the buffer of the content instead of copying it.
+   *
+   *@param content The value for the comment node's conent.
+   *@return a new CommentNode object.
+   */
+  CommentNode* CommentNode::createCommentNode(std::string&& content)
+  {
+    return new CommentNode(std::move(content));
+  }
+
+  /**
+   *Function to create a CommentNode owned by a unique_ptr, to be handed to Node::addChildNode.
+   *
+   *@param content The value for the comment node's conent.
+   *@return a unique_ptr to the new CommentNode.
+   */
+  std::unique_ptr<CommentNode> CommentNode::makeCommentNode(std::string content)
+  {
+    return std::unique_ptr<CommentNode>(new CommentNode(std::move(content)));
+  }
+
   /**
    *Default Constructor
    */
@@ -36,9 +64,9 @@ namespace tinyXMLpp {
    *
    *@param comment The value for the comment node's content.
    */
-  CommentNode::CommentNode(const std::string& comment) 
+  CommentNode::CommentNode(std::string comment) 
   {
-    this->content = comment;
+    this->content = std::move(comment);
   }
 
   /**
@@ -53,9 +81,10 @@ namespace tinyXMLpp {
    *
    *@param content The value for the comment node's conent.
    */
-  void CommentNode::setContent(const std::string& content) 
+  void CommentNode::setContent(std::string content) 
   {
-    this->content = content;
+    this->content = std::move(content);
+    markDirty();
   }
 
   /**
@@ -63,7 +92,7 @@ namespace tinyXMLpp {
    *
    *@return The comment node's content.
    */
-  std::string CommentNode::getContent() const 
+  const std::string& CommentNode::getContent() const 
   {
     return this->content;
   }
@@ -119,7 +148,38 @@ namespace tinyXMLpp {
    */
   void CommentNode::write(std::ostream& os) const
   {
-    os << "<!--" + this->getContent() + "-->";
+    os << "<!--" << this->content << "-->";
   }
 
+  /**
+   *Function to compute the hash of the CommentNode, which depends only on its comment.
+   *
+   *@return The hash of the comment.
+   */
+  uint64_t CommentNode::computeHash() const
+  {
+    return hashString(this->content, HASH_SEED);
+  }
+
+  /**
+   *Function to compare the comment of two nodes.
+   *
+   *@param other The node to compare with.
+   *@return true if other is a CommentNode with the same comment.
+   */
+  bool CommentNode::hasSameContent(const Node& other) const
+  {
+    const CommentNode* node = dynamic_cast<const CommentNode*>(&other);
+    return node != nullptr && node->content == this->content;
+  }
+
+  /**
+   *Function to copy the node, for Node::clone.
+   *
+   *@return A new CommentNode with the same comment.
+   */
+  Node* CommentNode::cloneContent() const
+  {
+    return createCommentNode(this->content);
+  }
 }
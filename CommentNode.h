@@ -10,7 +10,7 @@ namespace tinyXMLpp{
     std::string content;
 
     CommentNode();
-    CommentNode(const std::string& content);
+    CommentNode(std::string content);
 
     public:
     ~CommentNode();
@@ -19,10 +19,14 @@ namespace tinyXMLpp{
 
     static CommentNode* createCommentNode(const std::string& content);
 
+    static CommentNode* createCommentNode(std::string&& content);
+
+    static std::unique_ptr<CommentNode> makeCommentNode(std::string content);
+
     /*Methods to get and set content*/
-    void setContent(const std::string& content);
+    void setContent(std::string content);
 
-    std::string getContent() const;
+    const std::string& getContent() const;
 
     void addChildNode (Node* child);
 
@@ -33,6 +37,11 @@ namespace tinyXMLpp{
     void removeChildNode (int index);
 
     void write(std::ostream& os) const;
+
+    protected:
+    uint64_t computeHash() const;
+    bool hasSameContent(const Node& other) const;
+    Node* cloneContent() const;
   };
 
 }
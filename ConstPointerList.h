@@ -0,0 +1,65 @@
+#ifndef __CONSTPOINTERLIST_H__
+#define __CONSTPOINTERLIST_H__
+
+#include <vector>
+#include <iterator>
+#include <cstddef>
+
+namespace tinyXMLpp {
+
+  /*Read-only view of a list of pointers, such as the children of a
+    node, that hands out each element as a pointer to const. It is
+    what the const accessors of the tree return, so a const node only
+    ever leads to other const nodes. The view refers to the list, so
+    it must not outlive the node it came from.*/
+  template<class T>
+  class ConstPointerList {
+
+    const std::vector<T*>* items;
+
+    public:
+    class const_iterator {
+      typename std::vector<T*>::const_iterator it;
+
+      public:
+      typedef std::random_access_iterator_tag iterator_category;
+      typedef const T* value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef const T* const* pointer;
+      typedef const T* reference;
+
+      const_iterator() {}
+      explicit const_iterator(typename std::vector<T*>::const_iterator it) : it(it) {}
+
+      const T* operator*() const { return *it; }
+      const T* operator[](difference_type n) const { return it[n]; }
+      const_iterator& operator++() { ++it; return *this; }
+      const_iterator operator++(int) { return const_iterator(it++); }
+      const_iterator& operator--() { --it; return *this; }
+      const_iterator operator--(int) { return const_iterator(it--); }
+      const_iterator& operator+=(difference_type n) { it += n; return *this; }
+      const_iterator& operator-=(difference_type n) { it -= n; return *this; }
+      const_iterator operator+(difference_type n) const { return const_iterator(it + n); }
+      const_iterator operator-(difference_type n) const { return const_iterator(it - n); }
+      difference_type operator-(const const_iterator& other) const { return it - other.it; }
+      bool operator==(const const_iterator& other) const { return it == other.it; }
+      bool operator!=(const const_iterator& other) const { return it != other.it; }
+      bool operator<(const const_iterator& other) const { return it < other.it; }
+    };
+    typedef const_iterator iterator;
+
+    explicit ConstPointerList(const std::vector<T*>& items) : items(&items) {}
+
+    size_t size() const { return items->size(); }
+    bool empty() const { return items->empty(); }
+    const T* operator[](size_t index) const { return (*items)[index]; }
+    const T* front() const { return items->front(); }
+    const T* back() const { return items->back(); }
+
+    const_iterator begin() const { return const_iterator(items->begin()); }
+    const_iterator end() const { return const_iterator(items->end()); }
+  };
+
+}
+
+#endif
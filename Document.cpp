@@ -1,6 +1,11 @@
 #include "Document.h"
 #include "ElementNode.h"
-#include <regex>
+#include "Snapshot.h"
+#include "GzipStream.h"
+#include "FrozenDocument.h"
+#include "Namespace.h"
+#include "Hash.h"
+#include <cctype>
 
 namespace tinyXMLpp{
 
@@ -14,6 +19,16 @@ namespace tinyXMLpp{
     return this->rootElement;
   }
 
+  /**
+   * Function which returns the top level nodes of the document, including comments and whitespace around the root element.
+   *
+   *@return A vector of Node* containing the top level nodes.
+   */
+  const vector<Node*>& Document::getChildren() const
+  {
+    return this->childNodes;
+  }
+
   /**
    * Destructor.
    */
@@ -26,15 +41,17 @@ namespace tinyXMLpp{
   }
 
   /**
-   * Function which checks whether an input string contains only a combination of spaces, newlines and tabs. It uses regex to
-   * do this checking.
+   * Function which checks whether an input string contains only a combination of spaces, newlines and tabs.
    *
    *@param input The input string
    *@return A bool value which is true if the input string contains only spaces, newlines and tabs
    */
   bool Document::isEmptyText (const std::string& input) const {
-    regex rx("[\\r\\n\\t\\s]*");
-    return regex_match(input.begin(), input.end(), rx);
+    for (size_t i = 0; i < input.size(); ++i) {
+      if (!isspace((unsigned char)input[i]))
+	return false;
+    }
+    return true;
   }
 
   /**
@@ -107,6 +124,29 @@ namespace tinyXMLpp{
     childNodes.insert(childNodes.begin() + index, child);
   }
 
+  /**
+   * Function to add a child node to the Document object, taking over its ownership.
+   *
+   * @param child The node to be added as a child of the Document object.
+   */
+  void Document::addChildNode (std::unique_ptr<Node> child)
+  {
+    addChildNode(child.get());
+    child.release();
+  }
+
+  /**
+   * Function to add a child node to the Document object at a given index, taking over its ownership.
+   *
+   * @param child The node to be added as a child of the Document object.
+   * @param index The index at which 'child' should be added as a child of the Document object.
+   */
+  void Document::addChildNode (std::unique_ptr<Node> child, int index)
+  {
+    addChildNode(child.get(), index);
+    child.release();
+  }
+
   /**
    * Function to remove a node from the child nodes list of the Document object.
    *
@@ -164,13 +204,43 @@ namespace tinyXMLpp{
     if(!this->isRootSet)
       throw XMLException("XML Document does not have a root");
 
+    if (this->source.empty()) {
+      for(int i=0; i < childNodes.size(); ++i){
+	childNodes[i]->write( os );
+      }
+      return;
+    }
+
+    /*only the parts of the tree that changed since parsing are serialized again*/
     for(int i=0; i < childNodes.size(); ++i){
-      childNodes[i]->write( os );
+      childNodes[i]->writeIncremental( os, this->source );
     }
   }
 
   /**
-   * Function to write the Document node as an XML node into a file at the given path.
+   * Function to keep the text the document was parsed from. Parser sets it when source tracking is on, after giving each
+   * node the span it was read from.
+   *
+   * @param source The source text of the document.
+   */
+  void Document::setSource(std::string source)
+  {
+    this->source.swap(source);
+  }
+
+  /**
+   * Function which returns the text the document was parsed from.
+   *
+   * @return The source text, or an empty string if it was not kept.
+   */
+  const std::string& Document::getSource() const
+  {
+    return this->source;
+  }
+
+  /**
+   * Function to write the Document node as an XML node into a file at the given path. If the path ends in ".gz" the output
+   * is gzip compressed as it is written.
    *
    * @param path The path to the file to which the Document object should be written as an XML node.
    */
@@ -179,11 +249,42 @@ namespace tinyXMLpp{
     if(!this->isRootSet)
       throw XMLException("XML Document does not have a root");
 
-    std::ofstream file(path.c_str());		
-    write(file);
+    std::ofstream file(path.c_str(), std::ios::binary);		
+    if (path.size() > 3 && path.compare(path.size() - 3, 3, ".gz") == 0) {
+      GzipOutputBuffer buffer(file.rdbuf());
+      std::ostream os(&buffer);
+      write(os);
+      if (!buffer.finish())
+	throw XMLException("Error while writing compressed XML to " + path);
+    }
+    else
+      write(file);
     file.close();
   }
 
+  /**
+   * Function to save the Document as a binary snapshot at the given path. The snapshot can be loaded back with loadSnapshot
+   * without tokenizing the XML again.
+   *
+   * @param path The path to the snapshot file.
+   */
+  void Document::saveSnapshot(const std::string& path) const
+  {
+    Snapshot::save(*this, path);
+  }
+
+  /**
+   * Function to load a Document from a binary snapshot written by saveSnapshot. The file is mapped read-only and the tree is
+   * rebuilt directly from its node records.
+   *
+   * @param path The path to the snapshot file.
+   * @return A unique_ptr to the loaded Document.
+   */
+  std::unique_ptr<Document> Document::loadSnapshot(const std::string& path)
+  {
+    return Snapshot::load(path);
+  }
+
   /**
    * Recursive function called by the actual getElementById, that is exposed to the user.
    *
@@ -191,23 +292,23 @@ namespace tinyXMLpp{
    * @param id The string being searched for in the attribute values.
    * @return A pointer to the Node which has an attribute value that matches id
    */
-  Node* Document::getElementById (Node* node, const std::string& id) {
+  const Node* Document::getElementById (const Node* node, const std::string& id) const {
     if (node != nullptr) {
 
-      vector<Attribute*> attributes = static_cast<ElementNode*>(node)->getAttributes();
+      ConstPointerList<Attribute> attributes = static_cast<const ElementNode*>(node)->getAttributes();
       for (int i = 0; i < attributes.size(); ++i) {
-	Attribute* attrib = attributes[i];
+	const Attribute* attrib = attributes[i];
 	if (attrib->getValue() == id) {
 	  return node;
 	}
       }
 
-      vector<Node*> children = node->getChildren();
+      ConstPointerList<Node> children = node->getChildren();
       for (int i = 0; i < children.size(); ++i) {
-	if (dynamic_cast<ElementNode*>(children[i]) == NULL)
+	if (dynamic_cast<const ElementNode*>(children[i]) == NULL)
 	  continue;
-	Node* temp = getElementById(children[i], id);
-	if(!temp)
+	const Node* temp = getElementById(children[i], id);
+	if(temp)
 	  return temp;
       }
 
@@ -223,7 +324,17 @@ namespace tinyXMLpp{
    * @return A pointer to an ElementNode which contains an attribute that has the value = id
    */
   ElementNode* Document::getElementById (const std::string& id) {
-    return static_cast<ElementNode*>(getElementById(this->rootElement, id));
+    return const_cast<ElementNode*>(static_cast<const Document*>(this)->getElementById(id));
+  }
+
+  /**
+   * Const version of getElementById. It only reads the tree, so it can be called from many threads at once.
+   *
+   * @param id The string being searched for inside attribute values.
+   * @return A pointer to an ElementNode which contains an attribute that has the value = id
+   */
+  const ElementNode* Document::getElementById (const std::string& id) const {
+    return static_cast<const ElementNode*>(getElementById(this->rootElement, id));
   }
 
   /**
@@ -233,16 +344,16 @@ namespace tinyXMLpp{
    * @param tagName The tag name being searched for.
    * @param nodes A vector to hold the list of ElementNode that has a name matching 'tagName'
    */
-  void Document::getElementsByTagName (Node* node, const std::string& tagName, vector<ElementNode*>& nodes) {
+  void Document::getElementsByTagName (const Node* node, const std::string& tagName, vector<const ElementNode*>& nodes) const {
     if (node != nullptr) {
-      if (static_cast<ElementNode*>(node)->getName() == tagName) {
-	nodes.push_back(static_cast<ElementNode*>(node));
+      if (static_cast<const ElementNode*>(node)->getName() == tagName) {
+	nodes.push_back(static_cast<const ElementNode*>(node));
       }
-      vector<Node*> children = node->getChildren();
+      ConstPointerList<Node> children = node->getChildren();
       for (int i = 0; i < children.size(); ++i) {
-	if (dynamic_cast<ElementNode*>(children[i]) == NULL)
+	if (dynamic_cast<const ElementNode*>(children[i]) == NULL)
 	  continue;
-	getElementsByTagName(static_cast<ElementNode*>(children[i]), tagName, nodes);
+	getElementsByTagName(children[i], tagName, nodes);
       }
     }
     return;
@@ -255,9 +366,150 @@ namespace tinyXMLpp{
    * @return A vector of ElementNode* which points to all the element nodes that have a name equal to the value passed to the function
    */
   vector<ElementNode*> Document::getElementsByTagName (const std::string& tagName) {
+    vector<const ElementNode*> found = static_cast<const Document*>(this)->getElementsByTagName(tagName);
     vector<ElementNode*> outputNodes;
+    outputNodes.reserve(found.size());
+    for (int i = 0; i < found.size(); ++i) {
+      outputNodes.push_back(const_cast<ElementNode*>(found[i]));
+    }
+    return outputNodes;
+  }
+
+  /**
+   * Const version of getElementsByTagName. It only reads the tree, so it can be called from many threads at once.
+   * 
+   * @param tagName The name being searched for, in all the element nodes.
+   * @return A vector of const ElementNode* which points to all the element nodes that have a name equal to tagName
+   */
+  vector<const ElementNode*> Document::getElementsByTagName (const std::string& tagName) const {
+    vector<const ElementNode*> outputNodes;
     getElementsByTagName (this->rootElement, tagName, outputNodes);
     return outputNodes;
   }
 
+  /**
+   * Private, recursive function that gets called by getElementsByTagNameNS. The namespace was looked up by the caller, so each
+   * element is checked with an integer comparison before its local name is looked at.
+   * 
+   * @param node The current node at this level of recursion.
+   * @param namespaceId The id of the namespace being searched for.
+   * @param localName The local name being searched for.
+   * @param nodes A vector to hold the list of matching ElementNode
+   */
+  void Document::getElementsByTagNameNS (const Node* node, uint32_t namespaceId, const std::string& localName,
+      vector<const ElementNode*>& nodes) const {
+    if (node != nullptr) {
+      if (static_cast<const ElementNode*>(node)->hasName(namespaceId, localName)) {
+	nodes.push_back(static_cast<const ElementNode*>(node));
+      }
+      ConstPointerList<Node> children = node->getChildren();
+      for (int i = 0; i < children.size(); ++i) {
+	if (dynamic_cast<const ElementNode*>(children[i]) == NULL)
+	  continue;
+	getElementsByTagNameNS(children[i], namespaceId, localName, nodes);
+      }
+    }
+  }
+
+  /**
+   * Function used to get the elements in a namespace with a given local name, whatever prefix they were written with.
+   * 
+   * @param namespaceURI The namespace URI being searched for, empty for elements in no namespace.
+   * @param localName The name being searched for, without prefix.
+   * @return A vector of ElementNode* which points to all the matching element nodes
+   */
+  vector<ElementNode*> Document::getElementsByTagNameNS (const std::string& namespaceURI, const std::string& localName) {
+    vector<const ElementNode*> found = static_cast<const Document*>(this)->getElementsByTagNameNS(namespaceURI, localName);
+    vector<ElementNode*> outputNodes;
+    outputNodes.reserve(found.size());
+    for (int i = 0; i < found.size(); ++i) {
+      outputNodes.push_back(const_cast<ElementNode*>(found[i]));
+    }
+    return outputNodes;
+  }
+
+  /**
+   * Const version of getElementsByTagNameNS. It only reads the tree, so it can be called from many threads at once.
+   * 
+   * @param namespaceURI The namespace URI being searched for, empty for elements in no namespace.
+   * @param localName The name being searched for, without prefix.
+   * @return A vector of const ElementNode* which points to all the matching element nodes
+   */
+  vector<const ElementNode*> Document::getElementsByTagNameNS (const std::string& namespaceURI, const std::string& localName) const {
+    vector<const ElementNode*> outputNodes;
+    uint32_t id = NamespaceTable::find(namespaceURI);
+    if (id != NamespaceTable::INVALID_NAMESPACE)
+      getElementsByTagNameNS (this->rootElement, id, localName, outputNodes);
+    return outputNodes;
+  }
+
+  /**
+   * Function which returns the structural hash of the document, made of the hashes of its top level nodes. Node hashes are
+   * cached, so after the first call only the parts of the tree changed since then are hashed again.
+   *
+   * @return The hash of the document.
+   */
+  uint64_t Document::getHash() const
+  {
+    uint64_t hash = hashCombine(0, this->childNodes.size());
+    for (size_t i = 0; i < this->childNodes.size(); ++i) {
+      hash = hashCombine(hash, this->childNodes[i]->getHash());
+    }
+    return hash;
+  }
+
+  /**
+   * Function which checks whether two documents hold the same nodes. Documents whose hashes differ are told apart without
+   * looking at their nodes; otherwise only subtrees whose hashes match are descended into.
+   *
+   * @param other The document to compare with.
+   * @return true if both documents have the same nodes in the same order.
+   */
+  bool Document::equals(const Document& other) const
+  {
+    if (this == &other)
+      return true;
+    if (this->childNodes.size() != other.childNodes.size() || getHash() != other.getHash())
+      return false;
+
+    for (size_t i = 0; i < this->childNodes.size(); ++i) {
+      if (!this->childNodes[i]->equals(*other.childNodes[i]))
+	return false;
+    }
+    return true;
+  }
+
+  /**
+   * Function which turns the Document into an immutable FrozenDocument. The nodes are moved into the frozen document, and
+   * this Document is left empty. The frozen document only offers const access, so it can be shared between threads.
+   * Every node hash is computed here, so the frozen tree is never written to again.
+   *
+   * @return A shared_ptr to the FrozenDocument holding the tree.
+   */
+  std::shared_ptr<const FrozenDocument> Document::freeze()
+  {
+    std::unique_ptr<Document> frozen(new Document());
+    frozen->childNodes.swap(this->childNodes);
+    std::swap(frozen->rootElement, this->rootElement);
+    std::swap(frozen->isRootSet, this->isRootSet);
+    frozen->source.swap(this->source);
+    frozen->getHash();
+
+    return std::shared_ptr<const FrozenDocument>(new FrozenDocument(std::move(frozen)));
+  }
+
+  /**
+   * Function which copies the whole tree into a new Document. Node hashes computed so far are copied along.
+   *
+   * @return A unique_ptr to the copy.
+   */
+  std::unique_ptr<Document> Document::clone() const
+  {
+    std::unique_ptr<Document> copy(new Document());
+    for (size_t i = 0; i < this->childNodes.size(); ++i) {
+      copy->addChildNode(this->childNodes[i]->clone());
+    }
+    return copy;
+  }
+
 }
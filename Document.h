@@ -8,12 +8,13 @@
 #include "Attribute.h"
 #include "ElementNode.h"
 #include "CDATANode.h"
-#include <regex>
 
 using namespace std;
 
 namespace tinyXMLpp {
 
+  class FrozenDocument;
+
   class Document
   {	
     ElementNode* rootElement;
@@ -22,15 +23,20 @@ namespace tinyXMLpp {
 
     bool isRootSet;		//Keeps track of whether the root element was set or not. Root element should be set only once.	
 
+    std::string source;		//Text the document was parsed from, when the parser tracks it
+
     bool isEmptyText (const std::string& input) const;
 
     void validate(Node* child);
 
     void setRootElement (Node* child);
 
-    Node* getElementById (Node* node, const std::string& id);
+    const Node* getElementById (const Node* node, const std::string& id) const;
+
+    void getElementsByTagName (const Node* node, const std::string& tagName, vector<const ElementNode*>& nodes) const;
 
-    void getElementsByTagName (Node* node, const std::string& tagName, vector<ElementNode*>& nodes);
+    void getElementsByTagNameNS (const Node* node, uint32_t namespaceId, const std::string& localName,
+	vector<const ElementNode*>& nodes) const;
 
 
     public:		
@@ -41,20 +47,53 @@ namespace tinyXMLpp {
     /*Returns the XML document element(node)*/
     ElementNode* getRootElement() const;		
 
+    /*Returns the top level nodes of the document*/
+    const vector<Node*>& getChildren() const;
+
     /*call the function to commit the XML DOM to a file.*/
     void write(const std::string& path) const;
     void write(std::ostream& os) const;		
 
+    /*Text the nodes were parsed from. When it is set, write copies
+      every node that did not change straight from it.*/
+    void setSource(std::string source);
+    const std::string& getSource() const;
+
+    /*Save the DOM as a binary snapshot and load it back*/
+    void saveSnapshot(const std::string& path) const;
+    static std::unique_ptr<Document> loadSnapshot(const std::string& path);
+
     /*Overloads for adding a node to the Document*/
     void addChildNode (Node* child);
     void addChildNode (Node* child,int index);
+    void addChildNode (std::unique_ptr<Node> child);
+    void addChildNode (std::unique_ptr<Node> child, int index);
 
     /*Overloads for removing a node to the Document*/
     void removeChildNode (Node* child);
     void removeChildNode (int index);
 
     ElementNode* getElementById(const std::string& id);		
+    const ElementNode* getElementById(const std::string& id) const;
     vector<ElementNode*> getElementsByTagName(const std::string& tagName);
+    vector<const ElementNode*> getElementsByTagName(const std::string& tagName) const;
+
+    /*Finds elements by namespace URI and local name, whatever prefix
+      they were written with*/
+    vector<ElementNode*> getElementsByTagNameNS(const std::string& namespaceURI, const std::string& localName);
+    vector<const ElementNode*> getElementsByTagNameNS(const std::string& namespaceURI, const std::string& localName) const;
+
+    /*Structural hash and equality of whole documents, see Node::equals*/
+    uint64_t getHash() const;
+    bool equals(const Document& other) const;
+
+    /*Moves the tree into an immutable document that can be
+      shared between threads. This Document is left empty.*/
+    std::shared_ptr<const FrozenDocument> freeze();
+
+    /*Deep copy of the tree. The source text is not copied, so the
+      copy writes every node out in full.*/
+    std::unique_ptr<Document> clone() const;
 
   };
 
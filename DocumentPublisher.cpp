@@ -0,0 +1,172 @@
+#include "DocumentPublisher.h"
+#include "XMLException.h"
+
+#include <thread>
+#include <limits>
+
+namespace tinyXMLpp {
+
+  /**
+   * Constructor which publishes the first version.
+   *
+   *@param initial The first version, or nullptr to start with none.
+   *@param readerSlots How many readers may hold a version at the same moment without waiting for a free slot.
+   */
+  DocumentPublisher::DocumentPublisher(std::unique_ptr<Document> initial, size_t readerSlots)
+    : slots(readerSlots > 0 ? readerSlots : 1), published(nullptr), epoch(1)
+  {
+    for (size_t i = 0; i < slots.size(); ++i) {
+      slots[i].epoch.store(0, std::memory_order_relaxed);
+    }
+    if (initial)
+      publish(std::move(initial));
+  }
+
+  /**
+   * Destructor. Every reader must be done, since all versions are freed.
+   */
+  DocumentPublisher::~DocumentPublisher()
+  {
+  }
+
+  /**
+   * Function which hands out the current version. The reader takes a free slot and marks it with the current epoch before
+   * it loads the version, so a writer that retires the version afterwards sees the mark and keeps the version alive. Only
+   * atomic operations are used; when every slot is taken, the reader yields until one is released.
+   *
+   *@return A Reader holding the current version.
+   */
+  DocumentPublisher::Reader DocumentPublisher::read()
+  {
+    size_t count = slots.size();
+    size_t slot = std::hash<std::thread::id>()(std::this_thread::get_id()) % count;
+
+    while (true) {
+      uint64_t now = epoch.load();
+      for (size_t i = 0; i < count; ++i, slot = (slot + 1) % count) {
+	uint64_t free = 0;
+	if (slots[slot].epoch.load(std::memory_order_relaxed) == 0 && slots[slot].epoch.compare_exchange_strong(free, now))
+	  return Reader(this, slot, published.load());
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  /**
+   * Move constructor. The moved from reader holds nothing.
+   *
+   *@param other The reader to take the version from.
+   */
+  DocumentPublisher::Reader::Reader(Reader&& other)
+    : publisher(other.publisher), slot(other.slot), version(other.version)
+  {
+    other.publisher = nullptr;
+  }
+
+  /**
+   * Destructor which releases the slot, telling writers this reader is done with its version.
+   */
+  DocumentPublisher::Reader::~Reader()
+  {
+    if (publisher != nullptr)
+      publisher->slots[slot].epoch.store(0, std::memory_order_release);
+  }
+
+  /**
+   * Function which makes a document the current version. It is frozen, so it must not be used by the caller afterwards.
+   *
+   *@param doc The new version.
+   */
+  void DocumentPublisher::publish(std::unique_ptr<Document> doc)
+  {
+    if (!doc)
+      throw XMLException("Cannot publish a null document");
+
+    std::lock_guard<std::mutex> guard(writeLock);
+    publishLocked(std::move(doc));
+  }
+
+  /**
+   * Function which makes the next version from a copy of the current one. The copy is made and changed while readers go
+   * on reading the current version; writers wait for each other, so no change is lost.
+   *
+   *@param change Function which changes the copy.
+   */
+  void DocumentPublisher::update(const std::function<void(Document&)>& change)
+  {
+    std::lock_guard<std::mutex> guard(writeLock);
+
+    std::unique_ptr<Document> next = current ? current->thaw() : std::unique_ptr<Document>(new Document());
+    change(*next);
+    publishLocked(std::move(next));
+  }
+
+  /**
+   * Function which swaps in a new version and retires the old one. The epoch is moved on after the swap, so readers that
+   * started in an earlier epoch may hold the old version, and readers starting from now on get the new one.
+   *
+   *@param doc The new version.
+   */
+  void DocumentPublisher::publishLocked(std::unique_ptr<Document> doc)
+  {
+    std::shared_ptr<const FrozenDocument> version = doc->freeze();
+
+    published.store(version.get());
+    uint64_t retiredAt = epoch.fetch_add(1) + 1;
+
+    if (current) {
+      RetiredVersion old;
+      old.version = std::move(current);
+      old.epoch = retiredAt;
+      retired.push_back(std::move(old));
+    }
+    current = std::move(version);
+
+    reclaimLocked();
+  }
+
+  /**
+   * Function which frees the retired versions that no reader can hold: those retired at an epoch later than that of
+   * every reader still inside a read.
+   */
+  void DocumentPublisher::reclaimLocked()
+  {
+    if (retired.empty())
+      return;
+
+    uint64_t oldest = std::numeric_limits<uint64_t>::max();
+    for (size_t i = 0; i < slots.size(); ++i) {
+      uint64_t started = slots[i].epoch.load();
+      if (started != 0 && started < oldest)
+	oldest = started;
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < retired.size(); ++i) {
+      if (retired[i].epoch > oldest)
+	retired[kept++] = std::move(retired[i]);
+    }
+    retired.resize(kept);
+  }
+
+  /**
+   * Function which frees the old versions the readers are done with.
+   */
+  void DocumentPublisher::reclaim()
+  {
+    std::lock_guard<std::mutex> guard(writeLock);
+    reclaimLocked();
+  }
+
+  /**
+   * Function which returns the number of old versions kept alive for readers.
+   *
+   *@return The number of retired versions not freed yet.
+   */
+  size_t DocumentPublisher::getRetiredCount()
+  {
+    std::lock_guard<std::mutex> guard(writeLock);
+    return retired.size();
+  }
+
+}
@@ -0,0 +1,107 @@
+#ifndef __DOCUMENTPUBLISHER_H__
+#define __DOCUMENTPUBLISHER_H__
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include "Document.h"
+#include "FrozenDocument.h"
+
+namespace tinyXMLpp {
+
+  /*Publishes successive immutable versions of a document to many
+    reader threads. Readers never take a lock: they mark the epoch
+    they started in and read whatever version is current. Writers make
+    the next version from a copy of the current one and swap it in;
+    the old version is freed once every reader that could have seen it
+    is done. Meant for documents read all the time and changed rarely,
+    since each change copies the tree.
+
+      DocumentPublisher routes(parser.parse("routes.xml"));
+      ...
+      DocumentPublisher::Reader version = routes.read();	//any thread
+      version->getElementById(...);
+      ...
+      routes.update([](Document& doc) { ... });		//writer*/
+  class DocumentPublisher {
+
+    /*Epoch a reader started in, 0 when the slot is free. Each slot
+      has a cache line of its own, since readers on different threads
+      write them.*/
+    struct ReaderSlot {
+      std::atomic<uint64_t> epoch;
+      char padding[64 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    struct RetiredVersion {
+      std::shared_ptr<const FrozenDocument> version;
+      uint64_t epoch;			//readers that started before this epoch may still hold it
+    };
+
+    std::vector<ReaderSlot> slots;
+    std::atomic<const FrozenDocument*> published;
+    std::atomic<uint64_t> epoch;
+
+    std::mutex writeLock;			//writers take turns, readers never wait on it
+    std::shared_ptr<const FrozenDocument> current;
+    std::vector<RetiredVersion> retired;
+
+    DocumentPublisher(const DocumentPublisher&);
+    DocumentPublisher& operator=(const DocumentPublisher&);
+
+    void publishLocked(std::unique_ptr<Document> doc);
+    void reclaimLocked();
+
+    public:
+    /*The slot count is how many readers may be inside read guards at
+      the same moment without waiting for each other*/
+    DocumentPublisher(std::unique_ptr<Document> initial = nullptr, size_t readerSlots = 128);
+    ~DocumentPublisher();
+
+    /*Keeps the version it was given alive until it goes out of scope.
+      It should be held only for the length of one read.*/
+    class Reader {
+      DocumentPublisher* publisher;
+      size_t slot;
+      const FrozenDocument* version;
+
+      Reader(const Reader&);
+      Reader& operator=(const Reader&);
+
+      friend class DocumentPublisher;
+      Reader(DocumentPublisher* publisher, size_t slot, const FrozenDocument* version)
+	: publisher(publisher), slot(slot), version(version) {}
+
+      public:
+      Reader(Reader&& other);
+      ~Reader();
+
+      /*nullptr before anything was published*/
+      const FrozenDocument* get() const { return version; }
+      const FrozenDocument* operator->() const { return version; }
+      const FrozenDocument& operator*() const { return *version; }
+    };
+
+    /*Reader side: the current version*/
+    Reader read();
+
+    /*Writer side. publish replaces the current version with a new
+      document; update applies a change to a copy of the current one
+      and publishes the copy.*/
+    void publish(std::unique_ptr<Document> doc);
+    void update(const std::function<void(Document&)>& change);
+
+    /*Frees the old versions no reader holds any more. Publishing does
+      this too; it is only needed to free memory between updates.*/
+    void reclaim();
+
+    /*Old versions still waiting for readers to finish*/
+    size_t getRetiredCount();
+  };
+
+}
+
+#endif
@@ -1,8 +1,15 @@
 #include "ElementNode.h"
 #include "Attribute.h"
+#include "Namespace.h"
+#include "Hash.h"
 
 namespace tinyXMLpp {
 
+  namespace {
+    /*"ELEM", keeps the hashes of different node types apart*/
+    const uint64_t HASH_SEED = 0x454C454D;
+  }
+
   /**
    *Function to create an empty ElementNode.
    *
@@ -24,6 +31,39 @@ namespace tinyXMLpp {
     return new ElementNode(name);
   }
 
+  /**
+   *Function to create an empty ElementNode, taking over the buffer of the name instead of copying it.
+   *
+   *@param name The name of the ElementNode.
+   *@return Returns an object of ElementNode with the name passed as an argument.
+   */
+  ElementNode* ElementNode::createElementNode(std::string&& name)
+  {
+    return new ElementNode(std::move(name));
+  }
+
+  /**
+   *Function to create an empty ElementNode owned by a unique_ptr, to be handed to Node::addChildNode.
+   *
+   *@param name The name of the ElementNode.
+   *@return Returns a unique_ptr to the new ElementNode.
+   */
+  std::unique_ptr<ElementNode> ElementNode::makeElementNode(std::string name)
+  {
+    return std::unique_ptr<ElementNode>(new ElementNode(std::move(name)));
+  }
+
+  /**
+   *Constructor
+   *
+   *@param name The name of the ElementNode, with its prefix if it has one.
+   */
+  ElementNode::ElementNode(std::string name):numberOfAttributes(0), name(std::move(name)), namespaceId(0)
+  {
+    size_t colon = this->name.find(':');
+    this->localNameOffset = colon == std::string::npos ? 0 : colon + 1;
+  }
+
   /**
    *Destructor
    */
@@ -32,6 +72,7 @@ namespace tinyXMLpp {
     for(int i=0;i<this->attributes.size();++i){
       delete this->attributes[i];
     }
+    NamespaceTable::release(this->namespaceId);
   }
 
   /**
@@ -41,8 +82,11 @@ namespace tinyXMLpp {
    *@param value The value in the name-value pair of the Attribute to be added to the attributes list of the ElementNode.
    */
   void ElementNode::addAttribute (const std::string& key, const std::string& value) {		
-    attributes.push_back(new Attribute(key, value));
+    Attribute* attrib = new Attribute(key, value);
+    attributes.push_back(attrib);
+    attrib->owner = this;
     ++numberOfAttributes;
+    markDirty();
   }
 
   /**
@@ -52,10 +96,41 @@ namespace tinyXMLpp {
    */
   void ElementNode::addAttribute (Attribute* attrib) {
     attributes.push_back(attrib);
+    attrib->owner = this;
     ++numberOfAttributes;
+    markDirty();
     return;
   }
 
+  /**
+   *Function to add an attribute to the ElementNode, taking over its ownership.
+   *
+   *@param attrib The Attribute to be added to the attributes list of the ElementNode.
+   */
+  void ElementNode::addAttribute (std::unique_ptr<Attribute> attrib) {
+    addAttribute(attrib.get());
+    attrib.release();
+  }
+
+  /**
+   *Function to add an attribute to the ElementNode, taking over the buffers of key and value instead of copying them.
+   *
+   *@param key The key or name in the name-value pair of the Attribute to be added to the attributes list of the ElementNode
+   *@param value The value in the name-value pair of the Attribute to be added to the attributes list of the ElementNode.
+   */
+  void ElementNode::addAttribute (std::string&& key, std::string&& value) {
+    addAttribute(new Attribute(std::move(key), std::move(value)));
+  }
+
+  /**
+   *Function to make room in the attribute list for the given number of attributes, so it is not grown one at a time.
+   *
+   *@param count The number of attributes the ElementNode will have.
+   */
+  void ElementNode::reserveAttributes(int count) {
+    attributes.reserve(count);
+  }
+
   /**
    *Function to find the number of attributes present in the ElementNode.
    *
@@ -70,10 +145,62 @@ namespace tinyXMLpp {
    *
    *@return The name of the ElementNode.
    */
-  std::string ElementNode::getName () const {
+  const std::string& ElementNode::getName () const {
     return this->name;
   }
 
+  /**
+   *Function to find the id of the namespace the ElementNode is in.
+   *
+   *@return The namespace id, NamespaceTable::NO_NAMESPACE if it is in none.
+   */
+  uint32_t ElementNode::getNamespaceId () const {
+    return this->namespaceId;
+  }
+
+  /**
+   *Function to find the URI of the namespace the ElementNode is in.
+   *
+   *@return The namespace URI, empty if it is in none.
+   */
+  const std::string& ElementNode::getNamespaceURI () const {
+    return NamespaceTable::getURI(this->namespaceId);
+  }
+
+  /**
+   *Function to set the namespace of the ElementNode. The element takes a reference of its own to the namespace.
+   *
+   *@param id A namespace id from NamespaceTable, which the caller holds a reference to.
+   */
+  void ElementNode::setNamespaceId (uint32_t id) {
+    NamespaceTable::retain(id);
+    NamespaceTable::release(this->namespaceId);
+    this->namespaceId = id;
+  }
+
+  /**
+   *Function to find the name of the ElementNode without its prefix.
+   *
+   *@return The local name of the ElementNode.
+   */
+  std::string ElementNode::getLocalName () const {
+    return this->name.substr(this->localNameOffset);
+  }
+
+  /**
+   *Function to check the namespace and local name of the ElementNode. The namespace is compared as an integer and the local
+   *name in place, so no prefix is split off.
+   *
+   *@param namespaceId The namespace id looked for.
+   *@param localName The local name looked for.
+   *@return true if both match.
+   */
+  bool ElementNode::hasName (uint32_t namespaceId, const std::string& localName) const {
+    return this->namespaceId == namespaceId &&
+      this->name.size() - this->localNameOffset == localName.size() &&
+      this->name.compare(this->localNameOffset, std::string::npos, localName) == 0;
+  }
+
   /**
    *Function which returns an attribute with the given name, if it is present in the ElementNode
    *
@@ -81,12 +208,19 @@ namespace tinyXMLpp {
    *@return The attribute with the name passed as argument, if present in the node. Otherwise, return nullptr.
    */
   Attribute* ElementNode::getAttribute (const std::string& name) {
-    std::vector<Attribute*>::iterator it = this->attributes.begin();
-    Attribute* temp;
-    while (it != this->attributes.end()) {
-      temp = *it;
-      if (temp->getName() == name) {
-	return temp;
+    return const_cast<Attribute*>(static_cast<const ElementNode*>(this)->getAttribute(name));
+  }
+
+  /**
+   *Const version of getAttribute.
+   *
+   *@param name The name of the attribute.
+   *@return The attribute with the name passed as argument, if present in the node. Otherwise, return nullptr.
+   */
+  const Attribute* ElementNode::getAttribute (const std::string& name) const {
+    for (int i = 0; i < this->attributes.size(); ++i) {
+      if (this->attributes[i]->getName() == name) {
+	return this->attributes[i];
       }
     }
     return nullptr;
@@ -104,9 +238,12 @@ namespace tinyXMLpp {
       temp = *it;
       if (temp->getName() == name) {
 	this->attributes.erase(it);
+	--numberOfAttributes;
 	delete temp;
+	markDirty();
 	return;
       }
+      ++it;
     }
     throw XMLException ("The attribute you tried to delete, does not exist");
   }
@@ -116,10 +253,56 @@ namespace tinyXMLpp {
    *
    *@return vector of Attribute* 
    */
-  const std::vector<Attribute*>& ElementNode::getAttributes() const {
+  const std::vector<Attribute*>& ElementNode::getAttributes() {
     return this->attributes;
   }
 
+  /**
+   *Function which returns the attributes of a const ElementNode, each as a const Attribute*.
+   *
+   *@return A read-only view of the attribute list.
+   */
+  ConstPointerList<Attribute> ElementNode::getAttributes() const {
+    return ConstPointerList<Attribute>(this->attributes);
+  }
+
+  /**
+   *Function which returns the attribute with the given namespace and local name, if it is present in the ElementNode
+   *
+   *@param namespaceURI The namespace URI of the attribute, empty for attributes in no namespace.
+   *@param localName The name of the attribute without its prefix.
+   *@return The attribute, if present in the node. Otherwise, return nullptr.
+   */
+  Attribute* ElementNode::getAttributeNS (const std::string& namespaceURI, const std::string& localName) {
+    return const_cast<Attribute*>(static_cast<const ElementNode*>(this)->getAttributeNS(namespaceURI, localName));
+  }
+
+  /**
+   *Const version of getAttributeNS.
+   *
+   *@param namespaceURI The namespace URI of the attribute, empty for attributes in no namespace.
+   *@param localName The name of the attribute without its prefix.
+   *@return The attribute, if present in the node. Otherwise, return nullptr.
+   */
+  const Attribute* ElementNode::getAttributeNS (const std::string& namespaceURI, const std::string& localName) const {
+    uint32_t id = NamespaceTable::find(namespaceURI);
+    if (id == NamespaceTable::INVALID_NAMESPACE)
+      return nullptr;
+
+    for (int i = 0; i < this->attributes.size(); ++i) {
+      const Attribute* attrib = this->attributes[i];
+      if (attrib->getNamespaceId() != id)
+	continue;
+
+      const std::string& name = attrib->getName();
+      size_t colon = name.find(':');
+      size_t start = colon == std::string::npos ? 0 : colon + 1;
+      if (name.size() - start == localName.size() && name.compare(start, std::string::npos, localName) == 0)
+	return attrib;
+    }
+    return nullptr;
+  }
+
   /**
    *Function to write the ElementNode as an XML element into the output stream. It also calls the write function on the child nodes.
    *
@@ -127,21 +310,103 @@ namespace tinyXMLpp {
    */
   void ElementNode::write(std::ostream& os) const{
 
-    os << "<" + this->getName();	
+    os << '<' << this->name;	
 
-    auto attributes = this->getAttributes();
     for (int i = 0; i < attributes.size() ; ++i){   
-      os << " " + attributes[i]->getName();
-      os << "=\"" + attributes[i]->getValue() + "\"";
+      os << ' ' << attributes[i]->getName();
+      os << "=\"" << attributes[i]->getValue() << '"';
     }
-    os << ">";
+    os << '>';
 
-    auto children = this->getChildren();
+    ConstPointerList<Node> children = this->getChildren();
     for(auto it = children.begin(); it != children.end(); ++it){		
       (*it)->write(os);
     }
 
-    os << "</" +  this->getName() + ">";
+    os << "</" << this->name << '>';
   }
 
+  /**
+   *Function to write the ElementNode into the output stream, copying it verbatim from the source it was parsed from when
+   *it did not change. A changed element writes its own tags again and asks each child to do the same, so only the
+   *changed parts of the tree are serialized.
+   *
+   *@param os The output stream to which the XML element should be written.
+   *@param source The text the element was parsed from.
+   */
+  void ElementNode::writeIncremental(std::ostream& os, const std::string& source) const{
+
+    if (!isDirty()) {
+      Node::writeIncremental(os, source);
+      return;
+    }
+
+    os << '<' << this->name;	
+
+    for (int i = 0; i < attributes.size() ; ++i){   
+      os << ' ' << attributes[i]->getName();
+      os << "=\"" << attributes[i]->getValue() << '"';
+    }
+    os << '>';
+
+    ConstPointerList<Node> children = this->getChildren();
+    for(auto it = children.begin(); it != children.end(); ++it){		
+      (*it)->writeIncremental(os, source);
+    }
+
+    os << "</" << this->name << '>';
+  }
+
+  /**
+   *Function to compute the hash of the ElementNode from its name, its attributes in order and the hashes of its children.
+   *
+   *@return The hash of the element's subtree.
+   */
+  uint64_t ElementNode::computeHash() const
+  {
+    uint64_t hash = hashString(this->name, HASH_SEED);
+    hash = hashCombine(hash, this->attributes.size());
+    for (size_t i = 0; i < this->attributes.size(); ++i) {
+      hash = hashCombine(hash, hashString(this->attributes[i]->getName(), 0));
+      hash = hashCombine(hash, hashString(this->attributes[i]->getValue(), 0));
+    }
+    return hashChildren(hash);
+  }
+
+  /**
+   *Function to compare the name and attributes of two elements, leaving out their children.
+   *
+   *@param other The node to compare with.
+   *@return true if other is an ElementNode with the same name and the same attributes in the same order.
+   */
+  bool ElementNode::hasSameContent(const Node& other) const
+  {
+    const ElementNode* elem = dynamic_cast<const ElementNode*>(&other);
+    if (elem == nullptr || elem->name != this->name || elem->attributes.size() != this->attributes.size())
+      return false;
+
+    for (size_t i = 0; i < this->attributes.size(); ++i) {
+      if (elem->attributes[i]->getName() != this->attributes[i]->getName() ||
+	  elem->attributes[i]->getValue() != this->attributes[i]->getValue())
+	return false;
+    }
+    return true;
+  }
+
+  /**
+   *Function to copy the element with its attributes and namespaces, for Node::clone.
+   *
+   *@return A new ElementNode without children.
+   */
+  Node* ElementNode::cloneContent() const
+  {
+    std::unique_ptr<ElementNode> copy(createElementNode(this->name));
+    copy->setNamespaceId(this->namespaceId);
+    for (size_t i = 0; i < this->attributes.size(); ++i) {
+      std::unique_ptr<Attribute> attrib(new Attribute(this->attributes[i]->getName(), this->attributes[i]->getValue()));
+      attrib->setNamespaceId(this->attributes[i]->getNamespaceId());
+      copy->addAttribute(std::move(attrib));
+    }
+    return copy.release();
+  }
 }
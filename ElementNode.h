@@ -1,6 +1,7 @@
 #ifndef __ELEMENTNODE_H__
 #define __ELEMENTNODE_H__
 
+#include <cstdint>
 #include "Node.h"
 #include "CommentNode.h"
 #include "TextNode.h"
@@ -12,30 +13,60 @@ namespace tinyXMLpp{
     int numberOfAttributes;
     bool isRoot;
     std::string name;
-    ElementNode(){}
-    ElementNode(std::string name):numberOfAttributes(0), name(name) {  }
+    uint32_t namespaceId;
+    uint32_t localNameOffset;		//start of the local part of name, past the prefix
+    ElementNode():numberOfAttributes(0), namespaceId(0), localNameOffset(0) {}
+    ElementNode(std::string name);
     public:		
     ~ElementNode();		
 
     /*Used to Construct the Element Node*/
     static ElementNode* createElementNode();
     static ElementNode* createElementNode(const std::string& name);
+    static ElementNode* createElementNode(std::string&& name);
+    static std::unique_ptr<ElementNode> makeElementNode(std::string name);
 
     /*Returns the name of the Element Tag*/
-    std::string getName() const;
+    const std::string& getName() const;
+
+    /*Namespace of the element, set by the parser when it resolves
+      prefixes. The name keeps its prefix; getLocalName drops it.*/
+    uint32_t getNamespaceId() const;
+    const std::string& getNamespaceURI() const;
+    void setNamespaceId(uint32_t id);
+    std::string getLocalName() const;
+
+    /*true if the element is in the given namespace and has the
+      given local name, comparing the namespace as an integer*/
+    bool hasName(uint32_t namespaceId, const std::string& localName) const;
 
     /*Methods to add and remove attributes*/
     void addAttribute (Attribute* attrib);		
+    void addAttribute (std::unique_ptr<Attribute> attrib);
     void addAttribute(const std::string& key, const std::string& value);		
+    void addAttribute(std::string&& key, std::string&& value);
     void removeAttribute(const std::string& name);		
 
+    /*Makes room for the given number of attributes*/
+    void reserveAttributes(int count);
+
     /*Methods to retrieve the attributes*/
     int getNumberOfAttributes() const;
     Attribute* getAttribute(const std::string& name);
-    const std::vector<Attribute*>& getAttributes() const;		
+    const Attribute* getAttribute(const std::string& name) const;
+    const std::vector<Attribute*>& getAttributes();		
+    ConstPointerList<Attribute> getAttributes() const;
+    Attribute* getAttributeNS(const std::string& namespaceURI, const std::string& localName);
+    const Attribute* getAttributeNS(const std::string& namespaceURI, const std::string& localName) const;
 
     /*Method to write the Node to an output stream*/
     void write(std::ostream& os) const;
+    void writeIncremental(std::ostream& os, const std::string& source) const;
+
+    protected:
+    uint64_t computeHash() const;
+    bool hasSameContent(const Node& other) const;
+    Node* cloneContent() const;
   };
 
 }
@@ -0,0 +1,60 @@
+#include "ElementPath.h"
+#include "XMLException.h"
+
+namespace tinyXMLpp {
+
+  /**
+   * Constructor which splits the path into its steps.
+   *
+   *@param path The element path.
+   */
+  ElementPath::ElementPath(const std::string& path) : path(path)
+  {
+    anyDepth = path.compare(0, 2, "//") == 0;
+
+    size_t start = anyDepth ? 2 : (path.compare(0, 1, "/") == 0 ? 1 : 0);
+    while (start <= path.size()) {
+      size_t end = path.find('/', start);
+      if (end == std::string::npos)
+	end = path.size();
+      if (end == start)
+	throw XMLException("Empty step in element path " + path);
+      steps.push_back(path.substr(start, end - start));
+      start = end + 1;
+    }
+
+    if (steps.empty() || (anyDepth && steps.size() != 1))
+      throw XMLException("Unsupported element path " + path);
+  }
+
+  /**
+   * Function which tells how an element relates to the path.
+   *
+   *@param depth The number of open ancestors of the element.
+   *@param name The name of the element.
+   *@return FULL_MATCH if the element is selected, PARTIAL_MATCH if selected elements may be nested in it, NO_MATCH otherwise.
+   */
+  ElementPath::Match ElementPath::match(size_t depth, const std::string& name) const
+  {
+    /*outside "//" paths every open element matched its step, so depth is also the step to match*/
+    const std::string& step = anyDepth ? steps[0] : steps[depth];
+    bool matches = step == "*" || step == name;
+
+    if (anyDepth)
+      return matches ? FULL_MATCH : PARTIAL_MATCH;
+    if (!matches)
+      return NO_MATCH;
+    return depth == steps.size() - 1 ? FULL_MATCH : PARTIAL_MATCH;
+  }
+
+  /**
+   * Function which returns the path as it was given.
+   *
+   *@return The path.
+   */
+  const std::string& ElementPath::getPath() const
+  {
+    return path;
+  }
+
+}
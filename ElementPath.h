@@ -0,0 +1,36 @@
+#ifndef __ELEMENTPATH_H__
+#define __ELEMENTPATH_H__
+
+#include <string>
+#include <vector>
+
+namespace tinyXMLpp {
+
+  /*Selects elements while streaming through a document. The path is
+    either absolute, like "catalog/book", where a step can be "*" to
+    match any name, or "//book" to match the name at any depth.*/
+  class ElementPath {
+
+    std::string path;
+    std::vector<std::string> steps;
+    bool anyDepth;
+
+    public:
+    enum Match {
+      NO_MATCH,			//nothing below the element can match, skip it
+      PARTIAL_MATCH,		//matches may be nested inside the element
+      FULL_MATCH		//the element itself is selected
+    };
+
+    ElementPath(const std::string& path);
+
+    /*Matches an element with depth open ancestors. The ancestors must
+      all have been PARTIAL_MATCH, since other elements are skipped.*/
+    Match match(size_t depth, const std::string& name) const;
+
+    const std::string& getPath() const;
+  };
+
+}
+
+#endif
@@ -0,0 +1,324 @@
+#include "Encoding.h"
+
+#include <cstring>
+#include <algorithm>
+
+namespace tinyXMLpp {
+
+  const unsigned char NAME_BYTE_CLASS[256] = {
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 0, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 3, 0, 0, 0, 0, 0,
+      0, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 0, 0, 0, 0, 3,
+      0, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 0, 0, 0, 0, 0,
+      3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+      3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+      3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+      3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+  };
+
+  namespace {
+
+    /*Bytes kept in front of each transcoded block so the tokenizer can push back characters across a refill*/
+    const size_t PUTBACK_SIZE = 16;
+    const size_t BLOCK_SIZE = 64 * 1024;
+
+    struct CodePointRange {
+      uint32_t first, last;
+    };
+
+    /*Non ASCII ranges of NameStartChar, in order*/
+    const CodePointRange NAME_START_RANGES[] = {
+      { 0xC0, 0xD6 }, { 0xD8, 0xF6 }, { 0xF8, 0x2FF }, { 0x370, 0x37D }, { 0x37F, 0x1FFF }, { 0x200C, 0x200D },
+      { 0x2070, 0x218F }, { 0x2C00, 0x2FEF }, { 0x3001, 0xD7FF }, { 0xF900, 0xFDCF }, { 0xFDF0, 0xFFFD },
+      { 0x10000, 0xEFFFF }
+    };
+
+    /*Non ASCII ranges NameChar adds to NameStartChar, in order*/
+    const CodePointRange NAME_RANGES[] = {
+      { 0xB7, 0xB7 }, { 0x300, 0x36F }, { 0x203F, 0x2040 }
+    };
+
+    template<size_t N>
+    bool inRanges(const CodePointRange (&ranges)[N], uint32_t cp)
+    {
+      const CodePointRange* it = std::upper_bound(ranges, ranges + N, cp,
+	  [](uint32_t value, const CodePointRange& range) { return value < range.first; });
+      return it != ranges && cp <= (it - 1)->last;
+    }
+
+    /*Decodes the character starting at name[i], moving i past it. The name is already known to be valid UTF-8.*/
+    uint32_t decode(const std::string& name, size_t& i)
+    {
+      unsigned char b = name[i++];
+      if (b < 0x80)
+	return b;
+
+      int extra = b >= 0xF0 ? 3 : (b >= 0xE0 ? 2 : 1);
+      uint32_t cp = b & (0x3F >> extra);
+      for (int k = 0; k < extra && i < name.size(); ++k) {
+	cp = (cp << 6) | (name[i++] & 0x3F);
+      }
+      return cp;
+    }
+
+    /*Appends a code point to the output as UTF-8*/
+    char* encode(uint32_t cp, char* out)
+    {
+      if (cp < 0x80) {
+	*out++ = cp;
+      }
+      else if (cp < 0x800) {
+	*out++ = 0xC0 | (cp >> 6);
+	*out++ = 0x80 | (cp & 0x3F);
+      }
+      else if (cp < 0x10000) {
+	*out++ = 0xE0 | (cp >> 12);
+	*out++ = 0x80 | ((cp >> 6) & 0x3F);
+	*out++ = 0x80 | (cp & 0x3F);
+      }
+      else {
+	*out++ = 0xF0 | (cp >> 18);
+	*out++ = 0x80 | ((cp >> 12) & 0x3F);
+	*out++ = 0x80 | ((cp >> 6) & 0x3F);
+	*out++ = 0x80 | (cp & 0x3F);
+      }
+      return out;
+    }
+  }
+
+  /**
+   * Function which reads the byte order mark at the start of a stream. A UTF-8 byte order mark is dropped as well, so the
+   * tokenizer never sees it. Streams without a byte order mark are left at their start.
+   *
+   *@param is The input stream, at the start of the document.
+   *@return The encoding of the stream.
+   */
+  Encoding readByteOrderMark(std::istream& is)
+  {
+    size_t markLength;
+    return readByteOrderMark(is, markLength);
+  }
+
+  /**
+   * Function which reads the byte order mark at the start of a stream and tells how many bytes it took.
+   *
+   *@param is The input stream, at the start of the document.
+   *@param markLength Set to the length of the byte order mark, 0 if there is none.
+   *@return The encoding of the stream.
+   */
+  Encoding readByteOrderMark(std::istream& is, size_t& markLength)
+  {
+    markLength = 0;
+    std::streambuf* sb = is.rdbuf();
+    if (sb == nullptr)
+      return UTF8;
+
+    int c1 = sb->sgetc();
+    if (c1 != 0xFF && c1 != 0xFE && c1 != 0xEF)
+      return UTF8;
+
+    sb->sbumpc();
+    int c2 = sb->sgetc();
+
+    if (c1 == 0xFF && c2 == 0xFE) {
+      sb->sbumpc();
+      markLength = 2;
+      return UTF16LE;
+    }
+    if (c1 == 0xFE && c2 == 0xFF) {
+      sb->sbumpc();
+      markLength = 2;
+      return UTF16BE;
+    }
+    if (c1 == 0xEF && c2 == 0xBB) {
+      sb->sbumpc();
+      if (sb->sgetc() == 0xBF) {
+	sb->sbumpc();
+	markLength = 3;
+	return UTF8;
+      }
+      sb->sungetc();
+    }
+
+    sb->sungetc();
+    return UTF8;
+  }
+
+  /**
+   * Function which checks a name against the character classes of XML 1.0. ASCII characters are looked up in
+   * NAME_BYTE_CLASS, others in the sorted range tables.
+   *
+   *@param name The name, in UTF-8.
+   *@return true if the name is a valid XML name.
+   */
+  bool isValidName(const std::string& name)
+  {
+    size_t i = 0;
+    bool first = true;
+
+    while (i < name.size()) {
+      uint32_t cp = decode(name, i);
+      bool valid;
+
+      if (cp < 0x80)
+	valid = (NAME_BYTE_CLASS[cp] & (first ? 1 : 2)) != 0;
+      else
+	valid = inRanges(NAME_START_RANGES, cp) || (!first && inRanges(NAME_RANGES, cp));
+
+      if (!valid)
+	return false;
+      first = false;
+    }
+
+    return !first;
+  }
+
+  /**
+   * Constructor
+   *
+   *@param source The stream buffer holding the UTF-16 data, after the byte order mark.
+   *@param bigEndian Whether the data is UTF-16BE rather than UTF-16LE.
+   */
+  Utf16InputBuffer::Utf16InputBuffer(std::streambuf* source, bool bigEndian)
+    : source(source), bigEndian(bigEndian), inBuffer(BLOCK_SIZE), outBuffer(BLOCK_SIZE * 3 / 2 + PUTBACK_SIZE),
+      pending(0), sourceDone(false), failed(false)
+  {
+    char* start = &outBuffer[0] + PUTBACK_SIZE;
+    setg(start, start, start);
+  }
+
+  /**
+   * Function which refills the get area by transcoding the next block of UTF-16. A surrogate pair split by the end of the
+   * block is kept for the next one. Invalid UTF-16 stops the transcoding: the characters before it are still handed out,
+   * then the buffer reports eof and hasError turns true.
+   *
+   *@return The next character, or eof when the input has been fully read.
+   */
+  Utf16InputBuffer::int_type Utf16InputBuffer::underflow()
+  {
+    if (gptr() < egptr())
+      return traits_type::to_int_type(*gptr());
+    if (failed)
+      return traits_type::eof();
+
+    size_t keep = gptr() - eback();
+    if (keep > PUTBACK_SIZE)
+      keep = PUTBACK_SIZE;
+
+    char* start = &outBuffer[0] + PUTBACK_SIZE;
+    memmove(start - keep, gptr() - keep, keep);
+    char* out = start;
+
+    while (out == start) {
+
+      if (!sourceDone) {
+	std::streamsize n = source->sgetn(&inBuffer[pending], inBuffer.size() - pending);
+	if (n <= 0)
+	  sourceDone = true;
+	else
+	  pending += n;
+      }
+
+      const unsigned char* in = reinterpret_cast<const unsigned char*>(&inBuffer[0]);
+      size_t i = transcodeUtf16(in, pending, bigEndian, sourceDone, out, failed);
+      if (failed)
+	break;
+
+      memmove(&inBuffer[0], &inBuffer[i], pending - i);
+      pending -= i;
+
+      if (sourceDone)
+	break;
+    }
+
+    setg(start - keep, start, out);
+
+    if (gptr() == egptr())
+      return traits_type::eof();
+    return traits_type::to_int_type(*gptr());
+  }
+
+  /**
+   * Function which transcodes UTF-16 to UTF-8 up to the last complete character of the input. It is shared by
+   * Utf16InputBuffer and the parsers that are handed their input in pieces.
+   *
+   *@param in The UTF-16 bytes.
+   *@param length The number of bytes.
+   *@param bigEndian Whether the bytes are UTF-16BE rather than UTF-16LE.
+   *@param last Whether the input ends with these bytes, so a cut off character is an error.
+   *@param out Where the UTF-8 goes, moved past what was written.
+   *@param failed Set to true if invalid UTF-16 was found.
+   *@return The number of bytes of in that were transcoded.
+   */
+  size_t transcodeUtf16(const unsigned char* in, size_t length, bool bigEndian, bool last, char*& out, bool& failed)
+  {
+    size_t i = 0;
+    int hi = bigEndian ? 0 : 1;
+
+    while (i + 1 < length) {
+      uint32_t unit = (in[i + hi] << 8) | in[i + 1 - hi];
+
+      /*plain ASCII is by far the most common case*/
+      if (unit < 0x80) {
+	*out++ = unit;
+	i += 2;
+	continue;
+      }
+
+      if (unit >= 0xD800 && unit <= 0xDBFF) {
+	if (i + 3 >= length) {
+	  failed = last;		//input ends in the middle of a surrogate pair
+	  return i;
+	}
+	uint32_t low = (in[i + 2 + hi] << 8) | in[i + 3 - hi];
+	if (low < 0xDC00 || low > 0xDFFF) {
+	  failed = true;		//unpaired surrogate
+	  return i;
+	}
+	unit = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+	i += 2;
+      }
+      else if (unit >= 0xDC00 && unit <= 0xDFFF) {
+	failed = true;
+	return i;
+      }
+
+      out = encode(unit, out);
+      i += 2;
+    }
+
+    /*input ending in the middle of a character*/
+    if (last && length - i == 1)
+      failed = true;
+    return i;
+  }
+
+  /**
+   * Constructor which reads the byte order mark of the input. UTF-16 input is read through a transcoder, which the
+   * stream handed out keeps the exception mask of the input for.
+   *
+   *@param is The input stream, at the start of the document.
+   */
+  DecodedInput::DecodedInput(std::istream& is)
+    : encoding(readByteOrderMark(is, markLength)), transcoded(nullptr), stream(&is)
+  {
+    if (encoding == UTF8)
+      return;
+
+    transcoder.reset(new Utf16InputBuffer(is.rdbuf(), encoding == UTF16BE));
+    transcoded.rdbuf(transcoder.get());
+    transcoded.exceptions(is.exceptions());
+    stream = &transcoded;
+  }
+
+  /**
+   * Function which tells whether the stream ended because of invalid UTF-16 rather than at the end of the input.
+   *
+   *@return true if invalid UTF-16 was found.
+   */
+  bool Utf16InputBuffer::hasError() const
+  {
+    return failed;
+  }
+
+}
@@ -0,0 +1,147 @@
+#ifndef __ENCODING_H__
+#define __ENCODING_H__
+
+#include <string>
+#include <streambuf>
+#include <istream>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+namespace tinyXMLpp {
+
+  enum Encoding { UTF8, UTF16LE, UTF16BE };
+
+  /*Reads the byte order mark at the start of a stream, if there is
+    one, and tells which encoding it stands for. Streams without a
+    byte order mark are UTF-8 and are left untouched.*/
+  Encoding readByteOrderMark(std::istream& is);
+  Encoding readByteOrderMark(std::istream& is, size_t& markLength);
+
+  /*Classes of the bytes that can appear in a name: bit 1 for bytes
+    that can start a name, bit 2 for bytes that can follow. Bytes of
+    multi byte characters are allowed here and checked by isValidName.*/
+  extern const unsigned char NAME_BYTE_CLASS[256];
+
+  inline bool isNameByte(int c)
+  {
+    return c >= 0 && c < 256 && NAME_BYTE_CLASS[c] != 0;
+  }
+
+  /*Checks a UTF-8 name against the NameStartChar and NameChar classes
+    of XML 1.0*/
+  bool isValidName(const std::string& name);
+
+  /*Incremental UTF-8 validator, fed one byte at a time. Rejects
+    overlong forms, surrogates and code points above U+10FFFF.*/
+  class Utf8Validator {
+
+    unsigned char needed;		//continuation bytes still expected
+    unsigned char lower, upper;		//range allowed for the next one
+
+    public:
+    Utf8Validator() : needed(0), lower(0x80), upper(0xBF) {}
+
+    void reset() { needed = 0; }
+
+    /*Returns false if the byte cannot continue valid UTF-8*/
+    bool add(unsigned char b)
+    {
+      if (needed == 0) {
+	if (b < 0x80)
+	  return true;
+	if (b < 0xC2 || b > 0xF4)
+	  return false;
+	if (b < 0xE0) {
+	  needed = 1;
+	  lower = 0x80; upper = 0xBF;
+	}
+	else if (b < 0xF0) {
+	  needed = 2;
+	  lower = b == 0xE0 ? 0xA0 : 0x80;
+	  upper = b == 0xED ? 0x9F : 0xBF;
+	}
+	else {
+	  needed = 3;
+	  lower = b == 0xF0 ? 0x90 : 0x80;
+	  upper = b == 0xF4 ? 0x8F : 0xBF;
+	}
+	return true;
+      }
+
+      if (b < lower || b > upper)
+	return false;
+      --needed;
+      lower = 0x80; upper = 0xBF;
+      return true;
+    }
+
+    /*true when no multi byte character is left unfinished*/
+    bool isComplete() const { return needed == 0; }
+  };
+
+  /*Stream buffer which transcodes UTF-16 read from another stream
+    buffer into UTF-8, a block at a time. Invalid UTF-16 ends the
+    stream early, which hasError tells apart from its real end.*/
+  class Utf16InputBuffer : public std::streambuf {
+
+    std::streambuf* source;
+    bool bigEndian;
+    std::vector<char> inBuffer;
+    std::vector<char> outBuffer;
+    size_t pending;			//bytes left over from the last block
+    bool sourceDone;
+    bool failed;
+
+    Utf16InputBuffer(const Utf16InputBuffer&);
+    Utf16InputBuffer& operator=(const Utf16InputBuffer&);
+
+    protected:
+    int_type underflow();
+
+    public:
+    Utf16InputBuffer(std::streambuf* source, bool bigEndian);
+
+    bool hasError() const;
+  };
+
+  /*Transcodes the complete UTF-16 characters at the start of in to
+    UTF-8, advancing out, and returns how many bytes of in were used.
+    out needs room for 3 bytes per 2 bytes of in. A character cut off
+    by the end of in is left for the next call, unless last says the
+    input ends there. Invalid UTF-16 stops it and sets failed.*/
+  size_t transcodeUtf16(const unsigned char* in, size_t length, bool bigEndian, bool last, char*& out, bool& failed);
+
+  /*The input of a parse, as the tokenizer has to see it: the stream
+    itself past any UTF-8 byte order mark, or a UTF-8 view of it when
+    its byte order mark says UTF-16. Every entry point of the parser
+    reads through one, so they all accept the same documents.*/
+  class DecodedInput {
+
+    size_t markLength;		//set while encoding is read, so declared first
+    Encoding encoding;
+    std::unique_ptr<Utf16InputBuffer> transcoder;
+    std::istream transcoded;
+    std::istream* stream;
+
+    DecodedInput(const DecodedInput&);
+    DecodedInput& operator=(const DecodedInput&);
+
+    public:
+    explicit DecodedInput(std::istream& is);
+
+    /*The stream to tokenize*/
+    std::istream& get() const { return *stream; }
+
+    Encoding getEncoding() const { return encoding; }
+
+    /*Bytes of the input taken by its byte order mark*/
+    size_t getMarkLength() const { return markLength; }
+
+    /*true if the input stopped at invalid UTF-16*/
+    bool hasError() const { return transcoder && transcoder->hasError(); }
+  };
+
+}
+
+#endif
@@ -0,0 +1,504 @@
+#include "FlatDocument.h"
+#include "Document.h"
+#include "ElementNode.h"
+#include "TextNode.h"
+#include "CDATANode.h"
+#include "CommentNode.h"
+#include "Attribute.h"
+#include "XMLException.h"
+
+namespace tinyXMLpp {
+
+  const uint32_t FlatDocument::NONE;
+
+  /**
+   * Constructor which creates an empty tree, to be filled through startElement, addAttribute, endElement and addText.
+   */
+  FlatDocument::FlatDocument() : source(nullptr)
+  {
+    firstAttributes.push_back(0);
+  }
+
+  /**
+   * Constructor which flattens the tree of the given Document.
+   *
+   *@param doc The document to be flattened.
+   */
+  FlatDocument::FlatDocument(const Document& doc) : source(nullptr)
+  {
+    firstAttributes.push_back(0);
+
+    const std::vector<Node*>& children = doc.getChildren();
+    for (size_t i = 0; i < children.size(); ++i) {
+      addNode(children[i]);
+    }
+  }
+
+  /**
+   * Constructor which creates an empty tree whose text and attribute values stay in the given memory. The tree is filled
+   * with the overloads of addAttribute and addText taking offsets, so only the node arrays and the names take memory of
+   * their own.
+   *
+   *@param source The memory holding the values, which must outlive the tree.
+   */
+  FlatDocument::FlatDocument(const char* source) : source(source)
+  {
+    if (source == nullptr)
+      throw XMLException("The source of a FlatDocument cannot be null");
+    firstAttributes.push_back(0);
+  }
+
+  /**
+   * Function which appends a node of the given type as the next node in preorder, linking it to its parent and to its
+   * previous sibling.
+   *
+   *@param type The type of the new node.
+   *@return The index of the new node.
+   */
+  uint32_t FlatDocument::addNode(NodeType type)
+  {
+    uint32_t node = types.size();
+    uint32_t parent = openElements.empty() ? NONE : openElements.back();
+
+    types.push_back(type);
+    parents.push_back(parent);
+    nextSiblings.push_back(NONE);
+    subtreeEnds.push_back(node + 1);
+    values.push_back(0);
+    lengths.push_back(0);
+    firstAttributes.push_back(attributeNames.size());
+
+    /*lastChildren holds one entry per open element, plus one for the top level*/
+    if (lastChildren.empty())
+      lastChildren.push_back(NONE);
+    uint32_t& previous = lastChildren.back();
+    if (previous != NONE)
+      nextSiblings[previous] = node;
+    previous = node;
+
+    return node;
+  }
+
+  /**
+   * Function which makes sure a string of the given length can still be added to the heap. Offsets and lengths are stored
+   * in 32 bits, so the heap is limited to 4 GB; going past that throws XMLException instead of corrupting the offsets.
+   *
+   *@param length The length of the string to be added.
+   */
+  void FlatDocument::checkHeapRoom(size_t length) const
+  {
+    if (length > UINT32_MAX - heap.size())
+      throw XMLException("FlatDocument heap would exceed 4 GB");
+  }
+
+  /**
+   * Function which returns the id of a name, adding it to the name table if it is new.
+   *
+   *@param name The element or attribute name.
+   *@return The id of the name.
+   */
+  uint32_t FlatDocument::internName(const std::string& name)
+  {
+    auto it = nameIds.find(name);
+    if (it != nameIds.end())
+      return it->second;
+
+    checkHeapRoom(name.size());
+    uint32_t id = nameOffsets.size();
+    nameOffsets.push_back(heap.size());
+    nameLengths.push_back(name.size());
+    heap.append(name);
+    nameIds[name] = id;
+    return id;
+  }
+
+  /**
+   * Function which flattens a node of a Document and its subtree.
+   *
+   *@param node The node to be flattened.
+   */
+  void FlatDocument::addNode(const Node* node)
+  {
+    if (const ElementNode* elem = dynamic_cast<const ElementNode*>(node)) {
+      startElement(elem->getName());
+
+      ConstPointerList<Attribute> attribs = elem->getAttributes();
+      for (size_t i = 0; i < attribs.size(); ++i) {
+	addAttribute(attribs[i]->getName(), attribs[i]->getValue());
+      }
+
+      ConstPointerList<Node> children = node->getChildren();
+      for (size_t i = 0; i < children.size(); ++i) {
+	addNode(children[i]);
+      }
+      endElement();
+    }
+    else if (const TextNode* text = dynamic_cast<const TextNode*>(node))
+      addText(TEXT, text->getText());
+    else if (const CDATANode* cdata = dynamic_cast<const CDATANode*>(node))
+      addText(CDATA, cdata->getcdata());
+    else if (const CommentNode* comment = dynamic_cast<const CommentNode*>(node))
+      addText(COMMENT, comment->getContent());
+    else
+      throw XMLException("Unknown node type found while flattening the document");
+  }
+
+  /**
+   * Function which opens a new element as the next node. Its attributes and children follow until endElement is called.
+   *
+   *@param name The name of the element.
+   */
+  void FlatDocument::startElement(const std::string& name)
+  {
+    uint32_t node = addNode(ELEMENT);
+    values[node] = internName(name);
+    openElements.push_back(node);
+    lastChildren.push_back(NONE);
+  }
+
+  /**
+   * Function which adds an attribute to the most recently started element. Must be called before any child is added.
+   *
+   *@param name The name of the attribute.
+   *@param value The value of the attribute.
+   */
+  void FlatDocument::addAttribute(const std::string& name, const std::string& value)
+  {
+    if (openElements.empty() || openElements.back() != types.size() - 1)
+      throw XMLException("Attributes can only be added right after the element is started");
+    if (source != nullptr)
+      throw XMLException("The values of this document are in its source");
+
+    uint32_t nameId = internName(name);
+    checkHeapRoom(value.size());
+    attributeNames.push_back(nameId);
+    attributeValues.push_back(heap.size());
+    attributeLengths.push_back(value.size());
+    heap.append(value);
+    firstAttributes.back() = attributeNames.size();
+  }
+
+  /**
+   * Function which adds an attribute whose value is in the source to the most recently started element. Must be called
+   * before any child is added.
+   *
+   *@param name The name of the attribute.
+   *@param offset Where the value starts in the source.
+   *@param length The length of the value.
+   */
+  void FlatDocument::addAttribute(const std::string& name, uint32_t offset, uint32_t length)
+  {
+    if (openElements.empty() || openElements.back() != types.size() - 1)
+      throw XMLException("Attributes can only be added right after the element is started");
+    if (source == nullptr)
+      throw XMLException("This document has no source to hold the values");
+
+    attributeNames.push_back(internName(name));
+    attributeValues.push_back(offset);
+    attributeLengths.push_back(length);
+    firstAttributes.back() = attributeNames.size();
+  }
+
+  /**
+   * Function which closes the most recently started element.
+   */
+  void FlatDocument::endElement()
+  {
+    if (openElements.empty())
+      throw XMLException("Trying to close an element that was not started");
+
+    subtreeEnds[openElements.back()] = types.size();
+    openElements.pop_back();
+    lastChildren.pop_back();
+  }
+
+  /**
+   * Function which adds a text, CDATA or comment node as the next node.
+   *
+   *@param type The type of the node.
+   *@param text The content of the node.
+   */
+  void FlatDocument::addText(NodeType type, const std::string& text)
+  {
+    if (type == ELEMENT)
+      throw XMLException("Elements must be added with startElement");
+    if (source != nullptr)
+      throw XMLException("The values of this document are in its source");
+    checkHeapRoom(text.size());
+
+    uint32_t node = addNode(type);
+    values[node] = heap.size();
+    lengths[node] = text.size();
+    heap.append(text);
+  }
+
+  /**
+   * Function which adds a text, CDATA or comment node whose content is in the source as the next node.
+   *
+   *@param type The type of the node.
+   *@param offset Where the content starts in the source.
+   *@param length The length of the content.
+   */
+  void FlatDocument::addText(NodeType type, uint32_t offset, uint32_t length)
+  {
+    if (type == ELEMENT)
+      throw XMLException("Elements must be added with startElement");
+    if (source == nullptr)
+      throw XMLException("This document has no source to hold the values");
+
+    uint32_t node = addNode(type);
+    values[node] = offset;
+    lengths[node] = length;
+  }
+
+  /**
+   * Function which returns the number of nodes in the tree.
+   *
+   *@return The number of nodes.
+   */
+  uint32_t FlatDocument::size() const
+  {
+    return types.size();
+  }
+
+  /**
+   * Function which returns the type of a node.
+   *
+   *@param node The index of the node.
+   *@return The type of the node.
+   */
+  FlatDocument::NodeType FlatDocument::getType(uint32_t node) const
+  {
+    return (NodeType)types[node];
+  }
+
+  /**
+   * Function which returns the parent of a node.
+   *
+   *@param node The index of the node.
+   *@return The index of the parent, or NONE for top level nodes.
+   */
+  uint32_t FlatDocument::getParent(uint32_t node) const
+  {
+    return parents[node];
+  }
+
+  /**
+   * Function which returns the next sibling of a node.
+   *
+   *@param node The index of the node.
+   *@return The index of the next sibling, or NONE for the last child.
+   */
+  uint32_t FlatDocument::getNextSibling(uint32_t node) const
+  {
+    return nextSiblings[node];
+  }
+
+  /**
+   * Function which returns the first child of a node. In preorder it is always the node right after it.
+   *
+   *@param node The index of the node.
+   *@return The index of the first child, or NONE if the node has no children.
+   */
+  uint32_t FlatDocument::getFirstChild(uint32_t node) const
+  {
+    return subtreeEnds[node] > node + 1 ? node + 1 : NONE;
+  }
+
+  /**
+   * Function which returns the end of the subtree of a node.
+   *
+   *@param node The index of the node.
+   *@return The index one past the last descendant of the node.
+   */
+  uint32_t FlatDocument::getSubtreeEnd(uint32_t node) const
+  {
+    return subtreeEnds[node];
+  }
+
+  /**
+   * Function which returns the root element of the document.
+   *
+   *@return The index of the root element, or NONE if there is none.
+   */
+  uint32_t FlatDocument::getRootElement() const
+  {
+    for (uint32_t i = 0; i < types.size(); i = subtreeEnds[i]) {
+      if (types[i] == ELEMENT)
+	return i;
+    }
+    return NONE;
+  }
+
+  /**
+   * Function which returns the name of an element.
+   *
+   *@param node The index of the element.
+   *@return The name of the element.
+   */
+  std::string FlatDocument::getName(uint32_t node) const
+  {
+    if (types[node] != ELEMENT)
+      throw XMLException("Only elements have a name");
+    uint32_t id = values[node];
+    return heap.substr(nameOffsets[id], nameLengths[id]);
+  }
+
+  /**
+   * Function which returns the content of a text, CDATA or comment node.
+   *
+   *@param node The index of the node.
+   *@return The content of the node.
+   */
+  std::string FlatDocument::getText(uint32_t node) const
+  {
+    if (types[node] == ELEMENT)
+      throw XMLException("Elements do not have text of their own");
+    return std::string(valueData() + values[node], lengths[node]);
+  }
+
+  /**
+   * Function which returns the number of attributes of a node.
+   *
+   *@param node The index of the node.
+   *@return The number of attributes.
+   */
+  uint32_t FlatDocument::getAttributeCount(uint32_t node) const
+  {
+    return firstAttributes[node + 1] - firstAttributes[node];
+  }
+
+  /**
+   * Function which returns the name of an attribute of a node.
+   *
+   *@param node The index of the node.
+   *@param idx The index of the attribute within the node.
+   *@return The name of the attribute.
+   */
+  std::string FlatDocument::getAttributeName(uint32_t node, uint32_t idx) const
+  {
+    if (idx >= getAttributeCount(node))
+      throw XMLException("Attribute index out of range");
+    uint32_t id = attributeNames[firstAttributes[node] + idx];
+    return heap.substr(nameOffsets[id], nameLengths[id]);
+  }
+
+  /**
+   * Function which returns the value of an attribute of a node.
+   *
+   *@param node The index of the node.
+   *@param idx The index of the attribute within the node.
+   *@return The value of the attribute.
+   */
+  std::string FlatDocument::getAttributeValue(uint32_t node, uint32_t idx) const
+  {
+    if (idx >= getAttributeCount(node))
+      throw XMLException("Attribute index out of range");
+    uint32_t attr = firstAttributes[node] + idx;
+    return std::string(valueData() + attributeValues[attr], attributeLengths[attr]);
+  }
+
+  /**
+   * Function to find the first element that has an attribute with the value provided as 'id'. Walks the attribute arrays
+   * once, in document order.
+   *
+   *@param id The string being searched for inside attribute values.
+   *@return The index of the element, or NONE if there is none.
+   */
+  uint32_t FlatDocument::getElementById(const std::string& id) const
+  {
+    const char* data = valueData();
+    for (uint32_t i = 0; i < types.size(); ++i) {
+      for (uint32_t a = firstAttributes[i]; a < firstAttributes[i + 1]; ++a) {
+	if (attributeLengths[a] == id.size() && id.compare(0, id.size(), data + attributeValues[a], id.size()) == 0)
+	  return i;
+      }
+    }
+    return NONE;
+  }
+
+  /**
+   * Function to find all the elements with the given name. The name is looked up once, after which the scan only compares
+   * name ids.
+   *
+   *@param tagName The name being searched for.
+   *@return The indices of the matching elements, in document order.
+   */
+  std::vector<uint32_t> FlatDocument::getElementsByTagName(const std::string& tagName) const
+  {
+    std::vector<uint32_t> nodes;
+    auto it = nameIds.find(tagName);
+    if (it == nameIds.end())
+      return nodes;
+
+    uint32_t id = it->second;
+    for (uint32_t i = 0; i < types.size(); ++i) {
+      if (types[i] == ELEMENT && values[i] == id)
+	nodes.push_back(i);
+    }
+    return nodes;
+  }
+
+  /**
+   * Function to write the tree as XML into the given output stream. The output matches Document::write for the same tree.
+   * The tree is walked with an explicit stack, so deep documents do not recurse.
+   *
+   *@param os The output stream to which the XML should be written.
+   */
+  void FlatDocument::write(std::ostream& os) const
+  {
+    std::vector<uint32_t> open;
+    const char* data = valueData();
+
+    for (uint32_t i = 0; i < types.size(); ++i) {
+
+      while (!open.empty() && i >= subtreeEnds[open.back()]) {
+	uint32_t id = values[open.back()];
+	os << "</";
+	os.write(heap.data() + nameOffsets[id], nameLengths[id]);
+	os << '>';
+	open.pop_back();
+      }
+
+      switch (types[i]) {
+	case ELEMENT: {
+	  uint32_t id = values[i];
+	  os << '<';
+	  os.write(heap.data() + nameOffsets[id], nameLengths[id]);
+	  for (uint32_t a = firstAttributes[i]; a < firstAttributes[i + 1]; ++a) {
+	    os << ' ';
+	    os.write(heap.data() + nameOffsets[attributeNames[a]], nameLengths[attributeNames[a]]);
+	    os << "=\"";
+	    os.write(data + attributeValues[a], attributeLengths[a]);
+	    os << '"';
+	  }
+	  os << '>';
+	  open.push_back(i);
+	  break;
+	}
+	case TEXT:
+	  os.write(data + values[i], lengths[i]);
+	  break;
+	case CDATA:
+	  os << "<![CDATA[";
+	  os.write(data + values[i], lengths[i]);
+	  os << "]]>\n";
+	  break;
+	case COMMENT:
+	  os << "<!--";
+	  os.write(data + values[i], lengths[i]);
+	  os << "-->";
+	  break;
+      }
+    }
+
+    while (!open.empty()) {
+      uint32_t id = values[open.back()];
+      os << "</";
+      os.write(heap.data() + nameOffsets[id], nameLengths[id]);
+      os << '>';
+      open.pop_back();
+    }
+  }
+
+}
@@ -0,0 +1,101 @@
+#ifndef __FLATDOCUMENT_H__
+#define __FLATDOCUMENT_H__
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstdint>
+#include <unordered_map>
+
+namespace tinyXMLpp {
+
+  class Document;
+  class Node;
+
+  /*Read-optimized copy of an XML tree. Nodes are numbered in preorder
+    and each property lives in its own array, indexed by node number.
+    The descendants of node i are exactly the nodes i+1 .. subtreeEnd-1,
+    so scans over the tree are plain loops over the arrays.*/
+  class FlatDocument
+  {
+    public:
+    enum NodeType { ELEMENT, TEXT, CDATA, COMMENT };
+
+    /*Index used for a missing parent, sibling or child*/
+    static const uint32_t NONE = 0xffffffff;
+
+    private:
+    std::vector<uint8_t> types;
+    std::vector<uint32_t> parents;
+    std::vector<uint32_t> nextSiblings;
+    std::vector<uint32_t> subtreeEnds;
+    std::vector<uint32_t> values;		//name id for elements, heap offset otherwise
+    std::vector<uint32_t> lengths;		//heap length of the text, unused for elements
+    std::vector<uint32_t> firstAttributes;	//one extra entry, so the count is the difference
+
+    std::vector<uint32_t> attributeNames;
+    std::vector<uint32_t> attributeValues;
+    std::vector<uint32_t> attributeLengths;
+
+    std::vector<uint32_t> nameOffsets;
+    std::vector<uint32_t> nameLengths;
+    std::unordered_map<std::string, uint32_t> nameIds;
+
+    std::string heap;
+    const char* source;			//holds the text and attribute values instead of the heap, if set
+
+    /*Tree building state*/
+    std::vector<uint32_t> openElements;
+    std::vector<uint32_t> lastChildren;
+
+    uint32_t addNode(NodeType type);
+    uint32_t internName(const std::string& name);
+    void checkHeapRoom(size_t length) const;
+    void addNode(const Node* node);
+    const char* valueData() const { return source != nullptr ? source : heap.data(); }
+
+    public:
+    FlatDocument();
+    FlatDocument(const Document& doc);
+
+    /*A tree whose text and attribute values are read straight out of
+      the given memory, which must outlive it. Only names are copied.*/
+    explicit FlatDocument(const char* source);
+
+    /*Methods used to build the tree in document order*/
+    void startElement(const std::string& name);
+    void addAttribute(const std::string& name, const std::string& value);
+    void endElement();
+    void addText(NodeType type, const std::string& text);
+
+    /*The same for a tree made on a source, with the values given as
+      offsets into it*/
+    void addAttribute(const std::string& name, uint32_t offset, uint32_t length);
+    void addText(NodeType type, uint32_t offset, uint32_t length);
+
+    /*Structure of the tree*/
+    uint32_t size() const;
+    NodeType getType(uint32_t node) const;
+    uint32_t getParent(uint32_t node) const;
+    uint32_t getNextSibling(uint32_t node) const;
+    uint32_t getFirstChild(uint32_t node) const;
+    uint32_t getSubtreeEnd(uint32_t node) const;
+    uint32_t getRootElement() const;
+
+    /*Values of the nodes*/
+    std::string getName(uint32_t node) const;
+    std::string getText(uint32_t node) const;
+    uint32_t getAttributeCount(uint32_t node) const;
+    std::string getAttributeName(uint32_t node, uint32_t idx) const;
+    std::string getAttributeValue(uint32_t node, uint32_t idx) const;
+
+    /*Linear scans over the arrays*/
+    uint32_t getElementById(const std::string& id) const;
+    std::vector<uint32_t> getElementsByTagName(const std::string& tagName) const;
+
+    void write(std::ostream& os) const;
+  };
+
+}
+
+#endif
@@ -0,0 +1,139 @@
+#include "FrozenDocument.h"
+#include "XMLException.h"
+
+namespace tinyXMLpp {
+
+  /**
+   * Constructor which takes ownership of the document to be frozen.
+   *
+   *@param document The document holding the tree.
+   */
+  FrozenDocument::FrozenDocument(std::unique_ptr<Document> document) : document(std::move(document))
+  {
+  }
+
+  /**
+   * Function which returns the root element of the document.
+   *
+   *@return The root element, as a const ElementNode*.
+   */
+  const ElementNode* FrozenDocument::getRootElement() const
+  {
+    return this->document->getRootElement();
+  }
+
+  /**
+   * Function which returns the number of top level nodes of the document.
+   *
+   *@return The number of top level nodes.
+   */
+  int FrozenDocument::getChildCount() const
+  {
+    return this->document->getChildren().size();
+  }
+
+  /**
+   * Function which returns the top level node at the given index. Throws XMLException if there is no such node.
+   *
+   *@param index The index of the top level node.
+   *@return A pointer to the const node.
+   */
+  const Node* FrozenDocument::getChild(int index) const
+  {
+    const std::vector<Node*>& children = this->document->getChildren();
+    if (index < 0 || (size_t)index >= children.size())
+      throw XMLException("\nError! Trying to get a child node from an index that doesn't exist");
+    return children[index];
+  }
+
+  /**
+   * Function to find the first element that has an attribute with the value provided as 'id'.
+   *
+   *@param id The string being searched for inside attribute values.
+   *@return A pointer to the const ElementNode, or nullptr if there is none.
+   */
+  const ElementNode* FrozenDocument::getElementById(const std::string& id) const
+  {
+    const Document& doc = *this->document;
+    return doc.getElementById(id);
+  }
+
+  /**
+   * Function to find all the elements whose name is the given tag name.
+   *
+   *@param tagName The name being searched for.
+   *@return A vector of const ElementNode* holding the matching elements, in document order.
+   */
+  std::vector<const ElementNode*> FrozenDocument::getElementsByTagName(const std::string& tagName) const
+  {
+    const Document& doc = *this->document;
+    return doc.getElementsByTagName(tagName);
+  }
+
+  /**
+   * Function to find all the elements in a namespace with the given local name.
+   *
+   *@param namespaceURI The namespace URI being searched for, empty for elements in no namespace.
+   *@param localName The name being searched for, without prefix.
+   *@return A vector of const ElementNode* holding the matching elements, in document order.
+   */
+  std::vector<const ElementNode*> FrozenDocument::getElementsByTagNameNS(const std::string& namespaceURI,
+      const std::string& localName) const
+  {
+    const Document& doc = *this->document;
+    return doc.getElementsByTagNameNS(namespaceURI, localName);
+  }
+
+  /**
+   * Function which returns the structural hash of the document.
+   *
+   *@return The hash of the document.
+   */
+  uint64_t FrozenDocument::getHash() const
+  {
+    return this->document->getHash();
+  }
+
+  /**
+   * Function which checks whether two frozen documents hold the same nodes.
+   *
+   *@param other The document to compare with.
+   *@return true if both documents have the same nodes in the same order.
+   */
+  bool FrozenDocument::equals(const FrozenDocument& other) const
+  {
+    return this->document->equals(*other.document);
+  }
+
+  /**
+   * Function which copies the frozen tree into a new Document that can be changed. Only the frozen tree is read, so this
+   * may run while other threads query it. The hashes come along, so freezing the copy again only rehashes what changed.
+   *
+   *@return A unique_ptr to the copy.
+   */
+  std::unique_ptr<Document> FrozenDocument::thaw() const
+  {
+    return this->document->clone();
+  }
+
+  /**
+   * Function to write the document into a file at the given path.
+   *
+   *@param path The path to the output file.
+   */
+  void FrozenDocument::write(const std::string& path) const
+  {
+    this->document->write(path);
+  }
+
+  /**
+   * Function to write the document into the given output stream.
+   *
+   *@param os The output stream.
+   */
+  void FrozenDocument::write(std::ostream& os) const
+  {
+    this->document->write(os);
+  }
+
+}
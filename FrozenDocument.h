@@ -0,0 +1,54 @@
+#ifndef __FROZENDOCUMENT_H__
+#define __FROZENDOCUMENT_H__
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <ostream>
+#include "Document.h"
+
+namespace tinyXMLpp {
+
+  /*Immutable Document made by Document::freeze(). It only hands out
+    const nodes, and a const node only leads to other const nodes: its
+    children, attributes, parent and siblings all come out const. None
+    of its methods modify the tree or any cached state, so any number
+    of threads may query and write it at the same time without locking.*/
+  class FrozenDocument
+  {
+    std::unique_ptr<Document> document;
+
+    FrozenDocument(std::unique_ptr<Document> document);
+    FrozenDocument(const FrozenDocument&);
+    FrozenDocument& operator=(const FrozenDocument&);
+
+    friend class Document;
+
+    public:
+    /*Returns the XML document element(node)*/
+    const ElementNode* getRootElement() const;
+
+    /*Access to the top level nodes*/
+    int getChildCount() const;
+    const Node* getChild(int index) const;
+
+    /*Queries over the tree*/
+    const ElementNode* getElementById(const std::string& id) const;
+    std::vector<const ElementNode*> getElementsByTagName(const std::string& tagName) const;
+    std::vector<const ElementNode*> getElementsByTagNameNS(const std::string& namespaceURI, const std::string& localName) const;
+
+    /*Hashes were computed by freeze, so these only read the tree*/
+    uint64_t getHash() const;
+    bool equals(const FrozenDocument& other) const;
+
+    /*Mutable copy of the tree, to make the next version from*/
+    std::unique_ptr<Document> thaw() const;
+
+    /*Write the XML DOM to a stream or file*/
+    void write(const std::string& path) const;
+    void write(std::ostream& os) const;
+  };
+
+}
+
+#endif
@@ -0,0 +1,224 @@
+#include "GzipStream.h"
+#include "XMLException.h"
+
+#include <cstring>
+
+namespace tinyXMLpp {
+
+  namespace {
+    /*Bytes kept in front of each inflated block so the tokenizer can push back characters across a refill*/
+    const size_t PUTBACK_SIZE = 16;
+    const size_t BLOCK_SIZE = 64 * 1024;
+  }
+
+  /**
+   * Constructor which prepares zlib to inflate the data read from source. Both gzip and zlib headers are accepted.
+   *
+   *@param source The stream buffer holding the compressed data.
+   */
+  GzipInputBuffer::GzipInputBuffer(std::streambuf* source)
+    : source(source), inBuffer(BLOCK_SIZE), outBuffer(BLOCK_SIZE + PUTBACK_SIZE), sourceDone(false), memberEnded(false)
+  {
+    memset(&zs, 0, sizeof(zs));
+    if (inflateInit2(&zs, 15 + 32) != Z_OK)
+      throw XMLException("Unable to initialize zlib for decompression");
+
+    char* start = &outBuffer[0] + PUTBACK_SIZE;
+    setg(start, start, start);
+  }
+
+  /**
+   * Destructor
+   */
+  GzipInputBuffer::~GzipInputBuffer()
+  {
+    inflateEnd(&zs);
+  }
+
+  /**
+   * Function which refills the get area by inflating the next block of compressed data. The last few characters of the
+   * previous block are kept in front of the new one so that putback keeps working.
+   *
+   *@return The next character, or eof when the compressed data has been fully read.
+   */
+  GzipInputBuffer::int_type GzipInputBuffer::underflow()
+  {
+    if (gptr() < egptr())
+      return traits_type::to_int_type(*gptr());
+
+    size_t keep = gptr() - eback();
+    if (keep > PUTBACK_SIZE)
+      keep = PUTBACK_SIZE;
+
+    char* start = &outBuffer[0] + PUTBACK_SIZE;
+    memmove(start - keep, gptr() - keep, keep);
+
+    zs.next_out = reinterpret_cast<Bytef*>(start);
+    zs.avail_out = outBuffer.size() - PUTBACK_SIZE;
+
+    while (reinterpret_cast<char*>(zs.next_out) == start) {
+
+      if (zs.avail_in == 0 && !sourceDone) {
+	std::streamsize n = source->sgetn(&inBuffer[0], inBuffer.size());
+	if (n <= 0)
+	  sourceDone = true;
+	zs.next_in = reinterpret_cast<Bytef*>(&inBuffer[0]);
+	zs.avail_in = n > 0 ? n : 0;
+      }
+
+      if (zs.avail_in == 0 && sourceDone) {
+	if (!memberEnded && zs.total_in > 0)
+	  throw XMLException("Unexpected end of compressed input");
+	break;
+      }
+
+      /*Concatenated gzip members are read as one stream*/
+      if (memberEnded) {
+	inflateReset(&zs);
+	memberEnded = false;
+      }
+
+      int ret = inflate(&zs, Z_NO_FLUSH);
+      if (ret == Z_STREAM_END)
+	memberEnded = true;
+      else if (ret != Z_OK && ret != Z_BUF_ERROR)
+	throw XMLException("Corrupt compressed input");
+    }
+
+    setg(start - keep, start, reinterpret_cast<char*>(zs.next_out));
+
+    if (gptr() == egptr())
+      return traits_type::eof();
+    return traits_type::to_int_type(*gptr());
+  }
+
+  /**
+   * Function which checks whether a stream starts with a gzip header. The stream is left at the position it had when the
+   * function was called. A zlib header is only two bytes whose check matches one in 31 pairs, "x^" among them, so it is
+   * only looked for when the caller expects zlib data.
+   *
+   *@param is The input stream to be checked.
+   *@param detectZlib true to accept a zlib header as well.
+   *@return A bool value set to true if the stream holds compressed data.
+   */
+  bool GzipInputBuffer::isCompressed(std::istream& is, bool detectZlib)
+  {
+    std::streampos start = is.tellg();
+    int c1 = is.get();
+    int c2 = is.get();
+    is.clear();
+    is.seekg(start);
+
+    if (c1 == 0x1f && c2 == 0x8b)
+      return true;
+    if (!detectZlib)
+      return false;
+
+    /*zlib header: deflate method, and the first two bytes form a multiple of 31*/
+    return c1 != -1 && c2 != -1 && (c1 & 0x0f) == 8 && (c1 >> 4) <= 7 && ((c1 << 8) | c2) % 31 == 0;
+  }
+
+  /**
+   * Constructor which prepares zlib to write gzip data into sink.
+   *
+   *@param sink The stream buffer that receives the compressed data.
+   *@param level The zlib compression level.
+   */
+  GzipOutputBuffer::GzipOutputBuffer(std::streambuf* sink, int level)
+    : sink(sink), inBuffer(BLOCK_SIZE), outBuffer(BLOCK_SIZE), finished(false)
+  {
+    memset(&zs, 0, sizeof(zs));
+    if (deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+      throw XMLException("Unable to initialize zlib for compression");
+
+    setp(&inBuffer[0], &inBuffer[0] + inBuffer.size());
+  }
+
+  /**
+   * Destructor. Writes the gzip trailer if finish was not called.
+   */
+  GzipOutputBuffer::~GzipOutputBuffer()
+  {
+    finish();
+    deflateEnd(&zs);
+  }
+
+  /**
+   * Function which compresses the pending characters of the put area and writes the result to the sink.
+   *
+   *@param flush The zlib flush mode.
+   *@return A bool value set to false if the sink could not take the data.
+   */
+  bool GzipOutputBuffer::deflateBuffer(int flush)
+  {
+    zs.next_in = reinterpret_cast<Bytef*>(pbase());
+    zs.avail_in = pptr() - pbase();
+
+    int ret;
+    do {
+      zs.next_out = reinterpret_cast<Bytef*>(&outBuffer[0]);
+      zs.avail_out = outBuffer.size();
+
+      ret = deflate(&zs, flush);
+      if (ret == Z_STREAM_ERROR)
+	return false;
+
+      std::streamsize n = outBuffer.size() - zs.avail_out;
+      if (n > 0 && sink->sputn(&outBuffer[0], n) != n)
+	return false;
+
+    } while (zs.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+
+    setp(&inBuffer[0], &inBuffer[0] + inBuffer.size());
+    return true;
+  }
+
+  /**
+   * Function called when the put area is full. Compresses the block and starts a new one.
+   *
+   *@param c The character that did not fit in the put area.
+   *@return eof on failure, anything else on success.
+   */
+  GzipOutputBuffer::int_type GzipOutputBuffer::overflow(int_type c)
+  {
+    if (finished || !deflateBuffer(Z_NO_FLUSH))
+      return traits_type::eof();
+
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+    }
+    return traits_type::not_eof(c);
+  }
+
+  /**
+   * Function which hands the pending characters to zlib and flushes the sink.
+   *
+   *@return 0 on success, -1 on failure.
+   */
+  int GzipOutputBuffer::sync()
+  {
+    if (finished)
+      return 0;
+    if (!deflateBuffer(Z_NO_FLUSH))
+      return -1;
+    return sink->pubsync();
+  }
+
+  /**
+   * Function which compresses everything that is still pending and writes the gzip trailer. Nothing can be written after it.
+   *
+   *@return A bool value set to false if the data could not be written.
+   */
+  bool GzipOutputBuffer::finish()
+  {
+    if (finished)
+      return true;
+    finished = true;
+
+    if (!deflateBuffer(Z_FINISH))
+      return false;
+    return sink->pubsync() == 0;
+  }
+
+}
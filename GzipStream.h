@@ -0,0 +1,67 @@
+#ifndef __GZIPSTREAM_H__
+#define __GZIPSTREAM_H__
+
+#include <streambuf>
+#include <istream>
+#include <vector>
+#include <zlib.h>
+
+namespace tinyXMLpp{
+
+  /*Stream buffer which inflates gzip or zlib data read from
+    another stream buffer, a block at a time*/
+  class GzipInputBuffer : public std::streambuf {
+
+    std::streambuf* source;
+    z_stream zs;
+    std::vector<char> inBuffer;
+    std::vector<char> outBuffer;
+    bool sourceDone;
+    bool memberEnded;
+
+    GzipInputBuffer(const GzipInputBuffer&);
+    GzipInputBuffer& operator=(const GzipInputBuffer&);
+
+    protected:
+    int_type underflow();
+
+    public:
+    GzipInputBuffer(std::streambuf* source);
+    ~GzipInputBuffer();
+
+    /*Checks the leading bytes of the stream for a gzip header, or a
+      zlib header when detectZlib is set, leaving the stream at its
+      start*/
+    static bool isCompressed(std::istream& is, bool detectZlib = false);
+  };
+
+  /*Stream buffer which deflates everything written to it into
+    gzip data on another stream buffer*/
+  class GzipOutputBuffer : public std::streambuf {
+
+    std::streambuf* sink;
+    z_stream zs;
+    std::vector<char> inBuffer;
+    std::vector<char> outBuffer;
+    bool finished;
+
+    GzipOutputBuffer(const GzipOutputBuffer&);
+    GzipOutputBuffer& operator=(const GzipOutputBuffer&);
+
+    bool deflateBuffer(int flush);
+
+    protected:
+    int_type overflow(int_type c);
+    int sync();
+
+    public:
+    GzipOutputBuffer(std::streambuf* sink, int level = Z_DEFAULT_COMPRESSION);
+    ~GzipOutputBuffer();
+
+    /*Flushes the pending data and writes the gzip trailer*/
+    bool finish();
+  };
+
+}
+
+#endif
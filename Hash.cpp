@@ -0,0 +1,66 @@
+#include "Hash.h"
+
+#include <cstring>
+
+namespace tinyXMLpp {
+
+  namespace {
+
+    const uint64_t MULTIPLIER_1 = 0x87C37B91114253D5ULL;
+    const uint64_t MULTIPLIER_2 = 0x4CF5AD432745937FULL;
+
+    inline uint64_t rotateLeft(uint64_t x, int bits)
+    {
+      return (x << bits) | (x >> (64 - bits));
+    }
+
+    /*Final avalanche, so every input bit affects every output bit*/
+    inline uint64_t finalize(uint64_t h)
+    {
+      h ^= h >> 33;
+      h *= 0xFF51AFD7ED558CCDULL;
+      h ^= h >> 33;
+      h *= 0xC4CEB9FE1A85EC53ULL;
+      h ^= h >> 33;
+      return h;
+    }
+  }
+
+  /**
+   * Function which hashes a block of bytes. Whole 64 bit words are mixed in one multiply-rotate step each, and the last few
+   * bytes are packed into one more word.
+   *
+   *@param data The bytes to be hashed.
+   *@param length The number of bytes.
+   *@param seed A value mixed into the hash first, to tell apart hashes of different kinds of data.
+   *@return The hash.
+   */
+  uint64_t hashBytes(const void* data, size_t length, uint64_t seed)
+  {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t h = seed ^ (length * MULTIPLIER_2);
+
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+      uint64_t k;
+      memcpy(&k, bytes + i, sizeof(k));
+      k *= MULTIPLIER_1;
+      k = rotateLeft(k, 31);
+      k *= MULTIPLIER_2;
+      h ^= k;
+      h = rotateLeft(h, 27) * 5 + 0x52DCE729;
+    }
+
+    uint64_t tail = 0;
+    for (size_t shift = 0; i < length; ++i, shift += 8) {
+      tail |= (uint64_t)bytes[i] << shift;
+    }
+    tail *= MULTIPLIER_1;
+    tail = rotateLeft(tail, 31);
+    tail *= MULTIPLIER_2;
+    h ^= tail;
+
+    return finalize(h);
+  }
+
+}
@@ -0,0 +1,28 @@
+#ifndef __HASH_H__
+#define __HASH_H__
+
+#include <string>
+#include <cstdint>
+
+namespace tinyXMLpp {
+
+  /*64 bit hash of a block of bytes, reading it eight bytes at a time.
+    Used for the structural hashes of nodes; it is not meant to resist
+    collisions crafted on purpose.*/
+  uint64_t hashBytes(const void* data, size_t length, uint64_t seed);
+
+  inline uint64_t hashString(const std::string& str, uint64_t seed)
+  {
+    return hashBytes(str.data(), str.size(), seed);
+  }
+
+  /*Mixes a value into a running hash. The order of the values matters.*/
+  inline uint64_t hashCombine(uint64_t hash, uint64_t value)
+  {
+    hash ^= value + 0x9E3779B97F4A7C15ULL + (hash << 6) + (hash >> 2);
+    return hash * 0xFF51AFD7ED558CCDULL;
+  }
+
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef __MEMORYINPUTBUFFER_H__
+#define __MEMORYINPUTBUFFER_H__
+
+#include <streambuf>
+#include <cstddef>
+
+namespace tinyXMLpp{
+
+  /*Stream buffer which reads straight out of a caller owned block of
+    memory, so an in-memory document can be tokenized without copying
+    it into a stringstream. The memory must outlive the buffer.*/
+  class MemoryInputBuffer : public std::streambuf {
+
+    protected:
+    /*Seeking lets a failed parse read the input again to find the
+      line of the error*/
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+      char* base = dir == std::ios_base::beg ? eback() : dir == std::ios_base::cur ? gptr() : egptr();
+      if (!(which & std::ios_base::in) || off < eback() - base || off > egptr() - base)
+	return pos_type(off_type(-1));
+      setg(eback(), base + off, egptr());
+      return pos_type(gptr() - eback());
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) {
+      return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+
+    public:
+    MemoryInputBuffer(const char* data, size_t length) {
+      char* start = const_cast<char*>(data);
+      setg(start, start, start + length);
+    }
+
+    /*The part of the memory not read yet*/
+    const char* getPosition() const { return gptr(); }
+    size_t getRemaining() const { return egptr() - gptr(); }
+  };
+
+}
+
+#endif
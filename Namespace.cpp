@@ -0,0 +1,371 @@
+#include "Namespace.h"
+#include "XMLException.h"
+
+#include <cstring>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <unordered_map>
+
+namespace tinyXMLpp {
+
+  namespace {
+
+    const char XML_URI[] = "http://www.w3.org/XML/1998/namespace";
+    const char XMLNS_URI[] = "http://www.w3.org/2000/xmlns/";
+
+    /*Ids below this one are built in and never dropped*/
+    const uint32_t FIRST_COUNTED = NamespaceTable::XMLNS_NAMESPACE + 1;
+
+    struct UriEntry {
+      std::string uri;
+      std::atomic<uint32_t> references;
+      bool used;
+    };
+
+    /*Entries are allocated in chunks that never move, so an entry can be reached without the lock by anyone holding a
+      reference to it. The lock guards adding and dropping URIs.*/
+    struct UriTable {
+      static const uint32_t CHUNK_SIZE = 1024;
+
+      std::mutex lock;
+      std::unique_ptr<UriEntry[]> chunks[NamespaceTable::MAX_NAMESPACES / CHUNK_SIZE];
+      std::atomic<uint32_t> size;				//entries ever handed out
+      std::vector<uint32_t> unused;				//ids of dropped entries, given out again first
+      std::unordered_map<std::string, uint32_t> ids;
+
+      UriTable() : size(0) {
+	add("");
+	add(XML_URI);
+	add(XMLNS_URI);
+      }
+
+      UriEntry& entry(uint32_t id) {
+	return chunks[id / CHUNK_SIZE][id % CHUNK_SIZE];
+      }
+
+      /*Called with the lock held. The new entry has one reference.*/
+      uint32_t add(const std::string& uri) {
+	uint32_t id;
+	if (!unused.empty()) {
+	  id = unused.back();
+	  unused.pop_back();
+	}
+	else {
+	  id = size.load(std::memory_order_relaxed);
+	  if (id % CHUNK_SIZE == 0)
+	    chunks[id / CHUNK_SIZE].reset(new UriEntry[CHUNK_SIZE]());
+	  size.store(id + 1, std::memory_order_release);
+	}
+	UriEntry& e = entry(id);
+	e.uri = uri;
+	e.references.store(1);
+	e.used = true;
+	ids.insert(std::make_pair(uri, id));
+	return id;
+      }
+    };
+
+    UriTable& uriTable()
+    {
+      static UriTable table;
+      return table;
+    }
+
+    const size_t MALFORMED = std::string::npos - 1;
+
+    /*Returns the position of the colon separating prefix and local name, npos if there is none, or MALFORMED*/
+    size_t findColon(const std::string& qname)
+    {
+      size_t colon = qname.find(':');
+      if (colon == std::string::npos)
+	return colon;
+      if (colon == 0 || colon + 1 == qname.size() || qname.find(':', colon + 1) != std::string::npos)
+	return MALFORMED;
+      return colon;
+    }
+  }
+
+  /**
+   * Function which returns the id of a namespace URI, giving it a new one if no node uses the URI yet. The caller gets a
+   * reference to the entry and must give it back with release. It may be called from any thread.
+   *
+   *@param uri The namespace URI.
+   *@return The id of the URI, INVALID_NAMESPACE if the table is full.
+   */
+  uint32_t NamespaceTable::intern(const std::string& uri)
+  {
+    if (uri.empty())
+      return NO_NAMESPACE;
+
+    UriTable& table = uriTable();
+    std::lock_guard<std::mutex> guard(table.lock);
+
+    std::unordered_map<std::string, uint32_t>::const_iterator it = table.ids.find(uri);
+    if (it != table.ids.end()) {
+      if (it->second >= FIRST_COUNTED)
+	table.entry(it->second).references.fetch_add(1);
+      return it->second;
+    }
+    if (table.unused.empty() && table.size.load(std::memory_order_relaxed) >= MAX_NAMESPACES)
+      return INVALID_NAMESPACE;
+    return table.add(uri);
+  }
+
+  /**
+   * Function which takes one more reference to an entry. The caller must hold one already, so the entry cannot be dropped
+   * meanwhile and no lock is needed.
+   *
+   *@param id The namespace id.
+   */
+  void NamespaceTable::retain(uint32_t id)
+  {
+    if (id < FIRST_COUNTED || id >= MAX_NAMESPACES)
+      return;
+    uriTable().entry(id).references.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * Function which gives back a reference to an entry. The last one drops the URI and frees its id. intern may have revived
+   * the entry between the count reaching zero and the lock being taken, so the count is checked again under the lock.
+   *
+   *@param id The namespace id.
+   */
+  void NamespaceTable::release(uint32_t id)
+  {
+    if (id < FIRST_COUNTED || id >= MAX_NAMESPACES)
+      return;
+
+    UriTable& table = uriTable();
+    UriEntry& entry = table.entry(id);
+    if (entry.references.fetch_sub(1, std::memory_order_acq_rel) != 1)
+      return;
+
+    std::lock_guard<std::mutex> guard(table.lock);
+    if (!entry.used || entry.references.load() != 0)
+      return;
+    table.ids.erase(entry.uri);
+    entry.uri.clear();
+    entry.used = false;
+    table.unused.push_back(id);
+  }
+
+  /**
+   * Function which returns the id of a namespace URI without adding it to the table. It may be called from any thread.
+   *
+   *@param uri The namespace URI.
+   *@return The id of the URI, INVALID_NAMESPACE if it is not in use.
+   */
+  uint32_t NamespaceTable::find(const std::string& uri)
+  {
+    if (uri.empty())
+      return NO_NAMESPACE;
+
+    UriTable& table = uriTable();
+    std::lock_guard<std::mutex> guard(table.lock);
+
+    std::unordered_map<std::string, uint32_t>::const_iterator it = table.ids.find(uri);
+    return it != table.ids.end() ? it->second : INVALID_NAMESPACE;
+  }
+
+  /**
+   * Function which returns the namespace URI an id was given to.
+   *
+   *@param id An id the caller holds a reference to, or a built in one.
+   *@return The namespace URI, empty for NO_NAMESPACE.
+   */
+  const std::string& NamespaceTable::getURI(uint32_t id)
+  {
+    UriTable& table = uriTable();
+    if (id >= table.size.load(std::memory_order_acquire) || !table.entry(id).used)
+      throw XMLException("Unknown namespace id");
+    return table.entry(id).uri;
+  }
+
+  /**
+   * Constructor. Only the xml prefix is bound, and unprefixed names are in no namespace.
+   */
+  NamespaceScope::NamespaceScope() : maxURIs(ParseLimits().maxNamespaces)
+  {
+    clear();
+  }
+
+  /**
+   * Destructor, giving back the references to the URIs declared.
+   */
+  NamespaceScope::~NamespaceScope()
+  {
+    clear();
+  }
+
+  /**
+   * Function which drops every open scope and the bindings they hold. The nodes built meanwhile hold references of their
+   * own, so the URIs they use stay in the table.
+   */
+  void NamespaceScope::clear()
+  {
+    bindings.clear();
+    marks.clear();
+    for (std::unordered_map<std::string, uint32_t>::const_iterator it = known.begin(); it != known.end(); ++it)
+      NamespaceTable::release(it->second);
+    known.clear();
+    bind("xml", 3, NamespaceTable::XML_NAMESPACE);
+  }
+
+  /**
+   * Function which sets how many distinct URIs may be declared between two calls of clear, so a single document cannot
+   * fill the NamespaceTable that every parser shares.
+   *
+   *@param maxURIs The most URIs.
+   */
+  void NamespaceScope::setMaxURIs(size_t maxURIs)
+  {
+    this->maxURIs = maxURIs;
+  }
+
+  /**
+   * Function which opens the scope of a new element.
+   */
+  void NamespaceScope::push()
+  {
+    marks.push_back(bindings.size());
+  }
+
+  /**
+   * Function which closes the scope of the innermost element, dropping the bindings declared on it.
+   */
+  void NamespaceScope::pop()
+  {
+    if (marks.empty())
+      return;
+    bindings.resize(marks.back());
+    marks.pop_back();
+  }
+
+  /**
+   * Function which adds a binding to the innermost scope, hiding any outer binding of the same prefix.
+   *
+   *@param prefix The prefix, not null terminated.
+   *@param length The length of the prefix.
+   *@param id The namespace id it is bound to.
+   */
+  void NamespaceScope::bind(const char* prefix, size_t length, uint32_t id)
+  {
+    Binding binding;
+    binding.prefix.assign(prefix, length);
+    binding.id = id;
+    bindings.push_back(std::move(binding));
+  }
+
+  /**
+   * Function which returns the id of a declared URI. Each scope remembers the ids it was given until it is cleared, so a
+   * parser only takes the lock of the NamespaceTable the first time a document declares a URI rather than for every
+   * declaration.
+   *
+   *@param uri The namespace URI.
+   *@return The id of the URI, INVALID_NAMESPACE if it is one URI too many.
+   */
+  uint32_t NamespaceScope::intern(const std::string& uri)
+  {
+    std::unordered_map<std::string, uint32_t>::const_iterator it = known.find(uri);
+    if (it != known.end())
+      return it->second;
+    if (known.size() >= maxURIs)
+      return NamespaceTable::INVALID_NAMESPACE;
+
+    uint32_t id = NamespaceTable::intern(uri);
+    if (id != NamespaceTable::INVALID_NAMESPACE)
+      known.insert(std::make_pair(uri, id));
+    return id;
+  }
+
+  /**
+   * Function which finds the innermost binding of a prefix.
+   *
+   *@param prefix The prefix, not null terminated.
+   *@param length The length of the prefix.
+   *@return The namespace id bound to it, INVALID_NAMESPACE if it is not bound.
+   */
+  uint32_t NamespaceScope::lookup(const char* prefix, size_t length) const
+  {
+    for (size_t i = bindings.size(); i > 0; --i) {
+      const Binding& binding = bindings[i - 1];
+      if (binding.prefix.size() == length && memcmp(binding.prefix.data(), prefix, length) == 0)
+	return binding.id;
+    }
+
+    /*without a declaration the default namespace is none*/
+    if (length == 0)
+      return NamespaceTable::NO_NAMESPACE;
+    return NamespaceTable::INVALID_NAMESPACE;
+  }
+
+  /**
+   * Function which binds a prefix in the innermost scope if the attribute is a namespace declaration, xmlns="uri" or
+   * xmlns:prefix="uri". Must be called for all the attributes of an element before any name of it is resolved.
+   *
+   *@param attrName The name of the attribute.
+   *@param value The value of the attribute.
+   *@return PARSE_OK, or what is wrong with the declaration.
+   */
+  ParseErrorCode NamespaceScope::declare(const std::string& attrName, const std::string& value)
+  {
+    if (attrName.compare(0, 5, "xmlns") != 0)
+      return PARSE_OK;
+
+    const char* prefix = "";
+    size_t length = 0;
+
+    if (attrName.size() > 5) {
+      if (attrName[5] != ':')
+	return PARSE_OK;
+      prefix = attrName.data() + 6;
+      length = attrName.size() - 6;
+      /*xmlns cannot be declared, and a prefix cannot be bound to the empty URI*/
+      if (length == 0 || (length == 5 && memcmp(prefix, "xmlns", 5) == 0) || value.empty())
+	return INVALID_NAMESPACE_DECLARATION;
+    }
+
+    uint32_t id = intern(value);
+    if (id == NamespaceTable::INVALID_NAMESPACE)
+      return NAMESPACE_LIMIT_EXCEEDED;
+    bind(prefix, length, id);
+    return PARSE_OK;
+  }
+
+  /**
+   * Function which resolves the namespace of an element name. Unprefixed names are in the default namespace.
+   *
+   *@param qname The qualified name of the element.
+   *@return The namespace id.
+   */
+  uint32_t NamespaceScope::resolveElement(const std::string& qname) const
+  {
+    size_t colon = findColon(qname);
+    if (colon == MALFORMED)
+      return NamespaceTable::INVALID_NAMESPACE;
+    if (colon == std::string::npos)
+      return lookup("", 0);
+    return lookup(qname.data(), colon);
+  }
+
+  /**
+   * Function which resolves the namespace of an attribute name. Unprefixed attributes are in no namespace, and namespace
+   * declarations themselves are in the xmlns namespace.
+   *
+   *@param qname The qualified name of the attribute.
+   *@return The namespace id.
+   */
+  uint32_t NamespaceScope::resolveAttribute(const std::string& qname) const
+  {
+    size_t colon = findColon(qname);
+    if (colon == MALFORMED)
+      return NamespaceTable::INVALID_NAMESPACE;
+    if (colon == std::string::npos)
+      return qname == "xmlns" ? NamespaceTable::XMLNS_NAMESPACE : NamespaceTable::NO_NAMESPACE;
+    if (colon == 5 && qname.compare(0, 5, "xmlns") == 0)
+      return NamespaceTable::XMLNS_NAMESPACE;
+    return lookup(qname.data(), colon);
+  }
+
+}
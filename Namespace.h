@@ -0,0 +1,102 @@
+#ifndef __NAMESPACE_H__
+#define __NAMESPACE_H__
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "ParseError.h"
+#include "ParseLimits.h"
+
+namespace tinyXMLpp {
+
+  /*Process wide table of namespace URIs. Each URI is given a small
+    id the first time it is seen, so nodes store an integer and
+    namespace checks are integer comparisons. Ids can be compared
+    across documents. Every element or attribute in a namespace holds
+    a reference to its entry, and a URI is dropped with the last node
+    that uses it, so documents that are gone do not keep the table
+    full. At most MAX_NAMESPACES URIs are in use at once.*/
+  class NamespaceTable {
+
+    public:
+    static const uint32_t NO_NAMESPACE = 0;
+    static const uint32_t XML_NAMESPACE = 1;
+    static const uint32_t XMLNS_NAMESPACE = 2;
+    static const uint32_t INVALID_NAMESPACE = 0xFFFFFFFF;	//returned for names that cannot be resolved
+    static const uint32_t MAX_NAMESPACES = 65536;
+
+    /*Returns the id of the URI, adding it if it is new, with a
+      reference the caller gives back with release. The empty URI is
+      NO_NAMESPACE. Returns INVALID_NAMESPACE when a new URI does not
+      fit in the table.*/
+    static uint32_t intern(const std::string& uri);
+
+    /*Take and give back a reference to an entry. retain needs one
+      held already; the built in ids and INVALID_NAMESPACE are not
+      counted.*/
+    static void retain(uint32_t id);
+    static void release(uint32_t id);
+
+    /*Returns the id of a URI in use, INVALID_NAMESPACE if no node
+      uses it. Queries use it so they do not fill the table.*/
+    static uint32_t find(const std::string& uri);
+
+    /*Returns the URI an id stands for*/
+    static const std::string& getURI(uint32_t id);
+  };
+
+  /*Stack of the prefix bindings in scope at the current element.
+    Each element opens a scope, which its end tag closes again along
+    with the bindings declared on it.*/
+  class NamespaceScope {
+
+    struct Binding {
+      std::string prefix;		//empty for the default namespace
+      uint32_t id;
+    };
+
+    std::vector<Binding> bindings;
+    std::vector<size_t> marks;		//size of bindings when each open scope started
+    std::unordered_map<std::string, uint32_t> known;	//URIs declared since clear, each holding a reference
+    size_t maxURIs;
+
+    uint32_t intern(const std::string& uri);
+
+    void bind(const char* prefix, size_t length, uint32_t id);
+    uint32_t lookup(const char* prefix, size_t length) const;
+
+    public:
+    NamespaceScope();
+    ~NamespaceScope();
+    NamespaceScope(const NamespaceScope&) = delete;
+    NamespaceScope& operator=(const NamespaceScope&) = delete;
+
+    void push();
+    void pop();
+
+    /*Drops every scope, leaving only the built in xml prefix, and
+      the references to the URIs declared in them*/
+    void clear();
+
+    /*Most distinct URIs declared between two calls of clear,
+      ParseLimits::maxNamespaces*/
+    void setMaxURIs(size_t maxURIs);
+
+    /*Binds the prefix if the attribute is a namespace declaration.
+      Returns INVALID_NAMESPACE_DECLARATION for declarations that are
+      not allowed, and NAMESPACE_LIMIT_EXCEEDED when the URI is one
+      more than setMaxURIs allows or does not fit in the
+      NamespaceTable.*/
+    ParseErrorCode declare(const std::string& attrName, const std::string& value);
+
+    /*Namespace ids of qualified names. Unprefixed elements are in the
+      default namespace, unprefixed attributes in none. Unbound
+      prefixes and malformed names give INVALID_NAMESPACE.*/
+    uint32_t resolveElement(const std::string& qname) const;
+    uint32_t resolveAttribute(const std::string& qname) const;
+  };
+
+}
+
+#endif
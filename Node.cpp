@@ -1,5 +1,8 @@
 #include "Node.h"
 #include "XMLException.h"
+#include "Hash.h"
+#include <ostream>
+#include <typeinfo>
 
 namespace tinyXMLpp{
 
@@ -10,6 +13,10 @@ namespace tinyXMLpp{
     this->numberOfChildren = 0;
     this->parentNode = nullptr;
     this->nextSibling = this->previousSibling = nullptr;
+    this->sourceOffset = this->sourceLength = 0;
+    this->dirty = true;
+    this->hash = 0;
+    this->hashValid = false;
   }
 
   /**
@@ -27,30 +34,88 @@ namespace tinyXMLpp{
    *
    *@return A vector of Node* containing pointers to all the child nodes of the current Node.
    */
-  const std::vector<Node*>& Node::getChildren() const{
+  const std::vector<Node*>& Node::getChildren(){
     return childNodes;
   }
 
+  /**
+   * Function which returns the child nodes of a const Node, each as a const Node*.
+   *
+   *@return A read-only view of the child list.
+   */
+  ConstPointerList<Node> Node::getChildren() const{
+    return ConstPointerList<Node>(childNodes);
+  }
+
+  /**
+   * Function which returns the number of child nodes of the current Node
+   *
+   *@return The number of child nodes.
+   */
+  int Node::getChildCount() const{
+    return childNodes.size();
+  }
+
+  /**
+   * Function which returns the child node at the given index. Throws XMLException if there is no such child.
+   *
+   *@param index The index of the child node.
+   *@return A pointer to the child node.
+   */
+  Node* Node::getChild(int index){
+    return const_cast<Node*>(static_cast<const Node*>(this)->getChild(index));
+  }
+
+  /**
+   * Const version of getChild, for walking a tree that must not be modified.
+   *
+   *@param index The index of the child node.
+   *@return A pointer to the const child node.
+   */
+  const Node* Node::getChild(int index) const{
+    if (index < 0 || index >= childNodes.size())
+      throw XMLException("\nError! Trying to get a child node from an index that doesn't exist");
+    return childNodes[index];
+  }
+
   /**
    * Function which returns a pointer to the next sibling of the current node
    *
    *@return A pointer to the Node that is the next sibling of the current node.
    */
-  Node* Node::getNextSibling() const{
+  Node* Node::getNextSibling(){
     //Code to return the next sibling of the node.		
     return this->nextSibling;
   }
 
+  /**
+   * Function which returns the next sibling of a const node.
+   *
+   *@return A const pointer to the next sibling, or nullptr for the last child.
+   */
+  const Node* Node::getNextSibling() const{
+    return this->nextSibling;
+  }
+
   /**
    * Function which returns a pointer to the previous sibling of the current node
    *
    *@return A pointer to the Node that is the previous sibling of the current node.
    */
-  Node* Node::getPreviousSibling() const{
+  Node* Node::getPreviousSibling(){
     //Code to return the previous sibling of the node.
     return this->previousSibling;
   }
 
+  /**
+   * Function which returns the previous sibling of a const node.
+   *
+   *@return A const pointer to the previous sibling, or nullptr for the first child.
+   */
+  const Node* Node::getPreviousSibling() const{
+    return this->previousSibling;
+  }
+
   /**
    * Function which adds a child node to the current node's child list.
    *
@@ -64,6 +129,17 @@ namespace tinyXMLpp{
     this->childNodes.push_back(child);
     child->parentNode = this;
     ++numberOfChildren;
+    markDirty();
+  }
+
+  /**
+   * Function which makes room in the child list for the given number of children. A list sized this way before it is
+   * filled takes no more memory than the children need.
+   *
+   *@param count The number of children the node will have.
+   */
+  void Node::reserveChildren(int count){
+    childNodes.reserve(count);
   }
 
   /**
@@ -95,6 +171,7 @@ namespace tinyXMLpp{
 	childNodes.insert(it, child);
 	child->parentNode = this;
 	++numberOfChildren;
+	markDirty();
 	return;
       }
       prev_it = *it;
@@ -105,6 +182,7 @@ namespace tinyXMLpp{
       childNodes.insert(it, child);
       child->parentNode = this;
       ++numberOfChildren;
+      markDirty();
       return;
     }
     throw XMLException("\nError! Trying to add a child node at an index that doesn't exist");
@@ -128,6 +206,7 @@ namespace tinyXMLpp{
 	childNodes.erase(it);
 	--numberOfChildren;
 	delete child;
+	markDirty();
 	return;
       }
 
@@ -157,15 +236,254 @@ namespace tinyXMLpp{
     childNodes.erase(childNodes.begin() + index);
     delete child;
     --numberOfChildren;
+    markDirty();
   }	
 
+  /**
+   * Function which adds a child node to the current node's child list, taking over its ownership.
+   *
+   *@param child The node to be added as a child of the current node.
+   */
+  void Node::addChildNode (std::unique_ptr<Node> child){
+    addChildNode(child.get());
+    child.release();
+  }
+
+  /**
+   * Function which adds a child node to the current node's child list at the given index, taking over its ownership.
+   *
+   *@param child The node to be added as a child of the current node.
+   *@param index The index at which the child should be added to the list of children.
+   */
+  void Node::addChildNode (std::unique_ptr<Node> child, int index){
+    addChildNode(child.get(), index);
+    child.release();
+  }
+
+  /**
+   * Function which takes a child node out of the current node's child list without deleting it. The child can then be
+   * added anywhere else, in this tree or another one. Its source spans only mean something in the source of this tree, so
+   * the whole subtree loses them and is written in full from then on.
+   *
+   *@param index The index of the child node.
+   *@return A unique_ptr to the child node, which no longer has a parent or siblings.
+   */
+  std::unique_ptr<Node> Node::releaseChildNode (int index){
+    if (index < 0 || index >= numberOfChildren){
+      throw XMLException("\nError! Trying to remove a child node from an index that doesn't exist");
+    }
+    Node* child = childNodes[index];
+
+    if (child->previousSibling != nullptr)
+      child->previousSibling->nextSibling = child->nextSibling;
+    if (child->nextSibling != nullptr)
+      child->nextSibling->previousSibling = child->previousSibling;
+
+    childNodes.erase(childNodes.begin() + index);
+    --numberOfChildren;
+    child->parentNode = nullptr;
+    child->nextSibling = child->previousSibling = nullptr;
+    child->clearSourceSpans();
+    markDirty();
+    return std::unique_ptr<Node>(child);
+  }
+
+  /**
+   * Function which drops the source span of the node and of every node below it, marking them all dirty. The subtree is
+   * walked with an explicit stack, so deep trees do not recurse.
+   */
+  void Node::clearSourceSpans() {
+    std::vector<Node*> pending(1, this);
+    while (!pending.empty()) {
+      Node* node = pending.back();
+      pending.pop_back();
+      node->sourceOffset = node->sourceLength = 0;
+      node->dirty = true;
+      pending.insert(pending.end(), node->childNodes.begin(), node->childNodes.end());
+    }
+  }
+
   /**
    * Function which returns the parent node of the current node.
    *
    *@return A pointer to the parent node of this particular node.
    */
-  Node* Node::getParentNode () const {
+  Node* Node::getParentNode () {
+    return this->parentNode;
+  }
+
+  /**
+   * Function which returns the parent node of a const node.
+   *
+   *@return A const pointer to the parent node, or nullptr at the top of the tree.
+   */
+  const Node* Node::getParentNode () const {
     return this->parentNode;
   }
 
+  /**
+   * Function which records the span of the source text the node was parsed from, and marks the node clean. Called by the
+   * parser once the whole node has been read.
+   *
+   *@param offset The offset of the first character of the node in the source.
+   *@param length The length of the node in the source.
+   */
+  void Node::setSourceSpan(size_t offset, size_t length) {
+    this->sourceOffset = offset;
+    this->sourceLength = length;
+    this->dirty = false;
+  }
+
+  /**
+   * Function which tells whether the node was parsed from a source that is being tracked.
+   *
+   *@return true if the node has a source span.
+   */
+  bool Node::hasSourceSpan() const {
+    return this->sourceLength > 0;
+  }
+
+  /**
+   * Function which returns the offset of the node in its source.
+   *
+   *@return The offset of the first character of the node.
+   */
+  size_t Node::getSourceOffset() const {
+    return this->sourceOffset;
+  }
+
+  /**
+   * Function which returns the length of the node in its source.
+   *
+   *@return The length of the node, or 0 if it has no source span.
+   */
+  size_t Node::getSourceLength() const {
+    return this->sourceLength;
+  }
+
+  /**
+   * Function which tells whether the node or any of its descendants changed since they were parsed. Nodes created by hand
+   * are always dirty.
+   *
+   *@return true if the node has to be written again rather than copied from its source.
+   */
+  bool Node::isDirty() const {
+    return this->dirty;
+  }
+
+  /**
+   * Function which marks the node and all its ancestors dirty, and drops their cached hashes. Ancestors of a dirty node are
+   * always dirty themselves, and a hash is only ever cached once the hashes below it are, so each walk stops at the first
+   * node that needs nothing more.
+   */
+  void Node::markDirty() {
+    for (Node* node = this; node != nullptr && node->hashValid; node = node->parentNode) {
+      node->hashValid = false;
+    }
+    for (Node* node = this; node != nullptr && !node->dirty; node = node->parentNode) {
+      node->dirty = true;
+    }
+  }
+
+  /**
+   * Function which returns the structural hash of the node and its subtree. It covers names, attributes, text and the
+   * order of the children, but not source spans or namespace ids. The hash is cached until the subtree changes, so after
+   * an edit only the path from the changed node to the root is hashed again.
+   *
+   *@return The hash of the subtree.
+   */
+  uint64_t Node::getHash() const {
+    if (!this->hashValid) {
+      this->hash = computeHash();
+      this->hashValid = true;
+    }
+    return this->hash;
+  }
+
+  /**
+   * Function which computes the hash of the node. Node itself has no content of its own, so only the children are hashed;
+   * subclasses hash their content and pass it on to hashChildren.
+   *
+   *@return The hash of the subtree.
+   */
+  uint64_t Node::computeHash() const {
+    return hashChildren(0);
+  }
+
+  /**
+   * Function which mixes the hashes of the children into the hash of a node's content, in order.
+   *
+   *@param hash The hash of the node's own content.
+   *@return The hash of the subtree.
+   */
+  uint64_t Node::hashChildren(uint64_t hash) const {
+    hash = hashCombine(hash, this->childNodes.size());
+    for (size_t i = 0; i < this->childNodes.size(); ++i) {
+      hash = hashCombine(hash, this->childNodes[i]->getHash());
+    }
+    return hash;
+  }
+
+  /**
+   * Function which compares the content of two nodes, leaving out their children. Subclasses compare their own data.
+   *
+   *@param other The node to compare with.
+   *@return true if both nodes are of the same type and hold the same content.
+   */
+  bool Node::hasSameContent(const Node& other) const {
+    return typeid(*this) == typeid(other);
+  }
+
+  /**
+   * Function which checks whether two subtrees are the same. Different hashes answer at once; when they match, the nodes
+   * are compared for real to rule out a collision, and each child pair is again checked by hash first.
+   *
+   *@param other The root of the other subtree.
+   *@return true if both subtrees hold the same nodes, in the same order.
+   */
+  bool Node::equals(const Node& other) const {
+    if (this == &other)
+      return true;
+    if (getHash() != other.getHash())
+      return false;
+    if (this->childNodes.size() != other.childNodes.size() || !hasSameContent(other))
+      return false;
+
+    for (size_t i = 0; i < this->childNodes.size(); ++i) {
+      if (!this->childNodes[i]->equals(*other.childNodes[i]))
+	return false;
+    }
+    return true;
+  }
+
+  /**
+   * Function which copies the subtree rooted at the node. The copy has no parent and no source span.
+   *
+   *@return The copy of the subtree.
+   */
+  std::unique_ptr<Node> Node::clone() const {
+    std::unique_ptr<Node> copy(cloneContent());
+    for (size_t i = 0; i < this->childNodes.size(); ++i) {
+      copy->addChildNode(this->childNodes[i]->clone());
+    }
+
+    /*adding the children cleared the hash, and the copy hashes the same as the original*/
+    copy->hash = this->hash;
+    copy->hashValid = this->hashValid;
+    return copy;
+  }
+
+  /**
+   * Function to write the node into the output stream, copying it verbatim from its source when it is clean.
+   *
+   *@param os The output stream to which the node should be written.
+   *@param source The text the node was parsed from.
+   */
+  void Node::writeIncremental(std::ostream& os, const std::string& source) const {
+    if (!this->dirty && hasSourceSpan() && this->sourceOffset + this->sourceLength <= source.size())
+      os.write(source.data() + this->sourceOffset, this->sourceLength);
+    else
+      write(os);
+  }
+
 }
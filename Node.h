@@ -5,6 +5,8 @@
 #include <list>
 #include <vector>
 #include <memory>
+#include <cstdint>
+#include "ConstPointerList.h"
 
 namespace tinyXMLpp{
 
@@ -17,15 +19,46 @@ namespace tinyXMLpp{
     std::vector<Node*> childNodes;  
     Node* nextSibling, *previousSibling;
 
+    /*Span of the source text the node was parsed from. A node is dirty
+      when it, or anything below it, changed since it was parsed.*/
+    size_t sourceOffset, sourceLength;
+    bool dirty;
+
+    /*Structural hash of the subtree, computed on first use and kept
+      until something in the subtree changes*/
+    mutable uint64_t hash;
+    mutable bool hashValid;
+
+    void clearSourceSpans();
+
+    protected:
+    /*Hash of the node's own content combined with its children's*/
+    virtual uint64_t computeHash() const;
+    uint64_t hashChildren(uint64_t hash) const;
+
+    /*Compares the node's own content, not its children*/
+    virtual bool hasSameContent(const Node& other) const;
+
+    /*New node with the same content, without children*/
+    virtual Node* cloneContent() const = 0;
+
     public:
     Node();
     virtual ~Node();
 
-    /*retrieve parent-child-siblings*/
-    const std::vector<Node*>& getChildren() const;
-    Node* getParentNode () const;
-    Node* getNextSibling() const;        
-    Node* getPreviousSibling() const;		
+    /*retrieve parent-child-siblings. Through a const node the rest
+      of the tree is only reachable as const nodes.*/
+    const std::vector<Node*>& getChildren();
+    ConstPointerList<Node> getChildren() const;
+    int getChildCount() const;
+    Node* getChild(int index);
+    const Node* getChild(int index) const;
+    Node* getParentNode ();
+    const Node* getParentNode () const;
+    Node* getNextSibling();        
+    const Node* getNextSibling() const;        
+    Node* getPreviousSibling();		
+    const Node* getPreviousSibling() const;		
 
     /*Methods which allow addition and 
       removal of children*/
@@ -34,8 +67,40 @@ namespace tinyXMLpp{
     virtual void removeChildNode (Node* child);
     virtual void removeChildNode (int index);
 
+    /*Ownership transferring versions. A child that cannot be added is
+      freed along with the unique_ptr.*/
+    void addChildNode (std::unique_ptr<Node> child);
+    void addChildNode (std::unique_ptr<Node> child, int index);
+    std::unique_ptr<Node> releaseChildNode (int index);
+
+    /*Makes room for the given number of children, so adding them
+      does not grow the child list step by step*/
+    void reserveChildren(int count);
+
+    /*Dirty tracking, used to write back only what changed*/
+    void setSourceSpan(size_t offset, size_t length);
+    bool hasSourceSpan() const;
+    size_t getSourceOffset() const;
+    size_t getSourceLength() const;
+    bool isDirty() const;
+    void markDirty();
+
+    /*Structural hash and equality of subtrees. Subtrees with different
+      hashes differ; equals only descends into children whose hashes
+      match. Computing the hash caches it in the nodes, so it must not
+      race with other calls on the same tree.*/
+    uint64_t getHash() const;
+    bool equals(const Node& other) const;
+
+    /*Deep copy of the subtree, without a parent. Cached hashes are
+      copied along, so the copy is not hashed again.*/
+    std::unique_ptr<Node> clone() const;
+
     /*write contents of the node to ostream*/
     virtual void write(std::ostream& os) const = 0 ;
+
+    /*write the node, copying clean parts verbatim from source*/
+    virtual void writeIncremental(std::ostream& os, const std::string& source) const;
   };
 
 }
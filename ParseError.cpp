@@ -0,0 +1,54 @@
+#include "ParseError.h"
+
+namespace tinyXMLpp {
+
+  /**
+   * Function which describes an error code. The strings are constant, so reporting an error allocates nothing.
+   *
+   *@param code The error code.
+   *@return The description of the error.
+   */
+  const char* getErrorMessage(ParseErrorCode code)
+  {
+    switch (code) {
+      case PARSE_OK:				return "No error";
+      case UNEXPECTED_EOF:			return "Unexpected end of input";
+      case INVALID_UTF8:			return "Invalid UTF-8 sequence in the input";
+      case INVALID_UTF16:			return "Invalid UTF-16 sequence in the input";
+      case INVALID_CHARACTER:			return "Unexpected character in markup";
+      case INVALID_NAME:			return "Missing or invalid tag or attribute name";
+      case INVALID_TEXT:			return "Invalid character in text";
+      case MISSING_ATTRIBUTE_VALUE:		return "Attribute value missing";
+      case INVALID_COMMENT:			return "'--' found in XML Comment";
+      case MISMATCHED_TAG:			return "Mismatched tags";
+      case UNCLOSED_ELEMENT:			return "Input ends inside an element";
+      case MULTIPLE_ROOTS:			return "A document cannot have more than one root";
+      case CONTENT_OUTSIDE_ROOT:		return "Text or CDATA outside the root element";
+      case UNBOUND_PREFIX:			return "Namespace prefix not bound or invalid qualified name";
+      case INVALID_NAMESPACE_DECLARATION:	return "Invalid namespace declaration";
+      case DEPTH_LIMIT_EXCEEDED:		return "Elements nested deeper than the limit";
+      case ATTRIBUTE_LIMIT_EXCEEDED:		return "More attributes on an element than the limit";
+      case NAME_LIMIT_EXCEEDED:			return "Name longer than the limit";
+      case TEXT_LIMIT_EXCEEDED:			return "Text longer than the limit";
+      case NODE_LIMIT_EXCEEDED:			return "More nodes in the document than the limit";
+      case NAMESPACE_LIMIT_EXCEEDED:		return "More namespace URIs than the limit or the namespace table holds";
+      default:					return "Unknown error";
+    }
+  }
+
+  /**
+   * Function which describes an error along with the line and column it was found at, or its offset when they are not
+   * known.
+   *
+   *@param error The error.
+   *@return The description of the error.
+   */
+  std::string describeError(const ParseError& error)
+  {
+    std::string message = getErrorMessage(error.code);
+    if (error.line > 0)
+      return message + " at line " + std::to_string(error.line) + ", column " + std::to_string(error.column);
+    return message + " at offset " + std::to_string(error.offset);
+  }
+
+}
@@ -0,0 +1,83 @@
+#ifndef __PARSEERROR_H__
+#define __PARSEERROR_H__
+
+#include <memory>
+#include <string>
+#include <ios>
+
+namespace tinyXMLpp {
+
+  /*What made a document malformed*/
+  enum ParseErrorCode {
+    PARSE_OK,
+    UNEXPECTED_EOF,
+    INVALID_UTF8,
+    INVALID_UTF16,
+    INVALID_CHARACTER,		//character not allowed where it was found in markup
+    INVALID_NAME,		//tag or attribute name missing or not an XML name
+    INVALID_TEXT,		//'<', '>' or '&' in text
+    MISSING_ATTRIBUTE_VALUE,
+    INVALID_COMMENT,		//"--" inside a comment
+    MISMATCHED_TAG,
+    UNCLOSED_ELEMENT,
+    MULTIPLE_ROOTS,
+    CONTENT_OUTSIDE_ROOT,	//text or CDATA at the top level
+    UNBOUND_PREFIX,		//undeclared prefix or malformed qualified name
+    INVALID_NAMESPACE_DECLARATION,
+    DEPTH_LIMIT_EXCEEDED,		//see ParseLimits
+    ATTRIBUTE_LIMIT_EXCEEDED,
+    NAME_LIMIT_EXCEEDED,
+    TEXT_LIMIT_EXCEEDED,
+    NODE_LIMIT_EXCEEDED,
+    NAMESPACE_LIMIT_EXCEEDED		//see ParseLimits and NamespaceTable::MAX_NAMESPACES
+  };
+
+  /*Short fixed description of an error code*/
+  const char* getErrorMessage(ParseErrorCode code);
+
+  /*Where parsing stopped. The offset is in bytes from where the
+    parser started reading; line and column are counted from 1, the
+    column in bytes, from the newlines seen while tokenizing. They are
+    0 for errors found by other means, such as bad UTF-16 when the
+    input was read into memory first.*/
+  struct ParseError {
+    ParseErrorCode code;
+    std::streamoff offset;
+    int line;
+    int column;
+
+    ParseError() : code(PARSE_OK), offset(0), line(0), column(0) {}
+    ParseError(ParseErrorCode code, std::streamoff offset) : code(code), offset(offset), line(0), column(0) {}
+  };
+
+  /*The description of the error followed by where it was found*/
+  std::string describeError(const ParseError& error);
+
+  /*Either a parsed value or the error that stopped the parse. Used
+    by the parse calls that report malformed input without throwing.*/
+  template <typename T>
+  class Expected {
+
+    std::unique_ptr<T> value;
+    ParseError error;
+
+    public:
+    Expected(std::unique_ptr<T> value) : value(std::move(value)) {}
+    Expected(const ParseError& error) : error(error) {}
+
+    bool ok() const { return error.code == PARSE_OK; }
+    explicit operator bool() const { return ok(); }
+
+    const ParseError& getError() const { return error; }
+
+    /*Only valid when ok()*/
+    T& operator*() const { return *value; }
+    T* operator->() const { return value.get(); }
+
+    /*Hands over the value, nullptr on error*/
+    std::unique_ptr<T> release() { return std::move(value); }
+  };
+
+}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef __PARSELIMITS_H__
+#define __PARSELIMITS_H__
+
+#include <cstddef>
+#include <limits>
+
+namespace tinyXMLpp {
+
+  /*Bounds on what a single document may contain, so that hostile
+    input fails early instead of exhausting memory or the stack. The
+    tokenizer checks the sizes of names, text and attribute lists as
+    they grow; the tree builder checks nesting depth and node count.
+    The depth limit also bounds the recursion of the functions that
+    walk a tree, such as the Node destructor and write.*/
+  struct ParseLimits {
+
+    static const size_t UNLIMITED = std::numeric_limits<size_t>::max();
+
+    size_t maxDepth;		//open elements at any point
+    size_t maxAttributes;	//attributes on one element
+    size_t maxNameLength;	//bytes in a tag or attribute name
+    size_t maxTextLength;	//bytes in one text, CDATA, comment or attribute value
+    size_t maxNodes;		//nodes in the whole document
+    size_t maxNamespaces;	//distinct namespace URIs declared in the document
+
+    /*Only the depth, attribute count and namespaces are bounded by
+      default, to values no sensible document reaches. The namespace
+      bound keeps one document from filling the NamespaceTable that
+      every parser in the process shares.*/
+    ParseLimits()
+      : maxDepth(1024), maxAttributes(1024), maxNameLength(UNLIMITED), maxTextLength(UNLIMITED), maxNodes(UNLIMITED),
+	maxNamespaces(1024) {}
+  };
+
+}
+
+#endif
@@ -10,21 +10,70 @@
 #include <iostream>
 #include <fstream>
 #include <string>
-#include <regex>
+#include <cctype>
 #include "Document.h"
 #include "XMLException.h"
+#include "GzipStream.h"
+#include "FlatDocument.h"
+#include "MemoryInputBuffer.h"
+#include "TreeBuilder.h"
+#include "TokenRing.h"
+#include "Encoding.h"
+#include "StructureScan.h"
+
+#include <iterator>
+#include <thread>
 
 namespace tinyXMLpp {
 
   /**
-   * Function that parses an XML file, given the path to the file.
+   * Function that parses an XML file, given the path to the file. Files holding gzip data are inflated on the fly while
+   * being tokenized; no decompressed copy is written anywhere. zlib data has no magic number to tell it from text, so it
+   * is read through a GzipInputBuffer by the caller.
    *
    *@param filePath The path to the input XML file
    *@return A unique_ptr to a Document object which holds the XML file as a tree.
    */
   std::unique_ptr<Document> Parser::parse(const std::string& filePath){
-    std::ifstream ifs(filePath);
-    return parse(ifs);
+    reset();
+    if (fileBuffer.empty())
+      fileBuffer.resize(64 * 1024);
+
+    /*the parser owns the file buffer, so reopening the stream does not allocate a new one*/
+    file.rdbuf()->pubsetbuf(&fileBuffer[0], fileBuffer.size());
+    file.open(filePath, std::ios::binary);
+    if (!file)
+      throw XMLException("Unable to open XML file " + filePath);
+
+    std::unique_ptr<Document> doc;
+    try {
+      if (!GzipInputBuffer::isCompressed(file)) {
+	doc = parse(file);
+      }
+      else {
+	GzipInputBuffer buffer(file.rdbuf());
+	std::istream is(&buffer);
+	is.exceptions(std::ios::badbit);	//let decompression errors through instead of reading them as EOF
+	doc = parse(is);
+      }
+    }
+    catch (...) {
+      reset();
+      throw;
+    }
+
+    reset();
+    return doc;
+  }
+
+  /**
+   * Function which drops everything left from the previous parse. The buffers are kept, so the next parse can reuse them.
+   * parse calls this itself, so it is only needed to close the last input early.
+   */
+  void Parser::reset(){
+    if (file.is_open())
+      file.close();
+    file.clear();
   }
 
   /**
@@ -34,8 +83,11 @@ namespace tinyXMLpp {
    *@return A bool value set to true if the input string is made up only of spaces, newlines or tabs.
    */
   bool Parser::isEmptyText (const std::string& input) {
-    regex rx("[\\r\\n\\t\\s]*");
-    return regex_match(input.begin(), input.end(), rx);
+    for (size_t i = 0; i < input.size(); ++i) {
+      if (!isspace((unsigned char)input[i]))
+	return false;
+    }
+    return true;
   }
 
   /**
@@ -46,153 +98,514 @@ namespace tinyXMLpp {
    *@return A bool value set to true if the input string is invalid within an XML document.
    */
   bool Parser::isInvalidText (const std::string& input) {
-    regex rx("[><&]");
-    return regex_search(input.begin(), input.end(), rx);
+    return input.find_first_of("><&") != std::string::npos;
+  }
+
+  namespace {
+    /*Flags under which the tree holds less than its source, so a clean
+      element written back from its span would differ from the same
+      element once it is dirty*/
+    const unsigned DROPPING_FLAGS = PARSE_SKIP_COMMENTS | PARSE_SKIP_CDATA | PARSE_TRIM_WHITESPACE | PARSE_NO_TEXT;
+
+    void checkSourceFlags(bool track, unsigned flags) {
+      if (track && (flags & DROPPING_FLAGS) != 0)
+	throw XMLException("Source tracking cannot be combined with flags that skip or trim content");
+    }
+  }
+
+  /**
+   * Function which turns source tracking on or off. With tracking on, the parsed Document keeps its source text and each
+   * node the span it was read from, so writing the document after a few edits only serializes the nodes that changed.
+   * The whole input is held in memory while the Document lives. Tracking cannot be turned on while flags that skip or trim
+   * content are set, since the spans would write back what the tree left out.
+   *
+   *@param track true to keep the source.
+   */
+  void Parser::setSourceTracking(bool track){
+    checkSourceFlags(track, this->tokenizer.getFlags());
+    this->trackSource = track;
+  }
+
+  /**
+   * Function which turns hashing at parse time on or off. With it on, each element's hash is computed bottom-up as its end
+   * tag is read, while its subtree is still in the cache, and equality checks on the Document need no extra pass.
+   *
+   *@param hash true to compute the hashes while parsing.
+   */
+  void Parser::setHashing(bool hash){
+    this->computeHashes = hash;
+  }
+
+  /**
+   * Function which turns the pre-scan on or off. The scan is a pass over the raw bytes that skips from one piece of markup
+   * to the next with memchr, so it costs far less than the parse; in return no list of children or attributes is grown
+   * while the tree is built. The scan skips what the flags set with setFlags skip, so the lists are sized for the nodes
+   * that are actually made; only malformed input leaves them with unused capacity.
+   *
+   *@param scan true to scan the input before parsing it.
+   */
+  void Parser::setPreScan(bool scan){
+    this->preScan = scan;
+  }
+
+  /**
+   * Function which sets the bounds on the documents the parser accepts. A document that passes one of them is rejected as
+   * soon as it does, so the memory a parse can take is bounded by the limits rather than by the input.
+   *
+   *@param limits The limits.
+   */
+  void Parser::setLimits(const ParseLimits& limits){
+    this->limits = limits;
+    this->tokenizer.setLimits(limits);
+  }
+
+  /**
+   * Function which chooses the tokenizer features the parser can do without. Documents that only need their elements and
+   * attributes are read faster when text, comments or checks are left out. Only PARSE_NO_VALIDATION can be set while source
+   * tracking is on.
+   *
+   *@param flags The ParseFlags or'ed together.
+   */
+  void Parser::setFlags(unsigned flags){
+    checkSourceFlags(this->trackSource, flags);
+    this->tokenizer.setFlags(flags);
+  }
+
+  /**
+   * Function which turns namespace processing on or off. With it on, every element and attribute is given the id of the
+   * namespace its prefix is bound to, and documents using undeclared prefixes are rejected.
+   *
+   *@param aware true to resolve namespaces.
+   */
+  void Parser::setNamespaceAware(bool aware){
+    this->namespaceAware = aware;
+    this->tokenizer.setNamespaceAware(aware);
   }
 
   /**
-   * Function that parses an XML file, given an input stream.
+   * Function that parses an XML file, given an input stream. Input starting with a UTF-16 byte order mark is transcoded to
+   * UTF-8 while it is read; a UTF-8 byte order mark is skipped.
    *
    *@param is An input stream which contains an XML file
    *@return A unique_ptr to a Document object which holds the XML file as a tree.
    */
   std::unique_ptr<Document> Parser::parse(std::istream& is) {		
 
-    try{		
+    Expected<Document> result = tryParse(is);
+    if (!result)
+      throw XMLException(result.getError());
+    return result.release();
+  }
 
-      XMLTokenizer t(is);			
-      Document *documentNode = new Document();			
-      Node *temp, *newNode;
-      std::string currentNodeName = "";
-      bool rootElementNotFound = true;
-      std::string rootElementName = "";
+  /**
+   * Function that parses an XML file from an input stream without throwing on malformed input. The error is returned with
+   * the byte offset it was found at, and its line and column, counted as the input is read. Errors of
+   * the stream itself, such as a failing gzip stream, are still thrown.
+   *
+   *@param is An input stream which contains an XML file
+   *@return The Document, or the error that stopped the parse.
+   */
+  Expected<Document> Parser::tryParse(std::istream& is) {
 
-      std::unique_ptr<Document> doc(documentNode);
-      /*if (t.getToken() == TEXT) {
-	if (!isEmptyText(t.getText())) 
-	throw XMLException("The first TextNode is not empty");
-	else if(t.getText() != "")
-	documentNode->addChildNode( TextNode::createTextNode(t.getText()) );
-	}*/
+    DecodedInput input(is);
+    Expected<Document> result = parseUTF8(input.get());
 
-      while (true){
+    /*tracking the source or scanning ahead reads the input into memory first, where the tokenizer cannot tell that the
+      transcoding stopped early*/
+    if (input.hasError())
+      return Expected<Document>(ParseError(INVALID_UTF16, this->tokenizer.getOffset()));
+    return result;
+  }
 
-	switch (t.getToken()) {
+  /**
+   * Function that parses an XML document held in memory without throwing on malformed input. The memory is read in place.
+   *
+   *@param data The document.
+   *@param length The length of the document in bytes.
+   *@return The Document, or the error that stopped the parse.
+   */
+  Expected<Document> Parser::tryParse(const char* data, size_t length) {
+    MemoryInputBuffer buffer(data, length);
+    std::istream in(&buffer);
+    return tryParse(in);
+  }
 
-	  case START_TAG:
-	    currentNodeName = t.getTagName();
-	    newNode = ElementNode::createElementNode(currentNodeName);
+  namespace {
+    /*Spans are offsets into the source and the scan reads the input
+      ahead of the parse, so both need all of the input in memory.
+      Input that is in memory already is used where it is, unless its
+      text has to be kept.*/
+    struct InputInMemory {
+      std::string source;
+      MemoryInputBuffer buffer;
+      std::unique_ptr<StructureScan> sizes;
+
+      InputInMemory(std::istream& is, bool keepSource, bool scan, unsigned flags) : buffer(nullptr, 0) {
+	MemoryInputBuffer* memory = dynamic_cast<MemoryInputBuffer*>(is.rdbuf());
+	if (memory != nullptr && !keepSource) {
+	  buffer = MemoryInputBuffer(memory->getPosition(), memory->getRemaining());
+	}
+	else {
+	  source.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+	  buffer = MemoryInputBuffer(source.data(), source.size());
+	}
+	if (scan)
+	  sizes.reset(new StructureScan(buffer.getPosition(), buffer.getRemaining(), flags));
+      }
+    };
+  }
 
-	    if (rootElementNotFound) {
-	      rootElementNotFound = false;
-	      rootElementName = t.getTagName();
-	      documentNode->addChildNode(newNode);
+  /**
+   * Function that parses an XML file held as UTF-8 in an input stream.
+   *
+   *@param is An input stream which contains an XML file, past its byte order mark.
+   *@return The Document, or the error that stopped the parse.
+   */
+  Expected<Document> Parser::parseUTF8(std::istream& is) {
 
-	    }else{
+    if (!this->trackSource && !this->preScan)
+      return parseDocument(is, false, nullptr);
 
-	      temp->addChildNode(newNode);					
-	    }
+    InputInMemory memory(is, this->trackSource, this->preScan, this->tokenizer.getFlags());
+    std::istream in(&memory.buffer);
+
+    Expected<Document> result = parseDocument(in, this->trackSource, memory.sizes.get());
+    if (result && this->trackSource)
+      result->setSource(std::move(memory.source));
+    return result;
+  }
+
+  namespace {
+    /*Keeps the tokenizer from throwing for the length of a parse, and
+      restores it for the calls that still throw*/
+    struct NoThrowScope {
+      XMLTokenizer& t;
+      NoThrowScope(XMLTokenizer& t) : t(t) { t.setThrowOnError(false); }
+      ~NoThrowScope() { t.setThrowOnError(true); }
+    };
+
+    /*Gives the tokenizer its input, and once the tree is built takes
+      back the namespace references the tokenizer held for it*/
+    struct InputScope {
+      XMLTokenizer& t;
+      InputScope(XMLTokenizer& t, std::istream& is) : t(t) { t.setInput(is); }
+      ~InputScope() { t.releaseNamespaces(); }
+    };
+  }
+
+  /**
+   * Function that builds the Document held in an input stream.
+   *
+   *@param is An input stream which contains an XML file
+   *@param withSpans Whether the nodes should record the span of the input they were read from.
+   *@param sizes A scan of the same input to size the lists of the elements, or nullptr.
+   *@return The Document, or the error that stopped the parse.
+   */
+  Expected<Document> Parser::parseDocument(std::istream& is, bool withSpans, const StructureScan* sizes) {		
+
+    XMLTokenizer& t = this->tokenizer;
+    InputScope input(t, is);
+    NoThrowScope scope(t);
+    DocumentSink sink(withSpans, this->computeHashes);
+    sink.setSizes(sizes);
+    TreeBuilder builder(sink);
+    builder.setLimits(this->limits);
 
-	    for (int i = 0; i < t.getAttributeCount(); ++i) {
-	      static_cast<ElementNode*>(newNode)->addAttribute(t.getAttributeName(i), t.getAttributeValue(i));
+    builder.addTokens(t, t.getToken());
+    if (t.getError().code != PARSE_OK)
+      return Expected<Document>(t.getError());
+
+    return Expected<Document>(sink.release());
+  }
+
+  namespace {
+    /*Adds the tokens of a batch taken from a TokenRing to the tree. The strings are copied out of the batch into name and
+      value, which keep their memory from one token to the next.*/
+    bool addBatch(TreeBuilder& builder, const TokenRing::Batch& batch, std::string& name, std::string& value) {
+      for (const TokenRing::TokenRecord& record : batch.tokens) {
+	switch (record.type) {
+	  case START_TAG:
+	    name.assign(batch.data(record.value), record.valueLength);
+	    builder.startElement(name, record.start, record.namespaceId);
+	    for (uint32_t i = 0; i < record.attrCount; ++i) {
+	      const TokenRing::AttributeRecord& attr = batch.attributes[record.firstAttribute + i];
+	      name.assign(batch.data(attr.name), attr.nameLength);
+	      value.assign(batch.data(attr.value), attr.valueLength);
+	      builder.addAttribute(name, value, attr.namespaceId);
 	    }
-	    temp = newNode;
 	    break;
-
 	  case END_TAG:
-	    if (currentNodeName == t.getTagName()) {
-	      if (temp->getParentNode() == nullptr) {
-		if (currentNodeName == rootElementName) {
-		  rootElementNotFound = true;
-		  currentNodeName = "";
-		  temp = nullptr;
-		  break;
-		}
-	      }
-	      else {
-		temp = temp->getParentNode();
-
-		if(dynamic_cast<ElementNode*>(temp) != NULL)
-		  currentNodeName =  static_cast<ElementNode*>(temp)->getName();
-	      }
-
-	    }else{
-	      throw XMLException("Mismatched Tags! Error.. ");						
-	    }
+	    name.assign(batch.data(record.value), record.valueLength);
+	    builder.endElement(name, record.start, record.end);
 	    break;
-
 	  case TEXT:
-	    if (isInvalidText (t.getText())) {
-	      throw XMLException ("Invalid XML detected..");
-	    }
-	    std::cout << "*" << t.getText() << "*";
-	    if (t.getText() == "") {
+	  case CDATA:
+	  case COMMENT:
+	    value.assign(batch.data(record.value), record.valueLength);
+	    builder.addText(record.type, value, record.start, record.end);
+	    break;
+	  case ENDOFFILE:
+	    builder.endDocument(record.start);
+	    return false;
+	  default:
+	    break;
+	}
+      }
+
+      if (batch.error)
+	std::rethrow_exception(batch.error);
+      return true;
+    }
+  }
+
+  /**
+   * Function that parses an XML document from an input stream using two threads. A new thread runs the tokenizer and
+   * passes the tokens in batches through a lock-free ring, while the calling thread builds the tree from them. The result
+   * is the same as parse, with source tracking, pre-scanning and hashing as set; for large documents the tokenizing and
+   * the tree building overlap.
+   *
+   *@param is An input stream which contains an XML file
+   *@return A unique_ptr to a Document object which holds the XML file as a tree.
+   */
+  std::unique_ptr<Document> Parser::parsePipelined(std::istream& is) {
+
+    DecodedInput input(is);
+    std::unique_ptr<InputInMemory> memory;
+    std::unique_ptr<std::istream> in;
+    if (this->trackSource || this->preScan) {
+      memory.reset(new InputInMemory(input.get(), this->trackSource, this->preScan, this->tokenizer.getFlags()));
+      in.reset(new std::istream(&memory->buffer));
+    }
+    /*reading the input into memory hides where the transcoding stopped from the tokenizer*/
+    if (memory && input.hasError())
+      throw XMLException(ParseError(INVALID_UTF16, memory->source.size()));
+
+    XMLTokenizer& t = this->tokenizer;
+    InputScope tokens(t, in ? *in : input.get());
+    TokenRing ring;
+
+    std::thread producer([&]() {
+      bool more = true;
+      while (more) {
+	TokenRing::Batch* batch = ring.beginWrite();
+	if (batch == nullptr)
+	  return;
+	batch->clear();
+	try {
+	  while (true) {
+	    TokenType type = t.getToken();
+	    bool room = batch->add(type, t);
+	    if (type == ENDOFFILE) {
+	      more = false;
 	      break;
 	    }
+	    if (!room)
+	      break;
+	  }
+	}
+	catch (...) {
+	  batch->error = std::current_exception();
+	  more = false;
+	}
+	ring.endWrite();
+      }
+    });
+
+    DocumentSink sink(this->trackSource, this->computeHashes);
+    sink.setSizes(memory ? memory->sizes.get() : nullptr);
+    TreeBuilder builder(sink);
+    builder.setLimits(this->limits);
+    std::string name, value;
+    try {
+      bool more = true;
+      while (more) {
+	TokenRing::Batch* batch = ring.beginRead();
+	more = addBatch(builder, *batch, name, value);
+	ring.endRead();
+      }
+    }
+    catch (...) {
+      ring.cancel();
+      producer.join();
+      throw;
+    }
 
-	    newNode = TextNode::createTextNode(t.getText());
-	    if (rootElementNotFound) {
-	      documentNode->addChildNode(newNode);
-	    }else{						
-	      temp->addChildNode(newNode);
-	    }
+    producer.join();
+    std::unique_ptr<Document> doc = sink.release();
+    if (this->trackSource)
+      doc->setSource(std::move(memory->source));
+    return doc;
+  }
 
-	    break;
+  /**
+   * Function which builds the element whose start tag the tokenizer has just returned, together with its whole subtree.
+   * It reads up to and including the matching end tag.
+   *
+   *@param t The tokenizer, positioned right after a start tag.
+   *@return A unique_ptr to the element.
+   */
+  std::unique_ptr<ElementNode> Parser::buildElement(XMLTokenizer& t) {
 
-	  case ENDOFFILE:
-	    if (temp != nullptr) {
-	      throw XMLException ("Mismatched tags");
-	    }
+    ElementSink sink;
+    TreeBuilder builder(sink);
+    builder.setSingleElement(true);
+    builder.setLimits(this->limits);
+    builder.addTokens(t, START_TAG);
 
-	    return doc;
+    if (t.getError().code != PARSE_OK)
+      throw XMLException(t.getError());
+    return sink.release();
+  }
 
-	  case BOF:
-	    break;
+  /**
+   * Function that parses the first element found in an input stream, starting at the stream's current position, and
+   * stops right after its end tag. Whitespace and comments before the element are skipped.
+   *
+   *@param is An input stream positioned before the element.
+   *@return A unique_ptr to the element, with its subtree.
+   */
+  std::unique_ptr<ElementNode> Parser::parseElement(std::istream& is) {
 
-	  case CDATA:
-	    newNode = CDATANode::createCDATANode(t.getCDATA());
+    DecodedInput input(is);
+    XMLTokenizer& t = this->tokenizer;
+    InputScope tokens(t, input.get());
 
-	    if (rootElementNotFound)
-	      documentNode->addChildNode(newNode);												
-	    else
-	      temp->addChildNode(newNode);
+    while (true){
 
-	    break;
+      switch (t.getToken()) {
 
-	  case COMMENT:
-	    newNode =  CommentNode::createCommentNode(t.getComment());
+	case START_TAG:
+	  return buildElement(t);
 
-	    if (rootElementNotFound)					
-	      documentNode->addChildNode(newNode);						
-	    else				
-	      temp->addChildNode(newNode);
+	case TEXT:
+	  if (!isEmptyText(t.getText()))
+	    throw XMLException ("Text found where an element was expected");
+	  break;
 
-	    break;
+	case ENDOFFILE:
+	  throw XMLException ("No element found in the input");
 
-	  default:
-	    std::cout << "Default \n ";
-	    return doc;
+	case END_TAG:
+	case CDATA:
+	  throw XMLException ("Unexpected markup found where an element was expected");
 
-	}
+	default:
+	  break;
       }
+    }
+  }
 
-      return doc;
-
+  /**
+   * Function that parses just the element starting at a byte offset of a seekable stream, such as one taken from an
+   * XMLIndex. Nothing before the offset is read, so the namespace declarations of its ancestors are not seen either; the
+   * element is parsed with namespace processing off and its nodes are left in no namespace.
+   *
+   *@param is A seekable input stream.
+   *@param offset The byte offset of the element's start tag.
+   *@return A unique_ptr to the element, with its subtree.
+   */
+  std::unique_ptr<ElementNode> Parser::parseElementAt(std::istream& is, std::streamoff offset) {
+    is.clear();
+    is.seekg(offset);
+    if (!is)
+      throw XMLException("Unable to seek to the element offset");
+
+    this->tokenizer.setNamespaceAware(false);
+    std::unique_ptr<ElementNode> elem;
+    try {
+      elem = parseElement(is);
     }
-    catch (bad_alloc&)
-    {
-      std::cerr<<"Out of Memory!\n";
+    catch (...) {
+      this->tokenizer.setNamespaceAware(this->namespaceAware);
       throw;
     }
-    catch(XMLException&)
-    {	
-      throw;
+    this->tokenizer.setNamespaceAware(this->namespaceAware);
+    return elem;
+  }
+
+  /**
+   * Function that parses just the element starting at a byte offset of an XML file.
+   *
+   *@param filePath The path to the XML file. It must not be compressed.
+   *@param offset The byte offset of the element's start tag.
+   *@return A unique_ptr to the element, with its subtree.
+   */
+  std::unique_ptr<ElementNode> Parser::parseElementAt(const std::string& filePath, std::streamoff offset) {
+    reset();
+    if (fileBuffer.empty())
+      fileBuffer.resize(64 * 1024);
+
+    file.rdbuf()->pubsetbuf(&fileBuffer[0], fileBuffer.size());
+    file.open(filePath, std::ios::binary);
+    if (!file)
+      throw XMLException("Unable to open XML file " + filePath);
+
+    std::unique_ptr<ElementNode> elem;
+    try {
+      elem = parseElementAt(file, offset);
     }
-    catch(exception&)
-    {
+    catch (...) {
+      reset();
       throw;
     }
 
+    reset();
+    return elem;
+  }
+
+  /**
+   * Function that parses an XML document from an input stream straight into a FlatDocument, without building the node tree
+   * first. It accepts and rejects the same documents as parse.
+   *
+   *@param is An input stream which contains an XML file
+   *@return A unique_ptr to a FlatDocument which holds the XML file as flat arrays.
+   */
+  std::unique_ptr<FlatDocument> Parser::parseFlat(std::istream& is) {
+    DecodedInput input(is);
+    return parseFlat(input.get(), nullptr);
+  }
+
+  /**
+   * Function that parses a UTF-8 document held in memory into a FlatDocument without copying its text and attribute
+   * values. The tokenizer reports where each value starts, and the FlatDocument keeps that offset into the memory instead
+   * of a copy of the value; values are taken byte for byte from the input, so nothing has to be decoded or rewritten.
+   *
+   *@param data The document, which must outlive the returned FlatDocument.
+   *@param length The length of the document in bytes.
+   *@return A unique_ptr to a FlatDocument whose values are read from data.
+   */
+  std::unique_ptr<FlatDocument> Parser::parseFlatInPlace(const char* data, size_t length) {
+
+    if (length > 0xffffffffu)
+      throw XMLException("Documents parsed in place must be smaller than 4 GB");
+
+    MemoryInputBuffer buffer(data, length);
+    std::istream in(&buffer);
+    DecodedInput input(in);
+    if (input.getEncoding() != UTF8)
+      throw XMLException("Only UTF-8 documents can be parsed in place");
+
+    /*the tokenizer counts its offsets from the end of the byte order mark*/
+    return parseFlat(in, data + std::streamoff(in.tellg()));
+  }
+
+  /**
+   * Function which parses a document into a FlatDocument, copying the values into its heap or, given the memory the stream
+   * reads from, pointing into that memory.
+   *
+   *@param is An input stream which contains an XML file
+   *@param source The memory the stream reads, from where the tokenizer starts, or nullptr to copy the values.
+   *@return A unique_ptr to a FlatDocument which holds the XML file as flat arrays.
+   */
+  std::unique_ptr<FlatDocument> Parser::parseFlat(std::istream& is, const char* source) {
+
+    XMLTokenizer& t = this->tokenizer;
+    t.setInput(is);
+    FlatDocumentSink sink(source);
+    TreeBuilder builder(sink);
+    builder.setLimits(this->limits);
+    builder.addTokens(t, t.getToken());
+    return sink.release();
   }
 
 }
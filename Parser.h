@@ -3,15 +3,70 @@
 
 #include "Node.h"
 #include "Document.h"
+#include "XMLTokenizer.h"
+#include "ParseError.h"
+#include <fstream>
 
 namespace tinyXMLpp {
 
   class Document;
+  class FlatDocument;
+  class StructureScan;
+  class ElementNode;
 
+  /*A Parser can be reused for any number of documents. It keeps its
+    tokenizer and file buffer between calls, so their memory is only
+    allocated while the parser warms up.*/
   class Parser {
 
+      XMLTokenizer tokenizer;
+      std::ifstream file;
+      std::vector<char> fileBuffer;
+      bool trackSource;
+      bool namespaceAware;
+      bool computeHashes;
+      bool preScan;
+      ParseLimits limits;
+
+      Expected<Document> parseDocument(std::istream& is, bool withSpans, const StructureScan* sizes);
+      Expected<Document> parseUTF8(std::istream& is);
+      std::unique_ptr<FlatDocument> parseFlat(std::istream& is, const char* source);
+      std::unique_ptr<ElementNode> buildElement(XMLTokenizer& t);
+
     public:
-      Parser(){};
+      Parser() : trackSource(false), namespaceAware(true), computeHashes(false), preScan(false) {};
+
+      /*Keep the source text in parsed Documents, so that write only
+	serializes the nodes changed after parsing. Throws if flags that
+	skip or trim content are set.*/
+      void setSourceTracking(bool track);
+
+      /*Resolve element and attribute prefixes to namespaces while
+	parsing. On by default.*/
+      void setNamespaceAware(bool aware);
+
+      /*Compute the structural hash of every element while parsing,
+	instead of on the first call to getHash*/
+      void setHashing(bool hash);
+
+      /*Scan the input once before parsing it to count the children and
+	attributes of every element, so their lists are allocated once.
+	The scan follows the flags, so nodes the parse skips are not
+	counted. The input is read into memory first unless it is there
+	already.*/
+      void setPreScan(bool scan);
+
+      /*Bounds on depth, node count and the sizes of names, text and
+	attribute lists. Documents passing them are rejected.*/
+      void setLimits(const ParseLimits& limits);
+
+      /*Tokenizer features to leave out, see ParseFlags. Skipped
+	comments, CDATA and text never become nodes. Throws for flags
+	that skip or trim content while source tracking is on.*/
+      void setFlags(unsigned flags);
+
+      /*Drops the state of the last parse, keeping the buffers*/
+      void reset();
 
       bool isEmptyText (const std::string& input);
 
@@ -20,6 +75,29 @@ namespace tinyXMLpp {
       std::unique_ptr<Document> parse(const std::string& filePath);
 
       std::unique_ptr<Document> parse(std::istream& is);
+
+      /*Report malformed input in the result instead of throwing, for
+	input that is expected to be malformed often*/
+      Expected<Document> tryParse(std::istream& is);
+      Expected<Document> tryParse(const char* data, size_t length);
+
+      /*Tokenizes on a second thread while the calling thread builds the tree*/
+      std::unique_ptr<Document> parsePipelined(std::istream& is);
+
+      /*Parse a single element and its subtree, for random access
+	into large files*/
+      std::unique_ptr<ElementNode> parseElement(std::istream& is);
+      std::unique_ptr<ElementNode> parseElementAt(std::istream& is, std::streamoff offset);
+      std::unique_ptr<ElementNode> parseElementAt(const std::string& filePath, std::streamoff offset);
+
+      /*Parse into the flat, read-optimized representation*/
+      std::unique_ptr<FlatDocument> parseFlat(std::istream& is);
+
+      /*Parse a UTF-8 document held in memory into a FlatDocument whose
+	text and attribute values point into that memory. Only the node
+	arrays and the names are allocated; the memory must outlive the
+	FlatDocument.*/
+      std::unique_ptr<FlatDocument> parseFlatInPlace(const char* data, size_t length);
   };
 }
 
@@ -0,0 +1,101 @@
+#include "RecordReader.h"
+#include "ElementNode.h"
+#include "TreeBuilder.h"
+#include "XMLException.h"
+
+namespace tinyXMLpp {
+
+  /**
+   * Constructor
+   *
+   *@param is The input stream holding the XML. It must outlive the reader.
+   *@param elementPath The path of the records, see ElementPath.
+   */
+  RecordReader::RecordReader(std::istream& is, const std::string& elementPath)
+    : input(is), tokenizer(input.get()), path(elementPath), count(0)
+  {
+  }
+
+  /**
+   * Destructor
+   */
+  RecordReader::~RecordReader()
+  {
+  }
+
+  /**
+   * Function which reads up to the next element at the path and builds it with a TreeBuilder, which checks the record
+   * like any other tree. Elements which cannot hold a record are skipped without building anything; the end tags of the
+   * elements around the records are checked here.
+   *
+   *@return The record, owned by the reader until the next call, or nullptr at the end of the input.
+   */
+  ElementNode* RecordReader::next()
+  {
+    record.reset();
+    TokenType type;
+
+    while ((type = tokenizer.getToken()) != ENDOFFILE) {
+
+      if (type == END_TAG) {
+	if (ancestors.empty() || ancestors.back() != tokenizer.getTagName()) {
+	  tokenizer.setError(MISMATCHED_TAG, tokenizer.getTokenOffset());
+	  return nullptr;
+	}
+	ancestors.pop_back();
+      }
+
+      if (type != START_TAG)
+	continue;
+
+      switch (path.match(ancestors.size(), tokenizer.getTagName())) {
+	case ElementPath::FULL_MATCH: {
+	  ElementSink sink;
+	  TreeBuilder builder(sink);
+	  builder.setSingleElement(true);
+	  builder.addTokens(tokenizer, START_TAG);
+	  record = sink.release();
+	  ++count;
+	  return record.get();
+	}
+	case ElementPath::PARTIAL_MATCH:
+	  ancestors.push_back(tokenizer.getTagName());
+	  break;
+	case ElementPath::NO_MATCH:
+	  tokenizer.skipElement();
+	  break;
+      }
+    }
+
+    if (!ancestors.empty())
+      tokenizer.setError(UNCLOSED_ELEMENT, tokenizer.getOffset());
+    return nullptr;
+  }
+
+  /**
+   * Function which hands each remaining record to a callback. The record is freed when the callback returns.
+   *
+   *@param onRecord Function called with each record.
+   *@return The number of records handed to the callback.
+   */
+  size_t RecordReader::forEach(const std::function<void(ElementNode&)>& onRecord)
+  {
+    size_t handled = 0;
+    while (ElementNode* elem = next()) {
+      onRecord(*elem);
+      ++handled;
+    }
+    return handled;
+  }
+
+  /**
+   * Function which returns the number of records read so far.
+   *
+   *@return The number of records.
+   */
+  size_t RecordReader::getCount() const
+  {
+    return count;
+  }
+
+}
@@ -0,0 +1,52 @@
+#ifndef __RECORDREADER_H__
+#define __RECORDREADER_H__
+
+#include <string>
+#include <memory>
+#include <istream>
+#include <vector>
+#include <functional>
+#include "Encoding.h"
+#include "XMLTokenizer.h"
+#include "ElementPath.h"
+
+namespace tinyXMLpp {
+
+  class ElementNode;
+
+  /*Streams through a document, handing back the elements at a path
+    one at a time as small trees of their own. Only the current record
+    is kept; it is freed when the next one is read, so memory stays
+    bounded by the largest record rather than by the document.
+
+      RecordReader reader(is, "catalog/book");
+      while (ElementNode* book = reader.next()) { ... }
+
+    The default path selects the children of the root element.*/
+  class RecordReader {
+
+    DecodedInput input;
+    XMLTokenizer tokenizer;
+    ElementPath path;
+    std::vector<std::string> ancestors;	//open elements the records are inside
+    std::unique_ptr<ElementNode> record;
+    size_t count;
+
+    public:
+    RecordReader(std::istream& is, const std::string& elementPath = "*/*");
+    ~RecordReader();
+
+    /*Reads the next record, freeing the previous one. Returns nullptr
+      once the input is exhausted.*/
+    ElementNode* next();
+
+    /*Calls onRecord with each remaining record, returning how many there were*/
+    size_t forEach(const std::function<void(ElementNode&)>& onRecord);
+
+    /*Number of records read so far*/
+    size_t getCount() const;
+  };
+
+}
+
+#endif
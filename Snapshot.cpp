@@ -0,0 +1,363 @@
+#include "Snapshot.h"
+#include "Document.h"
+#include "ElementNode.h"
+#include "TextNode.h"
+#include "CDATANode.h"
+#include "CommentNode.h"
+#include "Attribute.h"
+#include "XMLException.h"
+#include "Namespace.h"
+
+#include <fstream>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace tinyXMLpp {
+
+  namespace {
+
+    const char SNAPSHOT_MAGIC[8] = { 'T', 'X', 'P', 'P', 'S', 'N', 'A', 'P' };
+    const uint32_t SNAPSHOT_VERSION = 2;
+
+    /*State used while flattening a Document into the snapshot tables*/
+    struct SnapshotWriter {
+      std::vector<Snapshot::NodeRecord> nodes;
+      std::vector<Snapshot::AttributeRecord> attributes;
+      std::vector<Snapshot::NameRecord> names;
+      std::unordered_map<std::string, uint32_t> nameIndex;
+      std::string heap;
+
+      /*Offsets and lengths in the records are 32 bits, so the whole heap must stay below 4 GB*/
+      uint32_t addString(const std::string& str) {
+	if (str.size() > UINT32_MAX - heap.size())
+	  throw XMLException("Document too large for a snapshot: its strings exceed 4 GB");
+	uint32_t offset = heap.size();
+	heap.append(str);
+	return offset;
+      }
+
+      uint32_t addName(const std::string& name) {
+	auto it = nameIndex.find(name);
+	if (it != nameIndex.end())
+	  return it->second;
+
+	Snapshot::NameRecord record;
+	record.offset = addString(name);
+	record.length = name.size();
+	names.push_back(record);
+	nameIndex[name] = names.size() - 1;
+	return names.size() - 1;
+      }
+
+      void addText(Snapshot::NodeRecord& record, const std::string& text) {
+	record.value = addString(text);
+	record.length = text.size();
+      }
+
+      void addRecord(const Node* node) {
+	Snapshot::NodeRecord record = Snapshot::NodeRecord();
+	record.childCount = node->getChildren().size();
+
+	if (const ElementNode* elem = dynamic_cast<const ElementNode*>(node)) {
+	  record.type = Snapshot::ELEMENT_RECORD;
+	  record.value = addName(elem->getName());
+	  record.length = addName(elem->getNamespaceURI());
+	  record.firstAttribute = attributes.size();
+	  record.attributeCount = elem->getAttributes().size();
+
+	  ConstPointerList<Attribute> attribs = elem->getAttributes();
+	  for (size_t i = 0; i < attribs.size(); ++i) {
+	    Snapshot::AttributeRecord attr;
+	    attr.name = addName(attribs[i]->getName());
+	    attr.namespaceURI = addName(attribs[i]->getNamespaceURI());
+	    attr.valueOffset = addString(attribs[i]->getValue());
+	    attr.valueLength = attribs[i]->getValue().size();
+	    attributes.push_back(attr);
+	  }
+	}
+	else if (const TextNode* text = dynamic_cast<const TextNode*>(node)) {
+	  record.type = Snapshot::TEXT_RECORD;
+	  addText(record, text->getText());
+	}
+	else if (const CDATANode* cdata = dynamic_cast<const CDATANode*>(node)) {
+	  record.type = Snapshot::CDATA_RECORD;
+	  addText(record, cdata->getcdata());
+	}
+	else if (const CommentNode* comment = dynamic_cast<const CommentNode*>(node)) {
+	  record.type = Snapshot::COMMENT_RECORD;
+	  addText(record, comment->getContent());
+	}
+	else
+	  throw XMLException("Unknown node type found while writing snapshot");
+
+	nodes.push_back(record);
+      }
+
+      /*Adds the records of a subtree in preorder, keeping the nodes still to visit on a stack rather than recursing*/
+      void addNode(const Node* root) {
+	std::vector<const Node*> pending(1, root);
+	while (!pending.empty()) {
+	  const Node* node = pending.back();
+	  pending.pop_back();
+	  addRecord(node);
+
+	  ConstPointerList<Node> children = node->getChildren();
+	  for (size_t i = children.size(); i > 0; --i) {
+	    pending.push_back(children[i - 1]);
+	  }
+	}
+      }
+    };
+
+    /*Read-only view over a mapped snapshot file*/
+    struct SnapshotReader {
+      const char* base;
+      size_t size;
+      const Snapshot::Header* header;
+      const Snapshot::NodeRecord* nodes;
+      const Snapshot::AttributeRecord* attributes;
+      const Snapshot::NameRecord* names;
+      const char* heap;
+      uint32_t next;
+
+      void checkRange(uint64_t offset, uint64_t length) const {
+	if (offset > size || length > size - offset)
+	  throw XMLException("Snapshot is truncated or corrupt");
+      }
+
+      /*A table of records must also start on a boundary of its record type, or reading the records through a pointer
+	is undefined. The mapping itself starts on a page.*/
+      void checkTable(uint64_t offset, uint64_t count, size_t recordSize, size_t alignment) const {
+	if (offset % alignment != 0)
+	  throw XMLException("Snapshot table is misaligned");
+	checkRange(offset, count * recordSize);
+      }
+
+      std::string getString(uint32_t offset, uint32_t length) const {
+	if ((uint64_t)offset + length > header->heapSize)
+	  throw XMLException("Snapshot string lies outside of the heap");
+	return std::string(heap + offset, length);
+      }
+
+      std::string getName(uint32_t index) const {
+	if (index >= header->nameCount)
+	  throw XMLException("Snapshot name index out of range");
+	return getString(names[index].offset, names[index].length);
+      }
+
+      /*Namespace ids of the URIs in the name table, interned the first time each one is used and held until the
+	document is rebuilt*/
+      std::vector<uint32_t> namespaceIds;
+
+      ~SnapshotReader() {
+	for (size_t i = 0; i < namespaceIds.size(); ++i) {
+	  if (namespaceIds[i] != UINT32_MAX)
+	    NamespaceTable::release(namespaceIds[i]);
+	}
+      }
+
+      uint32_t getNamespace(uint32_t index) {
+	if (index >= header->nameCount)
+	  throw XMLException("Snapshot name index out of range");
+	if (namespaceIds.empty())
+	  namespaceIds.resize(header->nameCount, UINT32_MAX);
+	if (namespaceIds[index] == UINT32_MAX) {
+	  namespaceIds[index] = NamespaceTable::intern(getName(index));
+	  if (namespaceIds[index] == NamespaceTable::INVALID_NAMESPACE)
+	    throw XMLException(getErrorMessage(NAMESPACE_LIMIT_EXCEEDED));
+	}
+	return namespaceIds[index];
+      }
+
+      /*Builds the node of the current record, without its children. Their number is left in childCount.*/
+      std::unique_ptr<Node> readRecord(uint32_t& childCount) {
+	if (next >= header->nodeCount)
+	  throw XMLException("Snapshot node table ended unexpectedly");
+
+	const Snapshot::NodeRecord& record = nodes[next++];
+	childCount = record.childCount;
+	if (childCount > header->nodeCount - next)
+	  throw XMLException("Snapshot node table ended unexpectedly");
+
+	switch (record.type) {
+	  case Snapshot::ELEMENT_RECORD: {
+	    std::unique_ptr<ElementNode> elem(ElementNode::createElementNode(getName(record.value)));
+	    if ((uint64_t)record.firstAttribute + record.attributeCount > header->attributeCount)
+	      throw XMLException("Snapshot attribute range out of bounds");
+	    elem->setNamespaceId(getNamespace(record.length));
+	    for (uint32_t i = 0; i < record.attributeCount; ++i) {
+	      const Snapshot::AttributeRecord& attr = attributes[record.firstAttribute + i];
+	      std::unique_ptr<Attribute> attrib(new Attribute(getName(attr.name), getString(attr.valueOffset, attr.valueLength)));
+	      attrib->setNamespaceId(getNamespace(attr.namespaceURI));
+	      elem->addAttribute(std::move(attrib));
+	    }
+	    return std::unique_ptr<Node>(elem.release());
+	  }
+	  case Snapshot::TEXT_RECORD:
+	    return std::unique_ptr<Node>(TextNode::createTextNode(getString(record.value, record.length)));
+	  case Snapshot::CDATA_RECORD:
+	    return std::unique_ptr<Node>(CDATANode::createCDATANode(getString(record.value, record.length)));
+	  case Snapshot::COMMENT_RECORD:
+	    return std::unique_ptr<Node>(CommentNode::createCommentNode(getString(record.value, record.length)));
+	  default:
+	    throw XMLException("Unknown record type found in snapshot");
+	}
+      }
+
+      /*Rebuilds the top level nodes of the document and their subtrees. The elements whose children are still to come
+	are kept on a stack rather than recursing, and each node is attached as soon as it is built, so a corrupt snapshot
+	frees whatever was built with the document. Trees deeper than maxDepth are refused, as the Node destructor and
+	write could not walk them.*/
+      void readNodes(Document& doc, uint32_t topLevelCount, size_t maxDepth) {
+	struct OpenNode {
+	  Node* node;
+	  uint32_t childrenLeft;
+	};
+	std::vector<OpenNode> open;
+
+	while (topLevelCount > 0 || !open.empty()) {
+	  if (!open.empty() && open.back().childrenLeft == 0) {
+	    open.pop_back();
+	    continue;
+	  }
+
+	  uint32_t childCount;
+	  std::unique_ptr<Node> node = readRecord(childCount);
+	  Node* added = node.get();
+	  if (open.empty()) {
+	    doc.addChildNode(std::move(node));
+	    --topLevelCount;
+	  }
+	  else {
+	    open.back().node->addChildNode(std::move(node));
+	    --open.back().childrenLeft;
+	  }
+
+	  if (childCount > 0) {
+	    if (open.size() + 1 > maxDepth)
+	      throw XMLException(getErrorMessage(DEPTH_LIMIT_EXCEEDED));
+	    OpenNode entry = { added, childCount };
+	    open.push_back(entry);
+	  }
+	}
+      }
+    };
+
+  }
+
+  /**
+   * Function which writes the given document to a file as a binary snapshot. The snapshot stores the nodes in preorder,
+   * with element and attribute names interned in a name table and all other strings in a single heap.
+   *
+   *@param doc The document to be saved.
+   *@param path The path of the snapshot file.
+   */
+  void Snapshot::save(const Document& doc, const std::string& path)
+  {
+    SnapshotWriter writer;
+
+    Snapshot::NodeRecord root = Snapshot::NodeRecord();
+    root.type = DOCUMENT_RECORD;
+    root.childCount = doc.getChildren().size();
+    writer.nodes.push_back(root);
+
+    const std::vector<Node*>& children = doc.getChildren();
+    for (size_t i = 0; i < children.size(); ++i) {
+      writer.addNode(children[i]);
+    }
+
+    Header header;
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.nodeCount = writer.nodes.size();
+    header.attributeCount = writer.attributes.size();
+    header.nameCount = writer.names.size();
+    header.heapSize = writer.heap.size();
+    header.nodesOffset = sizeof(Header);
+    header.attributesOffset = header.nodesOffset + writer.nodes.size() * sizeof(NodeRecord);
+    header.namesOffset = header.attributesOffset + writer.attributes.size() * sizeof(AttributeRecord);
+    header.heapOffset = header.namesOffset + writer.names.size() * sizeof(NameRecord);
+
+    std::ofstream file(path.c_str(), std::ios::binary);
+    if (!file)
+      throw XMLException("Unable to open snapshot file " + path);
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(writer.nodes.data()), writer.nodes.size() * sizeof(NodeRecord));
+    file.write(reinterpret_cast<const char*>(writer.attributes.data()), writer.attributes.size() * sizeof(AttributeRecord));
+    file.write(reinterpret_cast<const char*>(writer.names.data()), writer.names.size() * sizeof(NameRecord));
+    file.write(writer.heap.data(), writer.heap.size());
+
+    if (!file)
+      throw XMLException("Error while writing snapshot file " + path);
+  }
+
+  /**
+   * Function which maps a snapshot file read-only and rebuilds the Document it holds. No tokenizing is done; every string
+   * is copied straight out of the mapped heap with its length known up front.
+   *
+   *@param path The path of the snapshot file.
+   *@param limits Bounds on the document; only maxDepth is used.
+   *@return A unique_ptr to the Document stored in the snapshot.
+   */
+  std::unique_ptr<Document> Snapshot::load(const std::string& path, const ParseLimits& limits)
+  {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw XMLException("Unable to open snapshot file " + path);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(Header)) {
+      close(fd);
+      throw XMLException("Snapshot file " + path + " is too small");
+    }
+
+    void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+      throw XMLException("Unable to map snapshot file " + path);
+
+    std::unique_ptr<Document> doc(new Document());
+
+    try {
+      SnapshotReader reader;
+      reader.base = static_cast<const char*>(mapping);
+      reader.size = st.st_size;
+      reader.header = reinterpret_cast<const Header*>(reader.base);
+      reader.next = 0;
+
+      const Header* header = reader.header;
+      if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 || header->version != SNAPSHOT_VERSION)
+	throw XMLException("File " + path + " is not a tinyXMLpp snapshot");
+
+      reader.checkTable(header->nodesOffset, header->nodeCount, sizeof(NodeRecord), alignof(NodeRecord));
+      reader.checkTable(header->attributesOffset, header->attributeCount, sizeof(AttributeRecord), alignof(AttributeRecord));
+      reader.checkTable(header->namesOffset, header->nameCount, sizeof(NameRecord), alignof(NameRecord));
+      reader.checkRange(header->heapOffset, header->heapSize);
+
+      reader.nodes = reinterpret_cast<const NodeRecord*>(reader.base + header->nodesOffset);
+      reader.attributes = reinterpret_cast<const AttributeRecord*>(reader.base + header->attributesOffset);
+      reader.names = reinterpret_cast<const NameRecord*>(reader.base + header->namesOffset);
+      reader.heap = reader.base + header->heapOffset;
+
+      if (header->nodeCount == 0 || reader.nodes[0].type != DOCUMENT_RECORD)
+	throw XMLException("Snapshot " + path + " has no document record");
+
+      uint32_t topLevelCount = reader.nodes[reader.next++].childCount;
+      reader.readNodes(*doc, topLevelCount, limits.maxDepth);
+    }
+    catch (...) {
+      munmap(mapping, st.st_size);
+      throw;
+    }
+
+    munmap(mapping, st.st_size);
+    return doc;
+  }
+
+}
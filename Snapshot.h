@@ -0,0 +1,69 @@
+#ifndef __SNAPSHOT_H__
+#define __SNAPSHOT_H__
+
+#include <string>
+#include <memory>
+#include <cstdint>
+#include "ParseLimits.h"
+
+namespace tinyXMLpp{
+
+  class Document;
+
+  /*Binary image of a Document. All references inside the image are
+    offsets, so it can be mapped at any address and read in place.
+
+    Layout: Header | NodeRecord[] | AttributeRecord[] | NameRecord[] | heap
+    Node records are stored in preorder. Record 0 stands for the Document
+    itself, and each record is followed by its childCount subtrees.*/
+  class Snapshot {
+
+    public:
+    enum RecordType { DOCUMENT_RECORD, ELEMENT_RECORD, TEXT_RECORD, CDATA_RECORD, COMMENT_RECORD };
+
+    struct Header {
+      char magic[8];
+      uint32_t version;
+      uint32_t nodeCount;
+      uint32_t attributeCount;
+      uint32_t nameCount;
+      uint64_t heapSize;
+      uint64_t nodesOffset;
+      uint64_t attributesOffset;
+      uint64_t namesOffset;
+      uint64_t heapOffset;
+    };
+
+    struct NodeRecord {
+      uint32_t type;
+      uint32_t childCount;
+      uint32_t value;			//name index for elements, heap offset otherwise
+      uint32_t length;			//heap length of the text, name index of the namespace URI for elements
+      uint32_t firstAttribute;
+      uint32_t attributeCount;
+    };
+
+    struct AttributeRecord {
+      uint32_t name;
+      uint32_t valueOffset;
+      uint32_t valueLength;
+      uint32_t namespaceURI;		//name index
+    };
+
+    struct NameRecord {
+      uint32_t offset;
+      uint32_t length;
+    };
+
+    /*Writes the document as a binary image to the given path*/
+    static void save(const Document& doc, const std::string& path);
+
+    /*Maps the binary image at path and rebuilds the document from it.
+      Corrupt images are rejected, as are trees nested deeper than
+      limits.maxDepth.*/
+    static std::unique_ptr<Document> load(const std::string& path, const ParseLimits& limits = ParseLimits());
+  };
+
+}
+
+#endif
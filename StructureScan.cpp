@@ -0,0 +1,160 @@
+#include "StructureScan.h"
+#include "XMLTokenizer.h"
+
+#include <cstring>
+
+namespace tinyXMLpp {
+
+  namespace {
+    /*Finds the next occurrence of c at or after p. Returns end if there is none.*/
+    const char* find(const char* p, const char* end, char c)
+    {
+      const char* found = static_cast<const char*>(memchr(p, c, end - p));
+      return found != nullptr ? found : end;
+    }
+
+    /*Returns the position right after the next occurrence of c, or end if there is none*/
+    const char* skipPast(const char* p, const char* end, char c)
+    {
+      p = find(p, end, c);
+      return p < end ? p + 1 : end;
+    }
+
+    /*Returns the position right after a terminator like "-->" or "]]>" found at or after start, or end if there is none.
+      times is how often the repeated character comes before the '>', 1 for the "?>" of a processing instruction.*/
+    const char* skipPastTerminator(const char* start, const char* end, char repeated, int times = 2)
+    {
+      const char* gt = start;
+      while ((gt = find(gt, end, '>')) < end) {
+	if (gt - start >= times && gt[-1] == repeated && (times == 1 || gt[-2] == repeated))
+	  return gt + 1;
+	++gt;
+      }
+      return end;
+    }
+
+    /*Whether a run of text becomes a text node under the flags*/
+    bool isTextNode(const char* p, const char* end, unsigned flags)
+    {
+      if (flags & PARSE_NO_TEXT)
+	return false;
+      if (!(flags & PARSE_TRIM_WHITESPACE))
+	return true;
+      for (; p < end; ++p) {
+	if (*p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+	  return true;
+      }
+      return false;
+    }
+  }
+
+  /**
+   * Constructor which scans the document. Text is skipped with memchr up to the next '<'; comments, CDATA sections, end
+   * tags and processing instructions such as the XML declaration are skipped up to the '>' that ends them. Only start tags are read byte by byte, counting the '=' outside quoted
+   * values to count the attributes. Every non-empty run of text between two pieces of markup counts as one child, the
+   * same as the tokenizer makes one text token of it, unless the flags drop it.
+   *
+   *@param data The document, past its byte order mark.
+   *@param length The length of the document in bytes.
+   *@param flags The ParseFlags the document will be parsed with.
+   */
+  StructureScan::StructureScan(const char* data, size_t length, unsigned flags)
+  {
+    const char* p = data;
+    const char* end = data + length;
+    std::vector<uint32_t> open;		//elements whose end tag was not reached yet
+
+    while (p < end) {
+
+      const char* lt = find(p, end, '<');
+      if (lt == end)
+	break;
+      if (lt > p && !open.empty() && isTextNode(p, lt, flags))
+	++childCounts[open.back()];
+
+      p = lt + 1;
+      if (p == end)
+	break;
+
+      if (*p == '/') {
+	if (!open.empty())
+	  open.pop_back();
+	p = skipPast(p, end, '>');
+      }
+      else if (*p == '?')
+	p = skipPastTerminator(p + 1, end, '?', 1);
+      else if (*p == '!') {
+	bool skipped;
+	if (end - p >= 3 && memcmp(p, "!--", 3) == 0) {
+	  skipped = (flags & PARSE_SKIP_COMMENTS) != 0;
+	  p = skipPastTerminator(p + 3, end, '-');
+	}
+	else if (end - p >= 8 && memcmp(p, "![CDATA[", 8) == 0) {
+	  skipped = (flags & PARSE_SKIP_CDATA) != 0;
+	  p = skipPastTerminator(p + 8, end, ']');
+	}
+	else {
+	  skipped = false;
+	  p = skipPast(p, end, '>');
+	}
+	if (!skipped && !open.empty())
+	  ++childCounts[open.back()];
+      }
+      else {
+	if (!open.empty())
+	  ++childCounts[open.back()];
+	uint32_t element = childCounts.size();
+	childCounts.push_back(0);
+	attributeCounts.push_back(0);
+
+	/*a '>' inside a quoted value does not end the tag*/
+	while (p < end && *p != '>') {
+	  if (*p == '"' || *p == '\'')
+	    p = find(p + 1, end, *p);
+	  else if (*p == '=')
+	    ++attributeCounts[element];
+	  if (p < end)
+	    ++p;
+	}
+	if (p == end)
+	  break;
+	if (p[-1] != '/')
+	  open.push_back(element);
+	++p;
+      }
+    }
+  }
+
+  /**
+   * Function which returns the number of elements found.
+   *
+   *@return The number of start tags in the document.
+   */
+  size_t StructureScan::getElementCount() const
+  {
+    return childCounts.size();
+  }
+
+  /**
+   * Function which returns the number of children of an element.
+   *
+   *@param element The number of the element, counted in the order of the start tags.
+   *@return The number of child nodes of the element.
+   */
+  uint32_t StructureScan::getChildCount(size_t element) const
+  {
+    return childCounts[element];
+  }
+
+  /**
+   * Function which returns the number of attributes of an element.
+   *
+   *@param element The number of the element, counted in the order of the start tags.
+   *@return The number of attributes of the element.
+   */
+  uint32_t StructureScan::getAttributeCount(size_t element) const
+  {
+    return attributeCounts[element];
+  }
+
+}
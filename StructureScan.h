@@ -0,0 +1,35 @@
+#ifndef __STRUCTURESCAN_H__
+#define __STRUCTURESCAN_H__
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace tinyXMLpp {
+
+  /*Counts the children and attributes of every element of a document
+    held in memory, in one pass that only looks for the bytes ending
+    each construct. Elements are numbered in the order of their start
+    tags, which is the order a parser creates them in, so the counts
+    can size each element's lists before they are filled. Given the
+    ParseFlags of the parse, the scan leaves out the comments, CDATA
+    and text the tokenizer will skip, so those do not count either.
+
+    The scan does not check the document. Malformed input only gives
+    wrong counts; it is the parse that rejects it.*/
+  class StructureScan {
+
+    std::vector<uint32_t> childCounts;
+    std::vector<uint32_t> attributeCounts;
+
+    public:
+    StructureScan(const char* data, size_t length, unsigned flags = 0);
+
+    size_t getElementCount() const;
+    uint32_t getChildCount(size_t element) const;
+    uint32_t getAttributeCount(size_t element) const;
+  };
+
+}
+
+#endif
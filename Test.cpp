@@ -1,13 +1,1097 @@
 #include "tinyXMLpp.h"
 #include "Acceptance.h"
+#include "StructureScan.h"
+#include "GzipStream.h"
 
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <cassert>
+#include <cstring>
+#include <type_traits>
+#include <iterator>
+#include <thread>
+#include <atomic>
 
 using namespace tinyXMLpp;
 
+/*An exception thrown by a BatchParser callback reaches the caller after every worker is joined*/
+void testBatchCallbackException()
+{
+  std::vector<std::string> buffers(64, "<a><b>text</b></a>");
+  BatchParser batch(4);
+  bool thrown = false;
+  try {
+    batch.parseBuffers(buffers, [](size_t index, ParseResult& result) {
+	if (index == 10)
+	  throw std::runtime_error("callback failed");
+	});
+  }
+  catch (std::runtime_error& e) {
+    thrown = std::string(e.what()) == "callback failed";
+  }
+  assert(thrown);
+}
+
+/*An index whose header claims more entries than the file holds is rejected before anything is allocated for them*/
+void testCorruptIndex()
+{
+  std::istringstream xml("<list><item>1</item><item>2</item></list>");
+  XMLIndex::build(xml, "list/item").save("test.idx");
+
+  std::fstream file("test.idx", std::ios::in | std::ios::out | std::ios::binary);
+  uint64_t count = 0xffffffffffffull;
+  file.seekp(8);
+  file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+  file.close();
+
+  bool rejected = false;
+  try {
+    XMLIndex::load("test.idx");
+  }
+  catch (XMLException& e) {
+    rejected = true;
+  }
+  assert(rejected);
+}
+
+/*A subtree moved between two documents parsed with source tracking is written from its nodes, not from the wrong source*/
+void testMoveBetweenTrackedDocuments()
+{
+  Parser p;
+  p.setSourceTracking(true);
+  std::istringstream in1("<r><keep>AAAAAAAAAAAAAAAAAAAA<i>x</i></keep><r>1</r></r>");
+  std::istringstream in2("<q>11111111111111111111111111111111<r>2</r></q>");
+  std::unique_ptr<Document> from = p.parse(in1);
+  std::unique_ptr<Document> to = p.parse(in2);
+
+  to->getRootElement()->addChildNode(from->getRootElement()->releaseChildNode(0));
+
+  std::ostringstream incremental, full;
+  to->write(incremental);
+  to->clone()->write(full);
+  assert(incremental.str() == full.str());
+  assert(incremental.str().find("<keep>AAAAAAAAAAAAAAAAAAAA<i>x</i></keep></q>") != std::string::npos);
+
+  std::ostringstream rest;
+  from->write(rest);
+  assert(rest.str() == "<r><r>1</r></r>");
+}
+
+/*A frozen tree only hands out const nodes, whichever way it is walked*/
+void testFrozenTreeIsConst()
+{
+  std::istringstream in("<r a=\"1\"><b>x</b><c/></r>");
+  Parser p;
+  std::shared_ptr<const FrozenDocument> frozen = p.parse(in)->freeze();
+  const ElementNode* root = frozen->getRootElement();
+
+  static_assert(std::is_same<decltype(root->getChildren()[0]), const Node*>::value, "children of a const node are const");
+  static_assert(std::is_same<decltype(*root->getChildren().begin()), const Node*>::value, "children of a const node are const");
+  static_assert(std::is_same<decltype(root->getChild(0)->getParentNode()), const Node*>::value, "parent of a const node is const");
+  static_assert(std::is_same<decltype(root->getChild(0)->getNextSibling()), const Node*>::value, "siblings of a const node are const");
+  static_assert(std::is_same<decltype(root->getAttributes()[0]), const Attribute*>::value, "attributes of a const node are const");
+
+  int count = 0;
+  for (const Node* child : root->getChildren()) {
+    assert(child->getParentNode() == root);
+    ++count;
+  }
+  assert(count == 2);
+  assert(root->getChild(0)->getNextSibling() == root->getChildren().back());
+}
+
+/*Byte order marks and UTF-16 read with a BOM, the way the tests write them*/
+std::string encodeUtf16(const std::u16string& text, bool bigEndian)
+{
+  std::string bytes(bigEndian ? "\xFE\xFF" : "\xFF\xFE");
+  for (char16_t unit : text) {
+    char high = unit >> 8, low = unit & 0xFF;
+    bytes += bigEndian ? high : low;
+    bytes += bigEndian ? low : high;
+  }
+  return bytes;
+}
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+/*Awaits the tokens of an AsyncParser, keeping the type of the last one*/
+Task<int> awaitTokens(AsyncParser& async, TokenType& last)
+{
+  int count = 0;
+  do {
+    last = co_await async.nextToken();
+    ++count;
+  } while (last != ENDOFFILE);
+  co_return count;
+}
+
+/*The end tag of a self closing element is handed out as soon as its start tag is, without waiting for more input*/
+void testAsyncSelfClosingEndTag()
+{
+  AsyncParser async;
+  TokenType last = BOF;
+  Task<int> task = awaitTokens(async, last);
+  std::string xml = "<r><a/>";
+  async.feed(xml.data(), xml.size());
+  assert(last == END_TAG && async.getTokenizer().getTagName() == "a" && !task.isReady());
+
+  xml = "</r>";
+  async.feed(xml.data(), xml.size());
+  async.close();
+  assert(task.isReady() && last == ENDOFFILE);
+}
+#endif
+
+/*Converts text to a T, returning false where the conversion throws*/
+template<typename T>
+bool converts(const std::string& text, T& out)
+{
+  try {
+    convertValue(text, out);
+    return true;
+  }
+  catch (XMLException&) {
+    return false;
+  }
+}
+
+/*Bound values accept whitespace around them and nothing else, and numbers must fit their member*/
+void testBindingConversions()
+{
+  int i = 0;
+  assert(converts(" \n42\t", i) && i == 42);
+  assert(!converts("42x", i) && !converts("", i) && !converts("99999999999", i));
+
+  unsigned int u = 0;
+  assert(converts("7", u) && u == 7 && !converts("-1", u));
+
+  double d = 0;
+  assert(converts(" 2.5 ", d) && d == 2.5 && !converts("2.5.1", d));
+
+  bool b = false;
+  assert(converts(" true\n", b) && b && converts("0", b) && !b);
+  assert(!converts("true junk", b) && !converts("yes", b) && !converts("", b));
+}
+
+/*Records are read from attributes and the text of direct children, while other elements inside them are skipped*/
+void testBindingRead()
+{
+  struct Book { int id; std::string title; double price; bool stocked; };
+  auto binding = makeBinding<Book>("book", bindAttribute("id", &Book::id), bindAttribute("stocked", &Book::stocked),
+      bindElement("title", &Book::title), bindElement("price", &Book::price));
+
+  std::istringstream in("<shelf><book id='1' stocked='true'><title>A<![CDATA[<b>]]></title>"
+      "<extra><price>9</price></extra><price> 2.5 </price></book>"
+      "<book id=\"2\" stocked=\"0\"><title>B</title><price>4</price></book></shelf>");
+  std::vector<Book> books;
+  assert(binding.read(in, [&](const Book& book) { books.push_back(book); }) == 2);
+  assert(books[0].id == 1 && books[0].stocked && books[0].title == "A<b>" && books[0].price == 2.5);
+  assert(books[1].id == 2 && !books[1].stocked && books[1].title == "B" && books[1].price == 4);
+
+  std::istringstream bad("<shelf><book id='x'/></shelf>");
+  bool rejected = false;
+  try {
+    binding.read(bad, [](const Book&) {});
+  }
+  catch (XMLException&) {
+    rejected = true;
+  }
+  assert(rejected);
+}
+
+/*gzip files are parsed after a write through GzipOutputBuffer, zlib data reads back through GzipInputBuffer, and plain
+  text that happens to look like a zlib header is only taken for one when asked to*/
+void testCompressionRoundTrip()
+{
+  const std::string xml = "<r><a x=\"1\">text</a><b/></r>";
+  {
+    std::ofstream file("test.xml.gz", std::ios::binary);
+    GzipOutputBuffer gzip(file.rdbuf());
+    std::ostream os(&gzip);
+    os << xml;
+    assert(gzip.finish());
+  }
+  Parser p;
+  std::ostringstream parsed;
+  p.parse(std::string("test.xml.gz"))->write(parsed);
+  assert(parsed.str() == "<r><a x=\"1\">text</a><b></b></r>");
+
+  std::vector<unsigned char> packed(compressBound(xml.size()));
+  uLongf packedLength = packed.size();
+  assert(compress(&packed[0], &packedLength, reinterpret_cast<const Bytef*>(xml.data()), xml.size()) == Z_OK);
+  std::istringstream zlibData(std::string(reinterpret_cast<const char*>(&packed[0]), packedLength));
+  assert(!GzipInputBuffer::isCompressed(zlibData) && GzipInputBuffer::isCompressed(zlibData, true));
+  GzipInputBuffer inflated(zlibData.rdbuf());
+  std::istream is(&inflated);
+  assert(std::string(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>()) == xml);
+
+  std::istringstream lookalike("x^ is not compressed");
+  assert(!GzipInputBuffer::isCompressed(lookalike) && GzipInputBuffer::isCompressed(lookalike, true));
+  assert(lookalike.get() == 'x');
+}
+
+/*Every entry point of the parser reads a byte order mark and transcodes UTF-16 the same way*/
+void testByteOrderMarks()
+{
+  const std::u16string text = u"<r a=\"\u00e9\"><b>x</b><b>y</b></r>";
+  std::vector<std::string> inputs = { "\xEF\xBB\xBF<r a=\"\xC3\xA9\"><b>x</b><b>y</b></r>",
+    encodeUtf16(text, false), encodeUtf16(text, true) };
+
+  for (const std::string& bytes : inputs) {
+    Parser p;
+    std::istringstream in1(bytes), in2(bytes), in3(bytes), in4(bytes), in5(bytes);
+    assert(p.parse(in1)->getRootElement()->getAttribute("a")->getValue() == "\xC3\xA9");
+    assert(p.parsePipelined(in2)->getRootElement()->getAttribute("a")->getValue() == "\xC3\xA9");
+
+    std::unique_ptr<FlatDocument> flat = p.parseFlat(in3);
+    assert(flat->getAttributeValue(flat->getRootElement(), 0) == "\xC3\xA9");
+    assert(p.parseElement(in4)->getChildCount() == 2);
+
+    RecordReader reader(in5, "r/b");
+    assert(reader.forEach([](ElementNode&) {}) == 2);
+
+    std::istringstream in6(bytes), in7(bytes), in8(bytes);
+    std::ostringstream transformed;
+    TransformPipeline().run(in6, transformed);
+    assert(transformed.str() == "<r a=\"\xC3\xA9\"><b>x</b><b>y</b></r>");
+
+    struct Root { std::string a; };
+    std::string a;
+    makeBinding<Root>("r", bindAttribute("a", &Root::a)).read(in7, [&](const Root& r) { a = r.a; });
+    assert(a == "\xC3\xA9");
+
+    /*index offsets count the byte order mark, so they can be seeked to; UTF-16 offsets could not be*/
+    if (bytes[0] == '\xEF') {
+      assert(XMLIndex::build(in8, "r/b").getEntry(0).offset == bytes.find("<b>"));
+    }
+    else {
+      bool rejected = false;
+      try {
+	XMLIndex::build(in8, "r/b");
+      }
+      catch (XMLException&) {
+	rejected = true;
+      }
+      assert(rejected);
+    }
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+    AsyncParser async;
+    Task<std::unique_ptr<Document>> task = async.parse();
+    for (char c : bytes)
+      async.feed(&c, 1);
+    async.close();
+    assert(task.get()->getRootElement()->getAttribute("a")->getValue() == "\xC3\xA9");
+#endif
+  }
+
+  /*an unpaired surrogate*/
+  std::string bad = encodeUtf16(u"<r>", false) + std::string("\x00\xD8", 2) + encodeUtf16(u"</r>", false).substr(2);
+  Parser p;
+  std::istringstream in1(bad), in2(bad);
+  Expected<Document> result = p.tryParse(in1);
+  assert(!result && result.getError().code == INVALID_UTF16);
+
+  ParseErrorCode code = PARSE_OK;
+  try {
+    p.parseFlat(in2);
+  }
+  catch (XMLException& e) {
+    code = e.getErrorCode();
+  }
+  assert(code == INVALID_UTF16);
+}
+
+/*Every way of building a tree checks the same rules and limits, and reports them with the same codes*/
+void testSameErrorsEverywhere()
+{
+  struct Case {
+    const char* xml;
+    ParseErrorCode code;
+  };
+  const Case cases[] = {
+    { "<a><b></a>", MISMATCHED_TAG },
+    { "<a><b>", UNCLOSED_ELEMENT },
+    { "<a><b><c/></b></a>", DEPTH_LIMIT_EXCEEDED },
+    { "<a><b/><b/><b/><b/></a>", NODE_LIMIT_EXCEEDED }
+  };
+  ParseLimits limits;
+  limits.maxDepth = 2;
+  limits.maxNodes = 4;
+
+  for (const Case& c : cases) {
+    Parser p;
+    p.setLimits(limits);
+    std::istringstream in1(c.xml), in2(c.xml), in3(c.xml), in4(c.xml);
+    std::vector<ParseErrorCode> codes;
+
+    codes.push_back(p.tryParse(in1).getError().code);
+    try { p.parseFlat(in2); codes.push_back(PARSE_OK); } catch (XMLException& e) { codes.push_back(e.getErrorCode()); }
+    try { p.parseElement(in3); codes.push_back(PARSE_OK); } catch (XMLException& e) { codes.push_back(e.getErrorCode()); }
+    try { p.parsePipelined(in4); codes.push_back(PARSE_OK); } catch (XMLException& e) { codes.push_back(e.getErrorCode()); }
+
+    for (ParseErrorCode code : codes)
+      assert(code == c.code);
+  }
+}
+
+/*RecordReader checks the end tags of its records and of the elements around them*/
+void testRecordReaderEndTags()
+{
+  const char* inputs[] = { "<list><item><a>1</b></item></list>", "<list><item>1</item></lust>" };
+  for (const char* xml : inputs) {
+    std::istringstream in(xml);
+    RecordReader reader(in, "list/item");
+    ParseErrorCode code = PARSE_OK;
+    try {
+      reader.forEach([](ElementNode&) {});
+    }
+    catch (XMLException& e) {
+      code = e.getErrorCode();
+    }
+    assert(code == MISMATCHED_TAG);
+  }
+
+  std::istringstream in("<list><skip><item/></skip><item a=\"1\"><b/></item><item/></list>");
+  RecordReader reader(in, "list/item");
+  ElementNode* first = reader.next();
+  assert(first != nullptr && first->getAttribute("a") != nullptr && first->getChildCount() == 1);
+  assert(reader.next() != nullptr && reader.next() == nullptr && reader.getCount() == 2);
+}
+
+/*parsePipelined honours source tracking and pre-scanning, across many batches of tokens*/
+void testPipelinedSettings()
+{
+  std::string xml = "<r>";
+  for (int i = 0; i < 2000; ++i)
+    xml += "<a x=\"" + std::to_string(i) + "\">text<!--c--><![CDATA[d]]></a>";
+  xml += "</r>";
+
+  Parser p;
+  p.setSourceTracking(true);
+  p.setPreScan(true);
+  std::istringstream in1(xml), in2(xml);
+  std::unique_ptr<Document> piped = p.parsePipelined(in1);
+  std::unique_ptr<Document> plain = p.parse(in2);
+  assert(piped->getSource() == xml && piped->equals(*plain));
+
+  piped->getRootElement()->removeChildNode(1000);
+  plain->getRootElement()->removeChildNode(1000);
+  std::ostringstream out1, out2;
+  piped->write(out1);
+  plain->write(out2);
+  assert(out1.str() == out2.str());
+}
+
+/*The pre-scan counts only the nodes the flags keep*/
+void testPreScanFollowsFlags()
+{
+  std::string xml = "<r>\n  <!--c-->\n  <a><![CDATA[d]]> t </a>\n</r>";
+  unsigned flagSets[] = { PARSE_DEFAULT, PARSE_SKIP_COMMENTS | PARSE_TRIM_WHITESPACE, PARSE_SKIP_CDATA, PARSE_NO_TEXT };
+  for (unsigned flags : flagSets) {
+    Parser p;
+    p.setFlags(flags);
+    p.setPreScan(true);
+    std::istringstream in(xml);
+    std::unique_ptr<Document> doc = p.parse(in);
+    ElementNode* root = doc->getRootElement();
+    ElementNode* a = doc->getElementsByTagName("a")[0];
+
+    StructureScan scan(xml.data(), xml.size(), flags);
+    assert(scan.getChildCount(0) == (uint32_t)root->getChildCount());
+    assert(scan.getChildCount(1) == (uint32_t)a->getChildCount());
+  }
+
+  /*processing instructions, the XML declaration among them, are not elements*/
+  std::string declared = "<?xml version=\"1.0\"?>\n<root a=\"1\"><x/><?pi a>b?><x/><x/></root>";
+  StructureScan scan(declared.data(), declared.size());
+  assert(scan.getElementCount() == 4);
+  assert(scan.getChildCount(0) == 3 && scan.getAttributeCount(0) == 1);
+  assert(scan.getChildCount(1) == 0 && scan.getAttributeCount(1) == 0);
+}
+
+/*skipElement steps over nested and self closing elements, comments, CDATA, quoted '>' and processing instructions*/
+void testSkipElement()
+{
+  std::istringstream in("<r><a x=\"1>2\" y='<b>'><b><c/></b><!-- <d> --><![CDATA[<e>]]><?pi <f> ?>"
+			"<b/>text</a><c/><a/><c/></r>");
+  XMLTokenizer t(in);
+  auto next = [](XMLTokenizer& t) {
+    TokenType type;
+    while ((type = t.getToken()) == TEXT);
+    return type;
+  };
+  assert(next(t) == START_TAG && t.getTagName() == "r");
+  assert(next(t) == START_TAG && t.getTagName() == "a");
+  t.skipElement();
+  assert(next(t) == START_TAG && t.getTagName() == "c");
+  assert(next(t) == END_TAG);
+
+  /*a self closing element has nothing left to skip*/
+  assert(next(t) == START_TAG && t.getTagName() == "a");
+  t.skipElement();
+  assert(next(t) == START_TAG && t.getTagName() == "c");
+  assert(next(t) == END_TAG);
+  assert(next(t) == END_TAG && t.getTagName() == "r");
+  assert(next(t) == ENDOFFILE && t.getError().code == PARSE_OK);
+
+  /*a processing instruction does not open an element that would swallow the rest*/
+  std::istringstream pi("<r><a><?pi x?><b/></a><c/></r>");
+  XMLTokenizer u(pi);
+  next(u);
+  next(u);
+  u.skipElement();
+  assert(next(u) == START_TAG && u.getTagName() == "c");
+
+  std::istringstream unclosed("<r><a><b></r>");
+  XMLTokenizer v(unclosed);
+  v.setThrowOnError(false);
+  next(v);
+  next(v);
+  v.skipElement();
+  assert(v.getError().code == UNEXPECTED_EOF);
+}
+
+/*Parses a document from a string, throwing on malformed input*/
+std::unique_ptr<Document> parseString(const std::string& xml)
+{
+  std::istringstream in(xml);
+  Parser p;
+  return p.parse(in);
+}
+
+/*The writer lays out elements, attributes, text, CDATA and comments as Document::write does, also when its buffer is
+  flushed many times over, and its output reads back as the same elements*/
+void testXMLWriter()
+{
+  std::ostringstream out;
+  {
+    XMLWriter writer(out, 4);
+    writer.startElement("r");
+    writer.addAttribute("a", "1");
+    writer.startElement("b");
+    writer.addText("text");
+    writer.endElement("b");
+    writer.addComment("note");
+    writer.addCDATA("<raw>");
+    writer.startElement("c");
+    writer.endElement("c");
+    writer.endElement("r");
+  }
+  assert(out.str() == "<r a=\"1\"><b>text</b><!--note--><![CDATA[<raw>]]>\n<c></c></r>");
+
+  std::unique_ptr<Document> doc = parseString(out.str());
+  assert(doc->getRootElement()->getAttribute("a")->getValue() == "1");
+  assert(doc->getElementsByTagName("b").size() == 1 && doc->getElementsByTagName("c").size() == 1);
+}
+
+/*Stages rename elements along with their end tags, drop comments and whole elements, and edit attributes and text; end
+  tags that do not match are rejected*/
+void testTransformPipeline()
+{
+  TransformPipeline pipeline;
+  pipeline.addStage(TransformPipeline::dropComments())
+    .addStage(TransformPipeline::renameElements("item", "entry"))
+    .addStage(TransformPipeline::dropElements("drop"))
+    .addStage([](TokenView& token) {
+	if (token.getType() == START_TAG && token.getAttributeCount() > 0)
+	  token.setAttributeValue(0, "v");
+	else if (token.getType() == TEXT && token.getText() == "y")
+	  token.setText("z");
+	return TransformPipeline::KEEP;
+      });
+
+  std::istringstream in("<r><!--c--><item a='1'>x</item><drop><item/><!--d--></drop><item>y<item/></item></r>");
+  std::ostringstream out;
+  pipeline.run(in, out);
+  assert(out.str() == "<r><entry a=\"v\">x</entry><entry>z<entry></entry></entry></r>");
+
+  const char* mismatched[] = { "<r><a></b></r>", "<r><a></a>", "</r>", "<r></r></r>" };
+  for (const char* xml : mismatched) {
+    std::istringstream bad(xml);
+    std::ostringstream discarded;
+    bool rejected = false;
+    try {
+      TransformPipeline().addStage(TransformPipeline::renameElements("a", "b")).run(bad, discarded);
+    }
+    catch (XMLException&) {
+      rejected = true;
+    }
+    assert(rejected);
+  }
+}
+
+/*Hashes computed while parsing and on first use agree, a clone keeps the hash of its original, an edit anywhere below the
+  root changes the root's hash until it is undone, and trees that differ only a little hash differently*/
+void testStructuralHash()
+{
+  const std::string xml = "<r a=\"1\"><b>text</b><c><d x=\"y\">deep</d></c><!--note--></r>";
+  Parser hashing;
+  hashing.setHashing(true);
+  std::istringstream in(xml);
+  std::unique_ptr<Document> doc = hashing.parse(in);
+  std::unique_ptr<Document> lazy = parseString(xml);
+  const uint64_t original = doc->getHash();
+  assert(original == lazy->getHash() && doc->equals(*lazy));
+
+  std::unique_ptr<Document> copy = doc->clone();
+  assert(copy->getHash() == original && copy->equals(*doc));
+
+  TextNode* deep = static_cast<TextNode*>(doc->getElementsByTagName("d")[0]->getChild(0));
+  deep->setText("changed");
+  assert(doc->getHash() != original && !doc->equals(*copy));
+  deep->setText("deep");
+  assert(doc->getHash() == original && doc->equals(*copy));
+
+  doc->getElementsByTagName("d")[0]->getAttribute("x")->setValue("z");
+  assert(doc->getHash() != original && !doc->equals(*copy));
+  doc->getElementsByTagName("d")[0]->getAttribute("x")->setValue("y");
+  assert(doc->getHash() == original);
+
+  doc->getRootElement()->addAttribute("extra", "1");
+  assert(doc->getHash() != original);
+  doc->getRootElement()->removeAttribute("extra");
+  assert(doc->getHash() == original);
+
+  /*the clone is unaffected by the edits of its original*/
+  assert(copy->getHash() == original);
+
+  const char* variants[] = { "<r a=\"1\"><c><d x=\"y\">deep</d></c><b>text</b><!--note--></r>",
+    "<r a=\"2\"><b>text</b><c><d x=\"y\">deep</d></c><!--note--></r>",
+    "<r a=\"1\"><b>text</b><c><d x=\"y\"><![CDATA[deep]]></d></c><!--note--></r>",
+    "<r a=\"1\"><b>text</b><c><d x=\"y\">deep</d></c><!--other--></r>",
+    "<r a=\"1\"><b>text</b><c><e x=\"y\">deep</e></c><!--note--></r>",
+    "<r a=\"1\"><b>text</b><c><d x=\"y\">deep</d></c></r>" };
+  for (const char* variant : variants) {
+    std::unique_ptr<Document> other = parseString(variant);
+    assert(other->getHash() != original && !other->equals(*copy));
+  }
+}
+
+/*A reader keeps the version it started with through an update and holds it back from being freed, and readers on other
+  threads always see a whole version while a writer keeps publishing*/
+void testDocumentPublisher()
+{
+  DocumentPublisher publisher(parseString("<r n=\"0\"></r>"), 8);
+  {
+    DocumentPublisher::Reader before = publisher.read();
+    publisher.update([](Document& doc) {
+	doc.getRootElement()->addChildNode(ElementNode::createElementNode("c"));
+	doc.getRootElement()->getAttribute("n")->setValue("1");
+      });
+    assert(before->getRootElement()->getChildCount() == 0);
+    assert(publisher.read()->getRootElement()->getChildCount() == 1);
+
+    publisher.reclaim();
+    assert(publisher.getRetiredCount() == 1);
+  }
+  publisher.reclaim();
+  assert(publisher.getRetiredCount() == 0);
+
+  /*every version has as many children as its n attribute says*/
+  std::atomic<bool> done(false);
+  std::atomic<int> torn(0);
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i) {
+    readers.push_back(std::thread([&]() {
+	  while (!done.load()) {
+	    DocumentPublisher::Reader version = publisher.read();
+	    const ElementNode* root = version->getRootElement();
+	    if (std::to_string(root->getChildCount()) != root->getAttribute("n")->getValue())
+	      ++torn;
+	  }
+	}));
+  }
+  for (int i = 2; i <= 200; ++i) {
+    publisher.update([i](Document& doc) {
+	doc.getRootElement()->addChildNode(ElementNode::createElementNode("c"));
+	doc.getRootElement()->getAttribute("n")->setValue(std::to_string(i));
+      });
+  }
+  done.store(true);
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+
+  assert(torn.load() == 0);
+  assert(publisher.read()->getRootElement()->getChildCount() == 200);
+  publisher.reclaim();
+  assert(publisher.getRetiredCount() == 0);
+}
+
+/*A document parsed in place reads its text and attribute values out of the caller's buffer, past a UTF-8 byte order
+  mark, and input that is not UTF-8 is refused*/
+void testParseFlatInPlace()
+{
+  std::string buffer = "\xEF\xBB\xBF<r a=\"abc\"><b>text</b><![CDATA[cd]]></r>";
+  Parser p;
+  std::unique_ptr<FlatDocument> flat = p.parseFlatInPlace(buffer.data(), buffer.size());
+  uint32_t root = flat->getRootElement();
+  uint32_t text = flat->getFirstChild(flat->getFirstChild(root));
+  uint32_t cdata = flat->getNextSibling(flat->getFirstChild(root));
+  assert(flat->getAttributeValue(root, 0) == "abc" && flat->getText(text) == "text" && flat->getText(cdata) == "cd");
+
+  /*the values change along with the memory they point into*/
+  buffer[buffer.find("abc")] = 'X';
+  buffer[buffer.find("text")] = 'T';
+  buffer[buffer.find("cd")] = 'C';
+  assert(flat->getAttributeValue(root, 0) == "Xbc" && flat->getText(text) == "Text" && flat->getText(cdata) == "Cd");
+  assert(flat->getName(root) == "r");
+
+  const std::string rejected[] = { encodeUtf16(u"<r a=\"abc\"/>", false), encodeUtf16(u"<r a=\"abc\"/>", true),
+    "<r a=\"\xFF\"/>" };
+  for (const std::string& input : rejected) {
+    bool thrown = false;
+    try {
+      p.parseFlatInPlace(input.data(), input.size());
+    }
+    catch (XMLException&) {
+      thrown = true;
+    }
+    assert(thrown);
+  }
+}
+
+/*A Parser that failed part way through a document, or was reset, parses the next one as if it were new: no namespace
+  bindings, open elements or line counts are carried over*/
+void testParserReuse()
+{
+  Parser p;
+  const std::string good = "<r xmlns:p=\"urn:p\"><p:a x=\"1\">text</p:a></r>";
+  std::ostringstream first;
+  {
+    std::istringstream in(good);
+    p.parse(in)->write(first);
+  }
+
+  std::istringstream broken("<r xmlns:p=\"urn:p\">\n<p:a>\n<b>");
+  Expected<Document> failed = p.tryParse(broken);
+  assert(!failed && failed.getError().code == UNCLOSED_ELEMENT);
+
+  /*the prefix bound by the failed document is not bound any more*/
+  std::istringstream unbound("<p:a/>");
+  Expected<Document> result = p.tryParse(unbound);
+  assert(!result && result.getError().code == UNBOUND_PREFIX && result.getError().line == 1);
+
+  bool thrown = false;
+  try {
+    p.parse(std::string("does-not-exist.xml"));
+  }
+  catch (XMLException&) {
+    thrown = true;
+  }
+  assert(thrown);
+  p.reset();
+
+  std::istringstream again(good), flat(good);
+  std::ostringstream second;
+  p.parse(again)->write(second);
+  assert(second.str() == first.str());
+  assert(p.parseFlat(flat)->getAttributeValue(1, 0) == "1");
+
+  std::istringstream mismatched("<r><a></b></r>");
+  assert(!p.tryParse(mismatched));
+  std::istringstream element(good);
+  assert(p.parseElement(element)->getChildCount() == 1);
+}
+
+/*Applying a diff, or its saved and reloaded copy, turns the old document into the new one*/
+void testTreeDiffRoundTrip()
+{
+  const char* pairs[][2] = {
+    /*reordered, inserted and deleted children, matched through the longest common subsequence*/
+    { "<r><a/><b>1</b><c/><d x=\"1\"/><e/></r>", "<r><b>1</b><c/><x/><a/><d x=\"2\" y=\"3\"/><e/></r>" },
+    { "<r>t<!--c--><![CDATA[d]]></r>", "<r>u<!--c--><![CDATA[e]]>v</r>" },
+    /*a root with another name is replaced as a whole*/
+    { "<!--top--><old a=\"1\"><x/></old>", "<!--top--><new><x/></new>" },
+    { "<r><a/></r>", "<r><a/></r>" }
+  };
+
+  for (auto& pair : pairs) {
+    std::unique_ptr<Document> from = parseString(pair[0]);
+    std::unique_ptr<Document> to = parseString(pair[1]);
+    TreeDiff diff = TreeDiff::diff(*from, *to);
+    assert(diff.empty() == (std::string(pair[0]) == pair[1]));
+
+    std::unique_ptr<Document> patched = from->clone();
+    diff.apply(*patched);
+    assert(patched->equals(*to));
+
+    std::stringstream saved;
+    diff.save(saved);
+    TreeDiff loaded = TreeDiff::load(saved);
+    assert(loaded.size() == diff.size());
+    loaded.apply(*from);
+    assert(from->equals(*to) && from->getRootElement()->getName() == to->getRootElement()->getName());
+  }
+}
+
+/*Appends the bytes of a value to a hand made edit script*/
+template <typename T>
+void putRaw(std::string& script, T value)
+{
+  script.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+/*Edit scripts with lengths past their end or subtrees nested too deep are rejected without allocating for them*/
+void testCorruptEditScript()
+{
+  std::string header("TXPPDIF1", 8);
+  putRaw<uint64_t>(header, 1);
+  header += (char)TreeDiff::INSERT_NODE;
+
+  std::string longPath = header;
+  putRaw<uint32_t>(longPath, 0x7fffffff);
+
+  std::string longString = header;
+  putRaw<uint32_t>(longString, 1);
+  putRaw<uint32_t>(longString, 0);
+  longString += (char)1;				//a text node
+  putRaw<uint32_t>(longString, 0xfffffff0);
+
+  auto nested = [&](int depth) {
+    std::string script = header;
+    putRaw<uint32_t>(script, 1);
+    putRaw<uint32_t>(script, 0);
+    for (int i = 0; i < depth; ++i) {
+      script += (char)0;			//an element named a, in no namespace, with one child
+      putRaw<uint32_t>(script, 1);
+      script += 'a';
+      putRaw<uint32_t>(script, 0);
+      putRaw<uint32_t>(script, 0);
+      putRaw<uint32_t>(script, 1);
+    }
+    script += (char)1;
+    putRaw<uint32_t>(script, 0);
+    return script;
+  };
+
+  for (const std::string& script : { longPath, longString, nested(2000000) }) {
+    std::istringstream in(script);
+    bool rejected = false;
+    try {
+      TreeDiff::load(in);
+    }
+    catch (XMLException& e) {
+      rejected = true;
+    }
+    assert(rejected);
+  }
+
+  std::istringstream in(nested(1000));
+  assert(TreeDiff::load(in).size() == 1);
+}
+
+/*tryParse reports the code and the position of the first error, the same from a stream or from memory*/
+void testErrorPositions()
+{
+  struct { const char* xml; ParseErrorCode code; std::streamoff offset; int line; int column; } cases[] = {
+    { "<a>\n  <b></c>\n</a>", MISMATCHED_TAG, 9, 2, 6 },
+    { "<a>\n<b>", UNCLOSED_ELEMENT, 7, 2, 4 },
+    { "<a>x & y</a>", INVALID_TEXT, 5, 1, 6 },
+    { "<a/><b/>", MULTIPLE_ROOTS, 4, 1, 5 },
+    { "<p:a/>", UNBOUND_PREFIX, 6, 1, 7 }
+  };
+
+  Parser p;
+  for (auto& c : cases) {
+    std::string xml = c.xml;
+    std::istringstream in(xml);
+    Expected<Document> fromStream = p.tryParse(in);
+    Expected<Document> fromMemory = p.tryParse(xml.data(), xml.size());
+    for (const ParseError& e : { fromStream.getError(), fromMemory.getError() }) {
+      assert(e.code == c.code && e.offset == c.offset && e.line == c.line && e.column == c.column);
+    }
+    assert(!fromStream && fromStream.release() == nullptr);
+  }
+
+  std::istringstream good("<a>\n  <b/>\n</a>");
+  Expected<Document> result = p.tryParse(good);
+  assert(result && result->getRootElement()->getName() == "a");
+
+  /*newlines in markup the flags step over are counted too*/
+  std::string skipped = "<a>\n<!-- x\ny -->\n<![CDATA[\n]]>\n <b></c></a>";
+  Parser skipping;
+  skipping.setFlags(PARSE_SKIP_COMMENTS | PARSE_SKIP_CDATA);
+  std::istringstream in(skipped);
+  ParseError e = skipping.tryParse(in).getError();
+  assert(e.code == MISMATCHED_TAG && e.offset == (std::streamoff)skipped.find("</c>") && e.line == 6 && e.column == 5);
+}
+
+/*Each ParseLimits bound fails with its own code, and input within the bounds still parses*/
+void testParseLimits()
+{
+  struct { const char* xml; ParseErrorCode code; } cases[] = {
+    { "<a x=\"1\" y=\"2\" z=\"3\"/>", ATTRIBUTE_LIMIT_EXCEEDED },
+    { "<abcdefghi/>", NAME_LIMIT_EXCEEDED },
+    { "<a>1234567890</a>", TEXT_LIMIT_EXCEEDED },
+    { "<a b=\"1234567890\"/>", TEXT_LIMIT_EXCEEDED },
+    { "<a><!--1234567890--></a>", TEXT_LIMIT_EXCEEDED },
+    { "<a><b><c><d/></c></b></a>", DEPTH_LIMIT_EXCEEDED },
+    { "<a><b/><b/><b/><b/><b/></a>", NODE_LIMIT_EXCEEDED }
+  };
+
+  ParseLimits limits;
+  limits.maxAttributes = 2;
+  limits.maxNameLength = 8;
+  limits.maxTextLength = 8;
+  limits.maxDepth = 3;
+  limits.maxNodes = 5;
+  Parser p;
+  p.setLimits(limits);
+
+  for (auto& c : cases) {
+    std::istringstream in(c.xml);
+    Expected<Document> result = p.tryParse(in);
+    assert(!result && result.getError().code == c.code);
+  }
+
+  std::istringstream within("<a x=\"1\" y=\"2\"><b>12345678</b><b/></a>");
+  assert(p.tryParse(within));
+}
+
+/*A tracked document keeps the untouched markup verbatim after edits and moves, and reads back as the edited tree*/
+void testIncrementalWrite()
+{
+  Parser p;
+  p.setSourceTracking(true);
+  std::istringstream in("<r>\n  <a  x = '1' >one</a>\n  <b>two</b>\n  <c><d/></c>\n</r>");
+  std::unique_ptr<Document> doc = p.parse(in);
+
+  std::ostringstream unchanged;
+  doc->write(unchanged);
+  assert(unchanged.str() == doc->getSource());
+
+  ElementNode* b = doc->getElementsByTagName("b")[0];
+  static_cast<TextNode*>(b->getChild(0))->setText("TWO");
+  doc->getElementsByTagName("d")[0]->addAttribute("y", "2");
+  std::ostringstream edited;
+  doc->write(edited);
+  assert(edited.str() == "<r>\n  <a  x = '1' >one</a>\n  <b>TWO</b>\n  <c><d y=\"2\"></d></c>\n</r>");
+
+  ElementNode* root = doc->getRootElement();
+  root->addChildNode(root->releaseChildNode(1));
+  std::ostringstream moved, full;
+  doc->write(moved);
+  doc->clone()->write(full);
+  assert(moved.str() == full.str());
+  assert(moved.str() == "<r>\n  \n  <b>TWO</b>\n  <c><d y=\"2\"></d></c>\n<a x=\"1\">one</a></r>");
+}
+
+/*Source tracking is refused together with flags that leave content out of the tree, whichever is set first*/
+void testSourceTrackingFlags()
+{
+  const unsigned dropping[] = { PARSE_SKIP_COMMENTS, PARSE_SKIP_CDATA, PARSE_TRIM_WHITESPACE, PARSE_NO_TEXT };
+  for (unsigned flags : dropping) {
+    Parser tracking;
+    tracking.setSourceTracking(true);
+    bool rejected = false;
+    try {
+      tracking.setFlags(flags);
+    }
+    catch (XMLException&) {
+      rejected = true;
+    }
+    assert(rejected);
+
+    Parser flagged;
+    flagged.setFlags(flags);
+    rejected = false;
+    try {
+      flagged.setSourceTracking(true);
+    }
+    catch (XMLException&) {
+      rejected = true;
+    }
+    assert(rejected);
+  }
+
+  Parser p;
+  p.setSourceTracking(true);
+  p.setFlags(PARSE_NO_VALIDATION);
+  std::istringstream in("<r> <!--c--> <a/> </r>");
+  std::unique_ptr<Document> doc = p.parse(in);
+  std::ostringstream out;
+  doc->write(out);
+  assert(out.str() == doc->getSource());
+}
+
+/*Prefixes resolve to their URIs, including redeclared and default ones, and unprefixed attributes take no namespace*/
+void testNamespaceResolution()
+{
+  std::unique_ptr<Document> doc = parseString(
+    "<r xmlns=\"urn:d\" xmlns:p=\"urn:p\"><p:a p:x=\"1\" y=\"2\"/>"
+    "<b xmlns:p=\"urn:q\"><p:a/></b><c xmlns=\"\"/></r>");
+
+  ElementNode* root = doc->getRootElement();
+  assert(root->getNamespaceURI() == "urn:d" && root->getLocalName() == "r");
+
+  std::vector<ElementNode*> outer = doc->getElementsByTagNameNS("urn:p", "a");
+  assert(outer.size() == 1 && outer[0]->getName() == "p:a");
+  assert(outer[0]->getAttributeNS("urn:p", "x") != nullptr && outer[0]->getAttributeNS("urn:p", "x")->getValue() == "1");
+  assert(outer[0]->getAttribute("y")->getNamespaceURI().empty());
+  assert(outer[0]->hasName(NamespaceTable::find("urn:p"), "a"));
+
+  assert(doc->getElementsByTagNameNS("urn:q", "a").size() == 1);
+  assert(doc->getElementsByTagNameNS("urn:d", "b").size() == 1);
+  assert(doc->getElementsByTagName("c")[0]->getNamespaceURI().empty());
+
+  Parser p;
+  std::istringstream unbound("<r><q:a/></r>");
+  Expected<Document> result = p.tryParse(unbound);
+  assert(!result && result.getError().code == UNBOUND_PREFIX);
+}
+
+/*A saved snapshot loads back as an equal document, namespaces included*/
+void testSnapshotRoundTrip()
+{
+  std::unique_ptr<Document> doc = parseString(
+    "<!--head--><r xmlns:p=\"urn:p\" a=\"1\"><p:e p:b=\"2\">text</p:e><![CDATA[<raw>]]><empty/></r>");
+  doc->saveSnapshot("test.snap");
+  std::unique_ptr<Document> loaded = Document::loadSnapshot("test.snap");
+
+  assert(loaded->equals(*doc));
+  assert(loaded->getElementsByTagNameNS("urn:p", "e").size() == 1);
+  assert(loaded->getElementsByTagNameNS("urn:p", "e")[0]->getAttributeNS("urn:p", "b")->getValue() == "2");
+
+  std::ostringstream original, reloaded;
+  doc->write(original);
+  loaded->write(reloaded);
+  assert(original.str() == reloaded.str());
+}
+
+/*Writes a snapshot by hand: a document record over a chain of depth nested elements named a, with its tables laid out
+  from nodesOffset on*/
+void writeNestedSnapshot(const std::string& path, uint32_t depth, uint64_t nodesOffset)
+{
+  std::vector<Snapshot::NodeRecord> nodes(depth + 1, Snapshot::NodeRecord());
+  for (uint32_t i = 0; i <= depth; ++i) {
+    nodes[i].type = i == 0 ? Snapshot::DOCUMENT_RECORD : Snapshot::ELEMENT_RECORD;
+    nodes[i].childCount = i < depth ? 1 : 0;
+    nodes[i].length = 1;			//the empty name, no namespace
+  }
+  Snapshot::NameRecord names[2] = { { 0, 1 }, { 1, 0 } };
+
+  Snapshot::Header header;
+  memcpy(header.magic, "TXPPSNAP", 8);
+  header.version = 2;
+  header.nodeCount = nodes.size();
+  header.attributeCount = 0;
+  header.nameCount = 2;
+  header.heapSize = 1;
+  header.nodesOffset = nodesOffset;
+  header.attributesOffset = header.namesOffset = nodesOffset + nodes.size() * sizeof(Snapshot::NodeRecord);
+  header.heapOffset = header.namesOffset + sizeof(names);
+
+  std::ofstream file(path.c_str(), std::ios::binary);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  for (uint64_t i = sizeof(header); i < nodesOffset; ++i)
+    file.put(0);
+  file.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(Snapshot::NodeRecord));
+  file.write(reinterpret_cast<const char*>(names), sizeof(names));
+  file.put('a');
+}
+
+/*Snapshots nested too deep or with misaligned tables are rejected rather than crashing the loader*/
+void testCorruptSnapshot()
+{
+  writeNestedSnapshot("test.snap", 10, sizeof(Snapshot::Header));
+  std::unique_ptr<Document> doc = Document::loadSnapshot("test.snap");
+  assert(doc->getElementsByTagName("a").size() == 10);
+
+  struct { uint32_t depth; uint64_t nodesOffset; } cases[] = {
+    { 200000, sizeof(Snapshot::Header) },
+    { 10, sizeof(Snapshot::Header) + 1 }
+  };
+  for (auto& c : cases) {
+    writeNestedSnapshot("test.snap", c.depth, c.nodesOffset);
+    bool rejected = false;
+    try {
+      Document::loadSnapshot("test.snap");
+    }
+    catch (XMLException& e) {
+      rejected = true;
+    }
+    assert(rejected);
+  }
+}
+
+/*Queries do not add to the namespace table, URIs leave it with the last node using them, and no document can fill it
+  for the others*/
+void testNamespaceTableBound()
+{
+  std::istringstream small("<r xmlns=\"urn:a\"><e/></r>");
+  Parser p;
+  std::unique_ptr<Document> doc = p.parse(small);
+  assert(doc->getElementsByTagNameNS("urn:a", "e").size() == 1);
+  assert(doc->getElementsByTagNameNS("urn:never-declared", "e").empty());
+  assert(NamespaceTable::find("urn:never-declared") == NamespaceTable::INVALID_NAMESPACE);
+
+  std::istringstream gone("<r xmlns:g=\"urn:gone\"><g:e/></r>");
+  std::unique_ptr<Document> dropped = p.parse(gone);
+  dropped->getElementsByTagName("g:e")[0]->setNamespaceId(NamespaceTable::NO_NAMESPACE);
+  dropped.reset();
+  std::istringstream next("<r/>");
+  p.parse(next);
+  assert(NamespaceTable::find("urn:gone") == NamespaceTable::INVALID_NAMESPACE);
+
+  std::string xml = "<r>";
+  for (uint32_t i = 0; i < NamespaceTable::MAX_NAMESPACES; ++i)
+    xml += "<e xmlns:p=\"urn:bound:" + std::to_string(i) + "\"/>";
+  xml += "</r>";
+  std::istringstream in(xml);
+  Expected<Document> result = p.tryParse(in);
+  assert(!result && result.getError().code == NAMESPACE_LIMIT_EXCEEDED);
+
+  ParseLimits limits;
+  limits.maxNamespaces = ParseLimits::UNLIMITED;
+  Parser unlimited;
+  unlimited.setLimits(limits);
+  std::istringstream full(xml);
+  result = unlimited.tryParse(full);
+  assert(!result && result.getError().code == NAMESPACE_LIMIT_EXCEEDED);
+
+  /*the URIs of the rejected documents are gone, so new ones still fit*/
+  std::istringstream again("<r xmlns=\"urn:a\"><e xmlns=\"urn:new\"/></r>");
+  assert(p.tryParse(again));
+  assert(NamespaceTable::find("urn:bound:0") == NamespaceTable::INVALID_NAMESPACE);
+}
+
 int main(int argc, char** argv)
 {	   
+  testBatchCallbackException();
+  testCorruptIndex();
+  testMoveBetweenTrackedDocuments();
+  testFrozenTreeIsConst();
+  testCompressionRoundTrip();
+  testXMLWriter();
+  testTransformPipeline();
+  testBindingConversions();
+  testBindingRead();
+  testByteOrderMarks();
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+  testAsyncSelfClosingEndTag();
+#endif
+  testSameErrorsEverywhere();
+  testRecordReaderEndTags();
+  testPipelinedSettings();
+  testPreScanFollowsFlags();
+  testSkipElement();
+  testStructuralHash();
+  testDocumentPublisher();
+  testParseFlatInPlace();
+  testParserReuse();
+  testTreeDiffRoundTrip();
+  testCorruptEditScript();
+  testErrorPositions();
+  testParseLimits();
+  testIncrementalWrite();
+  testSourceTrackingFlags();
+  testNamespaceResolution();
+  testSnapshotRoundTrip();
+  testCorruptSnapshot();
+  testNamespaceTableBound();
+
   /*
      std::ifstream f("t.xml");
      XMLTokenizer xt(f);
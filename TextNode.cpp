@@ -1,6 +1,13 @@
 #include "TextNode.h"
+#include "Hash.h"
 
 namespace tinyXMLpp {
+
+  namespace {
+    /*"TEXT", keeps the hashes of different node types apart*/
+    const uint64_t HASH_SEED = 0x54455854;
+  }
+
   /**
    * Constructor which takes as input the text for the TextNode
    *
@@ -8,7 +15,7 @@ namespace tinyXMLpp {
    */
   TextNode::TextNode(std::string text) 
   {	
-    this->text = text;
+    this->text = std::move(text);
   }
 
   /**
@@ -29,6 +36,28 @@ namespace tinyXMLpp {
     return new TextNode(text);
   }
 
+  /**
+   * Function to create a TextNode, taking over the buffer of the text instead of copying it.
+   *
+   *@param text The input text used for creating a TextNode
+   *@return An object of type TextNode*
+   */
+  TextNode* TextNode::createTextNode(std::string&& text)
+  {
+    return new TextNode(std::move(text));
+  }
+
+  /**
+   * Function to create a TextNode owned by a unique_ptr, to be handed to Node::addChildNode.
+   *
+   *@param text The input text used for creating a TextNode
+   *@return A unique_ptr to the new TextNode
+   */
+  std::unique_ptr<TextNode> TextNode::makeTextNode(std::string text)
+  {
+    return std::unique_ptr<TextNode>(new TextNode(std::move(text)));
+  }
+
   /**
    *Overrided function from Node.h. Overrided to make it throw an exception if used. Cannot add child node to a TextNode.
    *
@@ -55,11 +84,22 @@ namespace tinyXMLpp {
    *
    *@return A string which contains the text within the TextNode
    */
-  std::string TextNode::getText() const
+  const std::string& TextNode::getText() const
   {
     return this->text;
   }
 
+  /**
+   * Function which replaces the text of the TextNode.
+   *
+   *@param text The new text.
+   */
+  void TextNode::setText(std::string text)
+  {
+    this->text = std::move(text);
+    markDirty();
+  }
+
   /**
    *Overrided function from Node.h. Overrided to make it throw an exception if used. Cannot remove child node from TextNode
    *as it does not have any children.
@@ -89,6 +129,38 @@ namespace tinyXMLpp {
    */
   void TextNode::write(std::ostream& os) const
   {
-    os << this->getText();
+    os << this->text;
+  }
+
+  /**
+   *Function to compute the hash of the TextNode, which depends only on its text.
+   *
+   *@return The hash of the text.
+   */
+  uint64_t TextNode::computeHash() const
+  {
+    return hashString(this->text, HASH_SEED);
+  }
+
+  /**
+   *Function to compare the text of two nodes.
+   *
+   *@param other The node to compare with.
+   *@return true if other is a TextNode with the same text.
+   */
+  bool TextNode::hasSameContent(const Node& other) const
+  {
+    const TextNode* node = dynamic_cast<const TextNode*>(&other);
+    return node != nullptr && node->text == this->text;
+  }
+
+  /**
+   *Function to copy the node, for Node::clone.
+   *
+   *@return A new TextNode with the same text.
+   */
+  Node* TextNode::cloneContent() const
+  {
+    return createTextNode(this->text);
   }
 }
@@ -14,18 +14,27 @@ namespace tinyXMLpp{
     ~TextNode();
 
     static TextNode* createTextNode(const std::string& text);
+    static TextNode* createTextNode(std::string&& text);
+    static std::unique_ptr<TextNode> makeTextNode(std::string text);
 
     void addChildNode (Node* child);
 
     void addChildNode (Node* child, int index) ;
 
-    std::string getText() const;
+    const std::string& getText() const;
+
+    void setText(std::string text);
 
     void removeChildNode (Node* child);
 
     void removeChildNode (int index);
 
     void write(std::ostream& os) const;
+
+    protected:
+    uint64_t computeHash() const;
+    bool hasSameContent(const Node& other) const;
+    Node* cloneContent() const;
   };
 
 }
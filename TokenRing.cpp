@@ -0,0 +1,222 @@
+#include "TokenRing.h"
+#include "XMLException.h"
+
+namespace tinyXMLpp {
+
+  namespace {
+    /*A batch is handed over once it holds this many tokens or bytes*/
+    const size_t BATCH_TOKENS = 256;
+    const size_t BATCH_BYTES = 64 * 1024;
+
+    /*Times a waiting side checks again before it goes to sleep*/
+    const int SPIN_LIMIT = 1024;
+  }
+
+  /**
+   * Function which empties the batch, keeping the memory of its lists.
+   */
+  void TokenRing::Batch::clear()
+  {
+    tokens.clear();
+    attributes.clear();
+    bytes.clear();
+    error = nullptr;
+  }
+
+  /**
+   * Function which appends a string to the bytes of the batch.
+   *
+   *@param str The string.
+   *@return The offset of the string in the bytes.
+   */
+  uint32_t TokenRing::Batch::addBytes(const std::string& str)
+  {
+    if (str.size() > UINT32_MAX - bytes.size())
+      throw XMLException("Token too large to be passed between threads: it exceeds 4 GB");
+    uint32_t offset = bytes.size();
+    bytes.append(str);
+    return offset;
+  }
+
+  /**
+   * Function which copies the token the tokenizer just returned into the batch. Its strings are appended to the bytes of
+   * the batch and the record keeps where they are.
+   *
+   *@param type The type of the token.
+   *@param t The tokenizer holding the values of the token.
+   *@return false once the batch holds enough to be handed over.
+   */
+  bool TokenRing::Batch::add(TokenType type, const XMLTokenizer& t)
+  {
+    TokenRecord record;
+    record.type = type;
+    record.value = record.valueLength = 0;
+    record.firstAttribute = attributes.size();
+    record.attrCount = 0;
+    record.namespaceId = 0;
+    record.start = t.getTokenOffset();
+    record.end = t.getOffset();
+
+    const std::string* value = nullptr;
+
+    switch (type) {
+      case START_TAG:
+	record.namespaceId = t.getNamespaceId();
+	record.attrCount = t.getAttributeCount();
+	for (int i = 0; i < t.getAttributeCount(); ++i) {
+	  AttributeRecord attr;
+	  attr.nameLength = t.getAttributeName(i).size();
+	  attr.name = addBytes(t.getAttributeName(i));
+	  attr.valueLength = t.getAttributeValue(i).size();
+	  attr.value = addBytes(t.getAttributeValue(i));
+	  attr.namespaceId = t.getAttributeNamespaceId(i);
+	  attributes.push_back(attr);
+	}
+	value = &t.getTagName();
+	break;
+      case END_TAG:
+	value = &t.getTagName();
+	break;
+      case TEXT:
+	value = &t.getText();
+	break;
+      case CDATA:
+	value = &t.getCDATA();
+	break;
+      case COMMENT:
+	value = &t.getComment();
+	break;
+      default:
+	break;
+    }
+
+    if (value != nullptr) {
+      record.valueLength = value->size();
+      record.value = addBytes(*value);
+    }
+    tokens.push_back(record);
+    return tokens.size() < BATCH_TOKENS && bytes.size() < BATCH_BYTES;
+  }
+
+  /**
+   * Constructor
+   *
+   *@param capacity The number of batches, rounded up to a power of two.
+   */
+  TokenRing::TokenRing(size_t capacity) : head(0), tail(0), cancelled(false)
+  {
+#if !defined(__cpp_lib_atomic_wait)
+    sleepers.store(0);
+#endif
+    size_t size = 2;
+    while (size < capacity)
+      size *= 2;
+    slots.resize(size);
+    mask = size - 1;
+  }
+
+  /**
+   * Function which waits until the other side changes a counter. It checks again for a while first, as the other side is
+   * usually about to; then it sleeps until woken by publish.
+   *
+   *@param counter head or tail.
+   *@param value The value to wait out.
+   */
+  void TokenRing::waitWhile(const std::atomic<size_t>& counter, size_t value)
+  {
+    for (int spins = 0; spins < SPIN_LIMIT; ++spins) {
+      if (counter.load(std::memory_order_acquire) != value)
+	return;
+    }
+
+#if defined(__cpp_lib_atomic_wait)
+    counter.wait(value, std::memory_order_acquire);
+#else
+    std::unique_lock<std::mutex> lock(sleepLock);
+    sleepers.fetch_add(1);
+    wakeUp.wait(lock, [&]() { return counter.load() != value; });
+    sleepers.fetch_sub(1);
+#endif
+  }
+
+  /**
+   * Function which stores a new value of a counter and wakes the other side if it went to sleep waiting for it.
+   *
+   *@param counter head or tail.
+   *@param value The new value.
+   */
+  void TokenRing::publish(std::atomic<size_t>& counter, size_t value)
+  {
+#if defined(__cpp_lib_atomic_wait)
+    counter.store(value, std::memory_order_release);
+    counter.notify_one();
+#else
+    /*the store and the check of sleepers are ordered against the sleeper's, so one of the two sees the other*/
+    counter.store(value);
+    if (sleepers.load() > 0) {
+      std::lock_guard<std::mutex> lock(sleepLock);
+      wakeUp.notify_all();
+    }
+#endif
+  }
+
+  /**
+   * Function which waits until a batch is free and returns it for the producer to fill.
+   *
+   *@return The batch, or nullptr if the consumer cancelled.
+   */
+  TokenRing::Batch* TokenRing::beginWrite()
+  {
+    size_t t = tail.load(std::memory_order_relaxed);
+    while (true) {
+      if (cancelled.load(std::memory_order_acquire))
+	return nullptr;
+      size_t h = head.load(std::memory_order_acquire);
+      if (t - h < slots.size())
+	break;
+      waitWhile(head, h);
+    }
+    return &slots[t & mask];
+  }
+
+  /**
+   * Function which publishes the batch returned by beginWrite to the consumer.
+   */
+  void TokenRing::endWrite()
+  {
+    publish(tail, tail.load(std::memory_order_relaxed) + 1);
+  }
+
+  /**
+   * Function which waits until a batch is available and returns it.
+   *
+   *@return The oldest batch not read yet.
+   */
+  TokenRing::Batch* TokenRing::beginRead()
+  {
+    size_t h = head.load(std::memory_order_relaxed);
+    while (tail.load(std::memory_order_acquire) == h) {
+      waitWhile(tail, h);
+    }
+    return &slots[h & mask];
+  }
+
+  /**
+   * Function which hands the batch returned by beginRead back to the producer.
+   */
+  void TokenRing::endRead()
+  {
+    publish(head, head.load(std::memory_order_relaxed) + 1);
+  }
+
+  /**
+   * Function which tells the producer that no more batches will be read. head is moved on as well, which wakes the
+   * producer if it sleeps waiting for a free batch.
+   */
+  void TokenRing::cancel()
+  {
+    cancelled.store(true, std::memory_order_release);
+    publish(head, head.load(std::memory_order_relaxed) + 1);
+  }
+
+}
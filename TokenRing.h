@@ -0,0 +1,101 @@
+#ifndef __TOKENRING_H__
+#define __TOKENRING_H__
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <exception>
+#include <cstdint>
+#include "XMLTokenizer.h"
+
+#if !defined(__cpp_lib_atomic_wait)
+#include <mutex>
+#include <condition_variable>
+#endif
+
+namespace tinyXMLpp {
+
+  /*Lock-free queue of tokens between one thread running a tokenizer
+    and one thread consuming the tokens. Tokens are passed on in
+    batches, which are allocated once and reused, so passing tokens on
+    does not allocate once the ring is warm and the two threads only
+    meet once per batch. Each side spins briefly when it has to wait,
+    then sleeps until the other side wakes it.*/
+  class TokenRing {
+
+    public:
+    /*A token, with its strings kept as offsets into the bytes of its batch*/
+    struct TokenRecord {
+      TokenType type;
+      uint32_t value, valueLength;		//tag name, or content of text, CDATA or comment
+      uint32_t firstAttribute, attrCount;	//in the attributes of the batch
+      uint32_t namespaceId;			//of the start tag
+      std::streamoff start, end;		//source offsets of the token
+    };
+
+    struct AttributeRecord {
+      uint32_t name, nameLength;
+      uint32_t value, valueLength;
+      uint32_t namespaceId;
+    };
+
+    /*Tokens handed over together*/
+    class Batch {
+
+      uint32_t addBytes(const std::string& str);
+
+      public:
+      std::vector<TokenRecord> tokens;
+      std::vector<AttributeRecord> attributes;
+      std::string bytes;
+      std::exception_ptr error;			//set when the tokenizer failed after the tokens
+
+      void clear();
+
+      /*Copies the token the tokenizer just returned. Returns false
+	once the batch is full enough to be handed over.*/
+      bool add(TokenType type, const XMLTokenizer& t);
+
+      const char* data(uint32_t offset) const { return bytes.data() + offset; }
+    };
+
+    private:
+    std::vector<Batch> slots;
+    size_t mask;
+
+    /*head and tail sit on their own cache lines, since each one is
+      written by a different thread*/
+    alignas(64) std::atomic<size_t> head;	//next slot to read
+    alignas(64) std::atomic<size_t> tail;	//next slot to write
+    alignas(64) std::atomic<bool> cancelled;
+
+#if !defined(__cpp_lib_atomic_wait)
+    std::mutex sleepLock;
+    std::condition_variable wakeUp;
+    std::atomic<int> sleepers;
+#endif
+
+    void waitWhile(const std::atomic<size_t>& counter, size_t value);
+    void publish(std::atomic<size_t>& counter, size_t value);
+
+    public:
+    /*The capacity is rounded up to a power of two*/
+    TokenRing(size_t capacity = 8);
+
+    /*Producer side: waits for a free batch, which is published by
+      endWrite. Returns nullptr if the consumer gave up.*/
+    Batch* beginWrite();
+    void endWrite();
+
+    /*Consumer side: waits for the next batch, which is handed back
+      by endRead*/
+    Batch* beginRead();
+    void endRead();
+
+    /*Called by the consumer when it stops early, to release the producer*/
+    void cancel();
+  };
+
+}
+
+#endif
@@ -0,0 +1,320 @@
+#include "TransformPipeline.h"
+#include "XMLWriter.h"
+#include "XMLException.h"
+
+namespace tinyXMLpp {
+
+  /**
+   * Function which points the view at the token the tokenizer just returned. Nothing is copied.
+   *
+   *@param type The type of the token.
+   *@param t The tokenizer holding the values of the token.
+   */
+  void TokenView::reset(TokenType type, const XMLTokenizer& t)
+  {
+    this->type = type;
+    storage.clear();
+    attrNames.clear();
+    attrValues.clear();
+    name = text = nullptr;
+
+    switch (type) {
+      case START_TAG:
+	name = &t.getTagName();
+	for (int i = 0; i < t.getAttributeCount(); ++i) {
+	  attrNames.push_back(&t.getAttributeName(i));
+	  attrValues.push_back(&t.getAttributeValue(i));
+	}
+	break;
+      case TEXT:
+	text = &t.getText();
+	break;
+      case CDATA:
+	text = &t.getCDATA();
+	break;
+      case COMMENT:
+	text = &t.getComment();
+	break;
+      default:
+	break;
+    }
+  }
+
+  /**
+   * Function which keeps a copy of a value set by a stage, for as long as the view refers to the current token.
+   *
+   *@param value The value.
+   *@return A pointer to the copy.
+   */
+  const std::string* TokenView::store(const std::string& value)
+  {
+    storage.push_back(value);
+    return &storage.back();
+  }
+
+  /**
+   * Function which returns the type of the token.
+   *
+   *@return START_TAG, TEXT, CDATA or COMMENT.
+   */
+  TokenType TokenView::getType() const
+  {
+    return type;
+  }
+
+  /**
+   * Function which returns the name of a start tag.
+   *
+   *@return The name of the element.
+   */
+  const std::string& TokenView::getName() const
+  {
+    if (name == nullptr)
+      throw XMLException("Only start tags have a name");
+    return *name;
+  }
+
+  /**
+   * Function which renames the element of a start tag.
+   *
+   *@param name The new name.
+   */
+  void TokenView::setName(const std::string& name)
+  {
+    if (this->name == nullptr)
+      throw XMLException("Only start tags have a name");
+    this->name = store(name);
+  }
+
+  /**
+   * Function which returns the content of a text, CDATA or comment token.
+   *
+   *@return The content.
+   */
+  const std::string& TokenView::getText() const
+  {
+    if (text == nullptr)
+      throw XMLException("Start tags do not have text");
+    return *text;
+  }
+
+  /**
+   * Function which replaces the content of a text, CDATA or comment token.
+   *
+   *@param text The new content.
+   */
+  void TokenView::setText(const std::string& text)
+  {
+    if (this->text == nullptr)
+      throw XMLException("Start tags do not have text");
+    this->text = store(text);
+  }
+
+  /**
+   * Function which returns the number of attributes of a start tag.
+   *
+   *@return The number of attributes.
+   */
+  int TokenView::getAttributeCount() const
+  {
+    return attrNames.size();
+  }
+
+  /**
+   * Function which returns the name of an attribute.
+   *
+   *@param idx The index of the attribute.
+   *@return The name of the attribute.
+   */
+  const std::string& TokenView::getAttributeName(int idx) const
+  {
+    if (idx < 0 || idx >= (int)attrNames.size())
+      throw XMLException("Attribute index out of range");
+    return *attrNames[idx];
+  }
+
+  /**
+   * Function which returns the value of an attribute.
+   *
+   *@param idx The index of the attribute.
+   *@return The value of the attribute.
+   */
+  const std::string& TokenView::getAttributeValue(int idx) const
+  {
+    if (idx < 0 || idx >= (int)attrValues.size())
+      throw XMLException("Attribute index out of range");
+    return *attrValues[idx];
+  }
+
+  /**
+   * Function which replaces the value of an attribute.
+   *
+   *@param idx The index of the attribute.
+   *@param value The new value.
+   */
+  void TokenView::setAttributeValue(int idx, const std::string& value)
+  {
+    if (idx < 0 || idx >= (int)attrValues.size())
+      throw XMLException("Attribute index out of range");
+    attrValues[idx] = store(value);
+  }
+
+  /**
+   * Function which adds an attribute to a start tag.
+   *
+   *@param name The name of the attribute.
+   *@param value The value of the attribute.
+   */
+  void TokenView::addAttribute(const std::string& name, const std::string& value)
+  {
+    if (this->name == nullptr)
+      throw XMLException("Only start tags have attributes");
+    attrNames.push_back(store(name));
+    attrValues.push_back(store(value));
+  }
+
+  /**
+   * Function which removes an attribute from a start tag.
+   *
+   *@param idx The index of the attribute.
+   */
+  void TokenView::removeAttribute(int idx)
+  {
+    if (idx < 0 || idx >= (int)attrNames.size())
+      throw XMLException("Attribute index out of range");
+    attrNames.erase(attrNames.begin() + idx);
+    attrValues.erase(attrValues.begin() + idx);
+  }
+
+  /**
+   * Function which adds a stage at the end of the pipeline.
+   *
+   *@param stage Function called with each token, returning KEEP or DROP.
+   *@return The pipeline, so calls can be chained.
+   */
+  TransformPipeline& TransformPipeline::addStage(const Stage& stage)
+  {
+    stages.push_back(stage);
+    return *this;
+  }
+
+  /**
+   * Function which runs the input through the stages and writes the tokens that are kept to the output. Only the token
+   * being handled and the names of the open elements are held in memory.
+   *
+   *@param is The input stream holding the XML.
+   *@param os The output stream to which the result is written.
+   */
+  void TransformPipeline::run(std::istream& is, std::ostream& os)
+  {
+    DecodedInput input(is);
+    XMLTokenizer t(input.get());
+    XMLWriter writer(os);
+    TokenView view;
+
+    /*names of the open elements, as read and as written. The slots are
+      reused, so only the deepest level ever reached allocates.*/
+    std::vector<std::string> readNames, writtenNames;
+    size_t depth = 0;
+    TokenType type;
+
+    while ((type = t.getToken()) != ENDOFFILE) {
+
+      if (type == BOF)
+	continue;
+
+      if (type == END_TAG) {
+	if (depth == 0 || readNames[depth - 1] != t.getTagName())
+	  throw XMLException("Mismatched Tags! Error.. ");
+	--depth;
+	writer.endElement(writtenNames[depth]);
+	continue;
+      }
+
+      view.reset(type, t);
+      Action action = KEEP;
+      for (size_t i = 0; i < stages.size() && action == KEEP; ++i) {
+	action = stages[i](view);
+      }
+
+      if (action == DROP) {
+	if (type == START_TAG)
+	  t.skipElement();
+	continue;
+      }
+
+      switch (type) {
+	case START_TAG:
+	  writer.startElement(view.getName());
+	  for (int i = 0; i < view.getAttributeCount(); ++i) {
+	    writer.addAttribute(view.getAttributeName(i), view.getAttributeValue(i));
+	  }
+	  if (readNames.size() == depth) {
+	    readNames.resize(depth + 1);
+	    writtenNames.resize(depth + 1);
+	  }
+	  readNames[depth] = t.getTagName();
+	  writtenNames[depth] = view.getName();
+	  ++depth;
+	  break;
+	case TEXT:
+	  writer.addText(view.getText());
+	  break;
+	case CDATA:
+	  writer.addCDATA(view.getText());
+	  break;
+	case COMMENT:
+	  writer.addComment(view.getText());
+	  break;
+	default:
+	  break;
+      }
+    }
+
+    if (depth != 0)
+      throw XMLException("Mismatched tags");
+    writer.flush();
+  }
+
+  /**
+   * Function which makes a stage that renames every element with the given name.
+   *
+   *@param from The name of the elements to be renamed.
+   *@param to The new name.
+   *@return The stage.
+   */
+  TransformPipeline::Stage TransformPipeline::renameElements(const std::string& from, const std::string& to)
+  {
+    return [from, to](TokenView& token) {
+      if (token.getType() == START_TAG && token.getName() == from)
+	token.setName(to);
+      return KEEP;
+    };
+  }
+
+  /**
+   * Function which makes a stage that drops every element with the given name, along with its content.
+   *
+   *@param name The name of the elements to be dropped.
+   *@return The stage.
+   */
+  TransformPipeline::Stage TransformPipeline::dropElements(const std::string& name)
+  {
+    return [name](TokenView& token) {
+      return token.getType() == START_TAG && token.getName() == name ? DROP : KEEP;
+    };
+  }
+
+  /**
+   * Function which makes a stage that drops every comment.
+   *
+   *@return The stage.
+   */
+  TransformPipeline::Stage TransformPipeline::dropComments()
+  {
+    return [](TokenView& token) {
+      return token.getType() == COMMENT ? DROP : KEEP;
+    };
+  }
+
+}
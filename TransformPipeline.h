@@ -0,0 +1,86 @@
+#ifndef __TRANSFORMPIPELINE_H__
+#define __TRANSFORMPIPELINE_H__
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include "XMLTokenizer.h"
+
+namespace tinyXMLpp {
+
+  /*A token on its way through a TransformPipeline. It refers to the
+    values held by the tokenizer, and only keeps its own copy of what a
+    stage replaces.*/
+  class TokenView {
+
+    TokenType type;
+    const std::string* name;
+    const std::string* text;
+    std::vector<const std::string*> attrNames;
+    std::vector<const std::string*> attrValues;
+    std::deque<std::string> storage;		//values set by the stages
+
+    const std::string* store(const std::string& value);
+
+    friend class TransformPipeline;
+    void reset(TokenType type, const XMLTokenizer& t);
+
+    public:
+    TokenView() : type(BOF), name(nullptr), text(nullptr) {}
+
+    /*START_TAG, TEXT, CDATA or COMMENT*/
+    TokenType getType() const;
+
+    /*Name of a start tag. Renaming it renames the end tag as well.*/
+    const std::string& getName() const;
+    void setName(const std::string& name);
+
+    /*Content of text, CDATA and comments*/
+    const std::string& getText() const;
+    void setText(const std::string& text);
+
+    int getAttributeCount() const;
+    const std::string& getAttributeName(int idx) const;
+    const std::string& getAttributeValue(int idx) const;
+    void setAttributeValue(int idx, const std::string& value);
+    void addAttribute(const std::string& name, const std::string& value);
+    void removeAttribute(int idx);
+  };
+
+  /*Rewrites XML from an input stream to an output stream in constant
+    memory. Every token passes through the stages in the order they
+    were added; each stage may change the token or drop it. Dropping a
+    start tag drops the whole element, which is skipped unread. End
+    tags follow their start tags and are not passed to the stages.
+
+      TransformPipeline pipeline;
+      pipeline.addStage(TransformPipeline::dropComments())
+	      .addStage(TransformPipeline::renameElements("item", "entry"));
+      pipeline.run(in, out);*/
+  class TransformPipeline {
+
+    public:
+    enum Action { KEEP, DROP };
+    typedef std::function<Action(TokenView&)> Stage;
+
+    private:
+    std::vector<Stage> stages;
+
+    public:
+    TransformPipeline& addStage(const Stage& stage);
+
+    /*Runs the input through the stages, writing what is kept*/
+    void run(std::istream& is, std::ostream& os);
+
+    /*Common stages*/
+    static Stage renameElements(const std::string& from, const std::string& to);
+    static Stage dropElements(const std::string& name);
+    static Stage dropComments();
+  };
+
+}
+
+#endif
@@ -0,0 +1,577 @@
+#include "TreeBuilder.h"
+#include "Document.h"
+#include "FlatDocument.h"
+#include "ElementNode.h"
+#include "TextNode.h"
+#include "CDATANode.h"
+#include "CommentNode.h"
+#include "Attribute.h"
+#include "XMLException.h"
+
+namespace tinyXMLpp {
+
+  /**
+   * Constructor
+   *
+   *@param withSpans Whether the nodes should record the span of the input they were read from.
+   *@param withHashes Whether the hash of each element should be computed as soon as it is complete.
+   */
+  NodeSink::NodeSink(bool withSpans, bool withHashes)
+    : current(nullptr), withSpans(withSpans), withHashes(withHashes), sizes(nullptr), elementCount(0)
+  {
+  }
+
+  /**
+   * Function which gives the sink the counts of children and attributes of every element, so each element's lists are
+   * allocated once, at their final size. Counts that turn out wrong only cost memory or a reallocation.
+   *
+   *@param sizes The scan of the input the tokens come from, or nullptr to grow the lists as they are filled.
+   */
+  void NodeSink::setSizes(const StructureScan* sizes)
+  {
+    this->sizes = sizes;
+  }
+
+  /**
+   * Function which adds a complete node to the innermost open element, or to the top level. The node is freed if it
+   * cannot be added.
+   *
+   *@param node The node to be added.
+   */
+  void NodeSink::addNode(Node* node)
+  {
+    try {
+      if (current != nullptr)
+	current->addChildNode(node);
+      else
+	addTopLevel(node);
+    }
+    catch (...) {
+      delete node;
+      throw;
+    }
+  }
+
+  /**
+   * Function which opens a new element inside the innermost open one.
+   *
+   *@param name The name of the element.
+   *@param namespaceId The namespace the element is in.
+   */
+  void NodeSink::startElement(const std::string& name, uint32_t namespaceId)
+  {
+    ElementNode* elem = ElementNode::createElementNode(name);
+    elem->setNamespaceId(namespaceId);
+    if (sizes != nullptr && elementCount < sizes->getElementCount()) {
+      elem->reserveChildren(sizes->getChildCount(elementCount));
+      elem->reserveAttributes(sizes->getAttributeCount(elementCount));
+    }
+    ++elementCount;
+    addNode(elem);
+    current = elem;
+  }
+
+  /**
+   * Function which adds an attribute to the element opened last.
+   *
+   *@param name The name of the attribute.
+   *@param value The value of the attribute.
+   *@param namespaceId The namespace the attribute is in.
+   *@param valueOffset Unused, the value is copied.
+   */
+  void NodeSink::addAttribute(const std::string& name, const std::string& value, uint32_t namespaceId,
+      std::streamoff valueOffset)
+  {
+    std::unique_ptr<Attribute> attrib(new Attribute(name, value));
+    attrib->setNamespaceId(namespaceId);
+    current->addAttribute(std::move(attrib));
+  }
+
+  /**
+   * Function which closes the innermost open element.
+   *
+   *@param start The offset of its start tag in the source.
+   *@param end The offset right after its end tag in the source.
+   */
+  void NodeSink::endElement(std::streamoff start, std::streamoff end)
+  {
+    /*the children are all complete, so the span marks the whole subtree clean*/
+    if (withSpans)
+      current->setSourceSpan(start, end - start);
+    /*the children already have their hashes, so this only hashes the element's own content*/
+    if (withHashes)
+      current->getHash();
+    current = static_cast<ElementNode*>(current->getParentNode());
+  }
+
+  /**
+   * Function which adds a text, CDATA or comment node to the innermost open element.
+   *
+   *@param type TEXT, CDATA or COMMENT.
+   *@param text The content of the node.
+   *@param start The offset of the node in the source.
+   *@param end The offset right after the node in the source.
+   *@param valueOffset Unused, the text is copied.
+   */
+  void NodeSink::addText(TokenType type, const std::string& text, std::streamoff start, std::streamoff end,
+      std::streamoff valueOffset)
+  {
+    Node* node;
+
+    switch (type) {
+      case TEXT:
+	node = TextNode::createTextNode(text);
+	break;
+      case CDATA:
+	node = CDATANode::createCDATANode(text);
+	break;
+      case COMMENT:
+	node = CommentNode::createCommentNode(text);
+	break;
+      default:
+	throw XMLException("Only text, CDATA and comments can be added as text");
+    }
+
+    if (withSpans)
+      node->setSourceSpan(start, end - start);
+    addNode(node);
+  }
+
+  /**
+   * Constructor which starts an empty document.
+   *
+   *@param withSpans Whether the nodes should record the span of the input they were read from.
+   *@param withHashes Whether the hash of each element should be computed as soon as it is complete.
+   */
+  DocumentSink::DocumentSink(bool withSpans, bool withHashes) : NodeSink(withSpans, withHashes), doc(new Document())
+  {
+  }
+
+  /**
+   * Destructor. A document that was not released is freed with everything built so far.
+   */
+  DocumentSink::~DocumentSink()
+  {
+  }
+
+  /**
+   * Function which adds a node at the top level of the document.
+   *
+   *@param node The node to be added.
+   */
+  void DocumentSink::addTopLevel(Node* node)
+  {
+    doc->addChildNode(node);
+  }
+
+  /**
+   * Function which hands over the document built so far. The sink is left without a document.
+   *
+   *@return A unique_ptr to the document.
+   */
+  std::unique_ptr<Document> DocumentSink::release()
+  {
+    return std::move(doc);
+  }
+
+  /**
+   * Constructor
+   */
+  ElementSink::ElementSink() : NodeSink(false, false)
+  {
+  }
+
+  /**
+   * Destructor. An element that was not released is freed with its subtree.
+   */
+  ElementSink::~ElementSink()
+  {
+  }
+
+  /**
+   * Function which takes the element being built. There is no document to hold anything else.
+   *
+   *@param node The node to be added.
+   */
+  void ElementSink::addTopLevel(Node* node)
+  {
+    ElementNode* elem = dynamic_cast<ElementNode*>(node);
+    if (elem == nullptr || element)
+      throw XMLException("Only a single element can be built without a document");
+    element.reset(elem);
+  }
+
+  /**
+   * Function which hands over the element built so far.
+   *
+   *@return A unique_ptr to the element, nullptr if none was started.
+   */
+  std::unique_ptr<ElementNode> ElementSink::release()
+  {
+    return std::move(element);
+  }
+
+  /**
+   * Constructor which starts an empty FlatDocument.
+   *
+   *@param source The memory the tokenizer reads, from where it starts, or nullptr to copy the values.
+   */
+  FlatDocumentSink::FlatDocumentSink(const char* source)
+    : doc(source != nullptr ? new FlatDocument(source) : new FlatDocument()), inPlace(source != nullptr)
+  {
+  }
+
+  /**
+   * Destructor
+   */
+  FlatDocumentSink::~FlatDocumentSink()
+  {
+  }
+
+  /**
+   * Function which opens a new element.
+   *
+   *@param name The name of the element.
+   *@param namespaceId Unused, FlatDocument keeps names as written.
+   */
+  void FlatDocumentSink::startElement(const std::string& name, uint32_t namespaceId)
+  {
+    doc->startElement(name);
+  }
+
+  /**
+   * Function which adds an attribute to the element opened last.
+   *
+   *@param name The name of the attribute.
+   *@param value The value of the attribute.
+   *@param namespaceId Unused.
+   *@param valueOffset The offset of the value in the source, used when the values are read in place.
+   */
+  void FlatDocumentSink::addAttribute(const std::string& name, const std::string& value, uint32_t namespaceId,
+      std::streamoff valueOffset)
+  {
+    if (inPlace)
+      doc->addAttribute(name, valueOffset, value.size());
+    else
+      doc->addAttribute(name, value);
+  }
+
+  /**
+   * Function which closes the innermost open element.
+   *
+   *@param start Unused.
+   *@param end Unused.
+   */
+  void FlatDocumentSink::endElement(std::streamoff start, std::streamoff end)
+  {
+    doc->endElement();
+  }
+
+  /**
+   * Function which adds a text, CDATA or comment node.
+   *
+   *@param type TEXT, CDATA or COMMENT.
+   *@param text The content of the node.
+   *@param start Unused.
+   *@param end Unused.
+   *@param valueOffset The offset of the content in the source, used when the values are read in place.
+   */
+  void FlatDocumentSink::addText(TokenType type, const std::string& text, std::streamoff start, std::streamoff end,
+      std::streamoff valueOffset)
+  {
+    FlatDocument::NodeType flatType;
+
+    switch (type) {
+      case TEXT:
+	flatType = FlatDocument::TEXT;
+	break;
+      case CDATA:
+	flatType = FlatDocument::CDATA;
+	break;
+      case COMMENT:
+	flatType = FlatDocument::COMMENT;
+	break;
+      default:
+	throw XMLException("Only text, CDATA and comments can be added as text");
+    }
+
+    if (inPlace)
+      doc->addText(flatType, valueOffset, text.size());
+    else
+      doc->addText(flatType, text);
+  }
+
+  /**
+   * Function which hands over the FlatDocument built so far.
+   *
+   *@return A unique_ptr to the FlatDocument.
+   */
+  std::unique_ptr<FlatDocument> FlatDocumentSink::release()
+  {
+    return std::move(doc);
+  }
+
+  /**
+   * Constructor which starts an empty tree.
+   *
+   *@param sink Where the nodes go. It must outlive the builder.
+   */
+  TreeBuilder::TreeBuilder(TreeSink& sink)
+    : sink(sink), depth(0), singleElement(false), hasRoot(false), complete(false), throwOnError(true), nodeCount(0)
+  {
+  }
+
+  /**
+   * Function which makes the builder stop at the end tag of the element started first, for building one element out of
+   * a longer input.
+   *
+   *@param singleElement true to build a single element, false to build a whole document.
+   */
+  void TreeBuilder::setSingleElement(bool singleElement)
+  {
+    this->singleElement = singleElement;
+  }
+
+  /**
+   * Function which chooses how malformed input is reported.
+   *
+   *@param throwOnError true to throw XMLException, false to record the error and ignore the rest of the input.
+   */
+  void TreeBuilder::setThrowOnError(bool throwOnError)
+  {
+    this->throwOnError = throwOnError;
+  }
+
+  /**
+   * Function which returns the first error found in the tokens.
+   *
+   *@return The error code, PARSE_OK if there was none.
+   */
+  ParseErrorCode TreeBuilder::getError() const
+  {
+    return error.code;
+  }
+
+  /**
+   * Function which sets the bounds on the depth of the tree and on the number of its nodes.
+   *
+   *@param limits The limits; the sizes of names and text are left to the tokenizer.
+   */
+  void TreeBuilder::setLimits(const ParseLimits& limits)
+  {
+    this->limits = limits;
+  }
+
+  /**
+   * Function which records an error in the tokens. The exception thrown has the offset of the token but no line; Parser
+   * reports errors at the token the tokenizer last returned, where the line can be found.
+   *
+   *@param code What is wrong with the input.
+   *@param offset The offset of the token that showed it.
+   */
+  void TreeBuilder::fail(ParseErrorCode code, std::streamoff offset)
+  {
+    if (error.code == PARSE_OK)
+      error = ParseError(code, offset);
+    if (throwOnError)
+      throw XMLException(error);
+  }
+
+  /**
+   * Function which adds the token the tokenizer just returned to the tree. Start tags open a new element, which is closed
+   * again by the matching end tag.
+   *
+   *@param type The type of the token.
+   *@param t The tokenizer holding the values of the token.
+   *@return false once the tree is complete or the input is found malformed, true otherwise.
+   */
+  bool TreeBuilder::addToken(TokenType type, const XMLTokenizer& t)
+  {
+    if (error.code != PARSE_OK)
+      return false;
+
+    switch (type) {
+
+      case START_TAG:
+	startElement(t.getTagName(), t.getTokenOffset(), t.getNamespaceId());
+	for (int i = 0; i < t.getAttributeCount() && error.code == PARSE_OK; ++i) {
+	  addAttribute(t.getAttributeName(i), t.getAttributeValue(i), t.getAttributeNamespaceId(i),
+	      t.getAttributeValueOffset(i));
+	}
+	break;
+
+      case END_TAG:
+	endElement(t.getTagName(), t.getTokenOffset(), t.getOffset());
+	break;
+
+      case TEXT:
+	addText(TEXT, t.getText(), t.getTokenOffset(), t.getOffset(), t.getTextOffset());
+	break;
+
+      case CDATA:
+	addText(CDATA, t.getCDATA(), t.getTokenOffset(), t.getOffset(), t.getTextOffset());
+	break;
+
+      case COMMENT:
+	addText(COMMENT, t.getComment(), t.getTokenOffset(), t.getOffset(), t.getTextOffset());
+	break;
+
+      case ENDOFFILE:
+	endDocument(t.getOffset());
+	break;
+
+      default:
+	break;
+    }
+    return error.code == PARSE_OK && !complete;
+  }
+
+  /**
+   * Function which adds the tokens of a tokenizer until the tree is complete or the input is found malformed. The builder
+   * stops throwing itself; an error it finds is handed to the tokenizer at the token that showed it, just like the
+   * tokenizer's own errors, so the tokenizer can find its line.
+   *
+   *@param t The tokenizer.
+   *@param type The token the tokenizer has just returned.
+   */
+  void TreeBuilder::addTokens(XMLTokenizer& t, TokenType type)
+  {
+    this->throwOnError = false;
+
+    while (addToken(type, t)) {
+      type = t.getToken();
+    }
+
+    if (error.code != PARSE_OK)
+      t.setError(error.code, t.getTokenOffset());
+  }
+
+  /**
+   * Function which opens a new element inside the innermost open one.
+   *
+   *@param name The name of the element.
+   *@param start The offset of its start tag in the source.
+   *@param namespaceId The namespace the element is in.
+   */
+  void TreeBuilder::startElement(const std::string& name, std::streamoff start, uint32_t namespaceId)
+  {
+    if (error.code != PARSE_OK)
+      return;
+    if (depth == 0) {
+      if (hasRoot)
+	return fail(MULTIPLE_ROOTS, start);
+      hasRoot = true;
+    }
+    if (depth >= limits.maxDepth)
+      return fail(DEPTH_LIMIT_EXCEEDED, start);
+    if (++nodeCount > limits.maxNodes)
+      return fail(NODE_LIMIT_EXCEEDED, start);
+
+    sink.startElement(name, namespaceId);
+    if (depth == names.size()) {
+      names.push_back(name);
+      starts.push_back(start);
+    }
+    else {
+      names[depth].assign(name);
+      starts[depth] = start;
+    }
+    ++depth;
+  }
+
+  /**
+   * Function which adds an attribute to the element opened last.
+   *
+   *@param name The name of the attribute.
+   *@param value The value of the attribute.
+   *@param namespaceId The namespace the attribute is in.
+   *@param valueOffset The offset of the value in the source.
+   */
+  void TreeBuilder::addAttribute(const std::string& name, const std::string& value, uint32_t namespaceId,
+      std::streamoff valueOffset)
+  {
+    if (error.code != PARSE_OK)
+      return;
+    if (depth == 0)
+      throw XMLException("Attributes can only be added to an open element");
+    sink.addAttribute(name, value, namespaceId, valueOffset);
+  }
+
+  /**
+   * Function which closes the innermost open element, which must have the given name.
+   *
+   *@param name The name in the end tag.
+   *@param start The offset of the end tag in the source.
+   *@param end The offset right after the end tag in the source.
+   */
+  void TreeBuilder::endElement(const std::string& name, std::streamoff start, std::streamoff end)
+  {
+    if (error.code != PARSE_OK)
+      return;
+    if (depth == 0 || names[depth - 1] != name)
+      return fail(MISMATCHED_TAG, start);
+
+    --depth;
+    sink.endElement(starts[depth], end);
+    if (singleElement && depth == 0)
+      complete = true;
+  }
+
+  /**
+   * Function which adds a text, CDATA or comment node to the innermost open element.
+   *
+   *@param type TEXT, CDATA or COMMENT.
+   *@param text The content of the node.
+   *@param start The offset of the node in the source.
+   *@param end The offset right after the node in the source.
+   *@param valueOffset The offset of the content in the source.
+   */
+  void TreeBuilder::addText(TokenType type, const std::string& text, std::streamoff start, std::streamoff end,
+      std::streamoff valueOffset)
+  {
+    if (error.code != PARSE_OK)
+      return;
+    if (type == TEXT && text.empty())
+      return;
+    if (++nodeCount > limits.maxNodes)
+      return fail(NODE_LIMIT_EXCEEDED, start);
+
+    if (type == TEXT) {
+      if (text.find_first_of("><&") != std::string::npos)
+	return fail(INVALID_TEXT, start);
+      if (depth == 0 && text.find_first_not_of(" \t\r\n") != std::string::npos)
+	return fail(CONTENT_OUTSIDE_ROOT, start);
+    }
+    else if (type == CDATA && depth == 0) {
+      return fail(CONTENT_OUTSIDE_ROOT, start);
+    }
+
+    sink.addText(type, text, start, end, valueOffset);
+  }
+
+  /**
+   * Function which checks that every element was closed when the input ends.
+   *
+   *@param end The offset of the end of the input.
+   */
+  void TreeBuilder::endDocument(std::streamoff end)
+  {
+    if (error.code != PARSE_OK)
+      return;
+    if (depth != 0)
+      return fail(UNCLOSED_ELEMENT, end);
+    complete = true;
+  }
+
+  /**
+   * Function which tells whether the tree is finished: the end of the document was reached, or the element built on its
+   * own was closed.
+   *
+   *@return true if no more tokens are needed.
+   */
+  bool TreeBuilder::isComplete() const
+  {
+    return complete;
+  }
+
+}
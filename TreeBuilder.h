@@ -0,0 +1,175 @@
+#ifndef __TREEBUILDER_H__
+#define __TREEBUILDER_H__
+
+#include <memory>
+#include <vector>
+#include <string>
+#include "XMLTokenizer.h"
+#include "StructureScan.h"
+
+namespace tinyXMLpp {
+
+  class Document;
+  class FlatDocument;
+  class ElementNode;
+  class Node;
+
+  /*Receives the nodes TreeBuilder has checked and builds them into a
+    tree of its own kind. Offsets are -1 when the tokens did not come
+    with them.*/
+  class TreeSink {
+
+    public:
+    virtual ~TreeSink() {}
+
+    virtual void startElement(const std::string& name, uint32_t namespaceId) = 0;
+    virtual void addAttribute(const std::string& name, const std::string& value, uint32_t namespaceId,
+	std::streamoff valueOffset) = 0;
+    /*start and end delimit the whole element in the source*/
+    virtual void endElement(std::streamoff start, std::streamoff end) = 0;
+    /*TEXT, CDATA or COMMENT; start and end delimit the markup, valueOffset the content*/
+    virtual void addText(TokenType type, const std::string& text, std::streamoff start, std::streamoff end,
+	std::streamoff valueOffset) = 0;
+  };
+
+  /*Builds Node trees, under a Document or on their own*/
+  class NodeSink : public TreeSink {
+
+    ElementNode* current;			//innermost open element, nullptr at the top level
+    bool withSpans;
+    bool withHashes;
+    const StructureScan* sizes;
+    size_t elementCount;			//elements started so far, the number of the next one in sizes
+
+    void addNode(Node* node);
+
+    protected:
+    /*Takes a node that is outside every element*/
+    virtual void addTopLevel(Node* node) = 0;
+
+    public:
+    NodeSink(bool withSpans, bool withHashes);
+
+    /*Sizes the lists of each element from a scan of the same input,
+      which must outlive the sink*/
+    void setSizes(const StructureScan* sizes);
+
+    void startElement(const std::string& name, uint32_t namespaceId);
+    void addAttribute(const std::string& name, const std::string& value, uint32_t namespaceId, std::streamoff valueOffset);
+    void endElement(std::streamoff start, std::streamoff end);
+    void addText(TokenType type, const std::string& text, std::streamoff start, std::streamoff end,
+	std::streamoff valueOffset);
+  };
+
+  /*Builds a Document*/
+  class DocumentSink : public NodeSink {
+
+    std::unique_ptr<Document> doc;
+
+    protected:
+    void addTopLevel(Node* node);
+
+    public:
+    DocumentSink(bool withSpans = false, bool withHashes = false);
+    ~DocumentSink();
+
+    /*Hands over the document built so far*/
+    std::unique_ptr<Document> release();
+  };
+
+  /*Builds a single element with no document around it*/
+  class ElementSink : public NodeSink {
+
+    std::unique_ptr<ElementNode> element;
+
+    protected:
+    void addTopLevel(Node* node);
+
+    public:
+    ElementSink();
+    ~ElementSink();
+
+    std::unique_ptr<ElementNode> release();
+  };
+
+  /*Builds a FlatDocument. Given the memory the tokens were read from,
+    the values are kept as offsets into it instead of being copied.*/
+  class FlatDocumentSink : public TreeSink {
+
+    std::unique_ptr<FlatDocument> doc;
+    bool inPlace;
+
+    public:
+    FlatDocumentSink(const char* source = nullptr);
+    ~FlatDocumentSink();
+
+    void startElement(const std::string& name, uint32_t namespaceId);
+    void addAttribute(const std::string& name, const std::string& value, uint32_t namespaceId, std::streamoff valueOffset);
+    void endElement(std::streamoff start, std::streamoff end);
+    void addText(TokenType type, const std::string& text, std::streamoff start, std::streamoff end,
+	std::streamoff valueOffset);
+
+    std::unique_ptr<FlatDocument> release();
+  };
+
+  /*Checks tokens pushed into it one at a time and hands the nodes
+    they make to a TreeSink, so the same rules and limits serve every
+    kind of tree and every way of reading the tokens: pulled from a
+    stream by Parser, or handed over as input arrives.*/
+  class TreeBuilder {
+
+    TreeSink& sink;
+    size_t depth;				//number of open elements
+    std::vector<std::string> names;		//names of the open elements, kept to reuse their memory
+    std::vector<std::streamoff> starts;		//source offsets of the open elements
+    bool singleElement;
+    bool hasRoot;
+    bool complete;
+    bool throwOnError;
+    ParseError error;
+    ParseLimits limits;
+    size_t nodeCount;
+
+    void fail(ParseErrorCode code, std::streamoff offset);
+
+    public:
+    TreeBuilder(TreeSink& sink);
+
+    /*Builds just the element started next and stops at its end tag,
+      instead of a whole document*/
+    void setSingleElement(bool singleElement);
+
+    /*Malformed input throws XMLException by default. Without throwing,
+      the first error is recorded and every later step is ignored.*/
+    void setThrowOnError(bool throwOnError);
+    ParseErrorCode getError() const;
+
+    /*Bounds on nesting depth and node count, see ParseLimits*/
+    void setLimits(const ParseLimits& limits);
+
+    /*Adds the token the tokenizer just returned to the tree. Returns
+      false once the tree is complete or on an error.*/
+    bool addToken(TokenType type, const XMLTokenizer& t);
+
+    /*Reads tokens from t, from the one it has just returned, until the
+      tree is complete. Errors are reported through the tokenizer, so
+      they are thrown or recorded as t is set to, with their line.*/
+    void addTokens(XMLTokenizer& t, TokenType type);
+
+    /*The same steps, for tokens that come from somewhere else. Offsets
+      are only used for errors and by sinks that record spans.*/
+    void startElement(const std::string& name, std::streamoff start, uint32_t namespaceId = 0);
+    void addAttribute(const std::string& name, const std::string& value, uint32_t namespaceId = 0,
+	std::streamoff valueOffset = -1);
+    void endElement(const std::string& name, std::streamoff start, std::streamoff end);
+    void addText(TokenType type, const std::string& text, std::streamoff start, std::streamoff end,
+	std::streamoff valueOffset = -1);
+    void endDocument(std::streamoff end);
+
+    /*true once the document, or the single element, is finished*/
+    bool isComplete() const;
+  };
+
+}
+
+#endif
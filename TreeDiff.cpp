@@ -0,0 +1,759 @@
+#include "TreeDiff.h"
+#include "Document.h"
+#include "ElementNode.h"
+#include "TextNode.h"
+#include "CDATANode.h"
+#include "CommentNode.h"
+#include "Attribute.h"
+#include "Namespace.h"
+#include "XMLException.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace tinyXMLpp {
+
+  namespace {
+
+    const char DIFF_MAGIC[8] = { 'T', 'X', 'P', 'P', 'D', 'I', 'F', '1' };
+
+    /*Longest edit script worked out exactly between two child lists. Beyond it the changed children are paired by position.*/
+    const int MAX_EDIT_DISTANCE = 1024;
+
+    enum NodeKind { ELEMENT_KIND, TEXT_KIND, CDATA_KIND, COMMENT_KIND };
+
+    NodeKind getKind(const Node* node)
+    {
+      if (dynamic_cast<const ElementNode*>(node) != nullptr)
+	return ELEMENT_KIND;
+      if (dynamic_cast<const TextNode*>(node) != nullptr)
+	return TEXT_KIND;
+      if (dynamic_cast<const CDATANode*>(node) != nullptr)
+	return CDATA_KIND;
+      if (dynamic_cast<const CommentNode*>(node) != nullptr)
+	return COMMENT_KIND;
+      throw XMLException("Unknown node type found while comparing documents");
+    }
+
+    /*Content of a text, CDATA or comment node*/
+    const std::string& getText(const Node* node)
+    {
+      switch (getKind(node)) {
+	case TEXT_KIND:
+	  return static_cast<const TextNode*>(node)->getText();
+	case CDATA_KIND:
+	  return static_cast<const CDATANode*>(node)->getcdata();
+	case COMMENT_KIND:
+	  return static_cast<const CommentNode*>(node)->getContent();
+	default:
+	  throw XMLException("Elements have no text of their own");
+      }
+    }
+
+    /*A node can be updated in place into another one of the same kind; elements must also have the same name*/
+    bool canUpdate(const Node* from, const Node* to)
+    {
+      NodeKind kind = getKind(from);
+      if (kind != getKind(to))
+	return false;
+      if (kind == ELEMENT_KIND)
+	return static_cast<const ElementNode*>(from)->getName() == static_cast<const ElementNode*>(to)->getName();
+      return true;
+    }
+
+    enum Edit { KEEP, DELETE, INSERT };
+
+    /*Walks the saved diagonals of shortestEdit back from the end, collecting the edits in reverse*/
+    void backtrack(const std::vector<std::vector<int> >& trace, int x, int y, std::vector<Edit>& edits)
+    {
+      for (int d = trace.size() - 1; d > 0; --d) {
+	const std::vector<int>& prev = trace[d - 1];	//diagonal k is at index k + d - 1
+	int k = x - y;
+	int prevK = (k == -d || (k != d && prev[k - 1 + d - 1] < prev[k + 1 + d - 1])) ? k + 1 : k - 1;
+	int prevX = prev[prevK + d - 1];
+	int prevY = prevX - prevK;
+
+	while (x > prevX && y > prevY) {
+	  edits.push_back(KEEP);
+	  --x;
+	  --y;
+	}
+	edits.push_back(x == prevX ? INSERT : DELETE);
+	x = prevX;
+	y = prevY;
+      }
+
+      while (x > 0 && y > 0) {
+	edits.push_back(KEEP);
+	--x;
+	--y;
+      }
+      std::reverse(edits.begin(), edits.end());
+    }
+
+    /*Shortest edit script between two sequences of subtree hashes, by Myers' O(ND) algorithm. Runs of equal subtrees cost
+      nothing, so the time depends on how much changed rather than on the length of the lists. Returns false if the script
+      is longer than MAX_EDIT_DISTANCE.*/
+    bool shortestEdit(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b, std::vector<Edit>& edits)
+    {
+      int n = a.size(), m = b.size();
+      int maxDistance = std::min(n + m, MAX_EDIT_DISTANCE);
+      int offset = maxDistance + 1;
+      std::vector<int> v(2 * maxDistance + 3, 0);
+      std::vector<std::vector<int> > trace;
+
+      for (int d = 0; d <= maxDistance; ++d) {
+	for (int k = -d; k <= d; k += 2) {
+	  int x = (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1])) ? v[offset + k + 1] : v[offset + k - 1] + 1;
+	  int y = x - k;
+	  while (x < n && y < m && a[x] == b[y]) {
+	    ++x;
+	    ++y;
+	  }
+	  v[offset + k] = x;
+
+	  if (x >= n && y >= m) {
+	    trace.push_back(std::vector<int>(v.begin() + offset - d, v.begin() + offset + d + 1));
+	    backtrack(trace, n, m, edits);
+	    return true;
+	  }
+	}
+	trace.push_back(std::vector<int>(v.begin() + offset - d, v.begin() + offset + d + 1));
+      }
+      return false;
+    }
+
+    /*State of a running diff. path holds the path of the node being compared.*/
+    struct Differ {
+      std::vector<TreeDiff::Operation>& operations;
+      std::vector<uint32_t> path;
+
+      Differ(std::vector<TreeDiff::Operation>& operations) : operations(operations) {}
+
+      void add(TreeDiff::OperationType type, const std::string& name, const std::string& value) {
+	TreeDiff::Operation op;
+	op.type = type;
+	op.path = path;
+	op.name = name;
+	op.value = value;
+	operations.push_back(std::move(op));
+      }
+
+      void addInsert(const Node* node) {
+	TreeDiff::Operation op;
+	op.type = TreeDiff::INSERT_NODE;
+	op.path = path;
+	op.node = node->clone();
+	operations.push_back(std::move(op));
+      }
+
+      /*Both nodes can be updated into each other, and path points at the first*/
+      void diffNode(const Node* from, const Node* to) {
+	if (from->getHash() == to->getHash())
+	  return;
+
+	if (getKind(from) != ELEMENT_KIND) {
+	  if (getText(from) != getText(to))
+	    add(TreeDiff::UPDATE_TEXT, "", getText(to));
+	  return;
+	}
+
+	diffAttributes(static_cast<const ElementNode*>(from), static_cast<const ElementNode*>(to));
+	diffChildren(from->getChildren(), to->getChildren(), 0);
+      }
+
+      /*Attributes are removed, changed in place or appended. If that cannot give the order of the new element, they are
+        all set again.*/
+      void diffAttributes(const ElementNode* from, const ElementNode* to) {
+	ConstPointerList<Attribute> oldAttributes = from->getAttributes();
+	ConstPointerList<Attribute> newAttributes = to->getAttributes();
+
+	std::vector<const std::string*> order;
+	for (size_t i = 0; i < oldAttributes.size(); ++i) {
+	  if (to->getAttribute(oldAttributes[i]->getName()) != nullptr)
+	    order.push_back(&oldAttributes[i]->getName());
+	}
+	for (size_t i = 0; i < newAttributes.size(); ++i) {
+	  if (from->getAttribute(newAttributes[i]->getName()) == nullptr)
+	    order.push_back(&newAttributes[i]->getName());
+	}
+
+	bool sameOrder = order.size() == newAttributes.size();
+	for (size_t i = 0; sameOrder && i < order.size(); ++i) {
+	  sameOrder = *order[i] == newAttributes[i]->getName();
+	}
+
+	for (size_t i = 0; i < oldAttributes.size(); ++i) {
+	  if (!sameOrder || to->getAttribute(oldAttributes[i]->getName()) == nullptr)
+	    add(TreeDiff::REMOVE_ATTRIBUTE, oldAttributes[i]->getName(), "");
+	}
+	for (size_t i = 0; i < newAttributes.size(); ++i) {
+	  const Attribute* old = sameOrder ? from->getAttribute(newAttributes[i]->getName()) : nullptr;
+	  if (old == nullptr || old->getValue() != newAttributes[i]->getValue())
+	    add(TreeDiff::SET_ATTRIBUTE, newAttributes[i]->getName(), newAttributes[i]->getValue());
+	}
+      }
+
+      /*Turns one child list into the other. The children of the list start at index pos of their parent. Within each run
+        of changes, deleted and inserted nodes are paired up and updated in place where they can be. The lists are the
+        children of a node or the top level nodes of a document.*/
+      template<class NodeList>
+      void diffChildren(const NodeList& from, const NodeList& to, uint32_t pos) {
+	std::vector<uint64_t> fromHashes(from.size()), toHashes(to.size());
+	for (size_t i = 0; i < from.size(); ++i) {
+	  fromHashes[i] = from[i]->getHash();
+	}
+	for (size_t i = 0; i < to.size(); ++i) {
+	  toHashes[i] = to[i]->getHash();
+	}
+
+	std::vector<Edit> edits;
+	if (!shortestEdit(fromHashes, toHashes, edits)) {
+	  edits.assign(from.size(), DELETE);
+	  edits.insert(edits.end(), to.size(), INSERT);
+	}
+
+	size_t i = 0, j = 0, e = 0;
+	while (e < edits.size()) {
+	  if (edits[e] == KEEP) {
+	    ++i;
+	    ++j;
+	    ++e;
+	    ++pos;
+	    continue;
+	  }
+
+	  size_t firstDeleted = i, firstInserted = j;
+	  for (; e < edits.size() && edits[e] != KEEP; ++e) {
+	    if (edits[e] == DELETE)
+	      ++i;
+	    else
+	      ++j;
+	  }
+	  size_t deleted = i - firstDeleted, inserted = j - firstInserted;
+	  size_t pairs = std::min(deleted, inserted);
+
+	  path.push_back(0);
+	  for (size_t p = 0; p < pairs; ++p, ++pos) {
+	    const Node* oldNode = from[firstDeleted + p];
+	    const Node* newNode = to[firstInserted + p];
+	    path.back() = pos;
+	    if (canUpdate(oldNode, newNode))
+	      diffNode(oldNode, newNode);
+	    else {
+	      add(TreeDiff::DELETE_NODE, "", "");
+	      addInsert(newNode);
+	    }
+	  }
+	  for (size_t p = pairs; p < deleted; ++p) {
+	    path.back() = pos;
+	    add(TreeDiff::DELETE_NODE, "", "");
+	  }
+	  for (size_t p = pairs; p < inserted; ++p, ++pos) {
+	    path.back() = pos;
+	    addInsert(to[firstInserted + p]);
+	  }
+	  path.pop_back();
+	}
+      }
+    };
+
+    /*Position of the root element among the top level nodes*/
+    size_t findRoot(const Document& doc)
+    {
+      const std::vector<Node*>& children = doc.getChildren();
+      for (size_t i = 0; i < children.size(); ++i) {
+	if (children[i] == doc.getRootElement())
+	  return i;
+      }
+      return children.size();
+    }
+
+    /*Finds the node at the first length steps of a path. An empty path stands for the document itself, returned as
+      nullptr.*/
+    Node* findNode(Document& doc, const std::vector<uint32_t>& path, size_t length)
+    {
+      if (length == 0)
+	return nullptr;
+
+      const std::vector<Node*>& top = doc.getChildren();
+      if (path[0] >= top.size())
+	throw XMLException("Edit script does not fit the document");
+
+      Node* node = top[path[0]];
+      for (size_t i = 1; i < length; ++i) {
+	if (path[i] >= (uint32_t)node->getChildCount())
+	  throw XMLException("Edit script does not fit the document");
+	node = node->getChild(path[i]);
+      }
+      return node;
+    }
+
+    void writeUint32(std::ostream& os, uint32_t value)
+    {
+      os.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void writeString(std::ostream& os, const std::string& str)
+    {
+      writeUint32(os, str.size());
+      os.write(str.data(), str.size());
+    }
+
+    /*Subtrees are written in preorder: kind, then the text, or the name, namespace, attributes and children of an element*/
+    void writeNode(std::ostream& os, const Node* node)
+    {
+      NodeKind kind = getKind(node);
+      os.put(kind);
+
+      if (kind != ELEMENT_KIND) {
+	writeString(os, getText(node));
+	return;
+      }
+
+      const ElementNode* elem = static_cast<const ElementNode*>(node);
+      writeString(os, elem->getName());
+      writeString(os, elem->getNamespaceURI());
+
+      ConstPointerList<Attribute> attributes = elem->getAttributes();
+      writeUint32(os, attributes.size());
+      for (size_t i = 0; i < attributes.size(); ++i) {
+	writeString(os, attributes[i]->getName());
+	writeString(os, attributes[i]->getValue());
+	writeString(os, attributes[i]->getNamespaceURI());
+      }
+
+      ConstPointerList<Node> children = elem->getChildren();
+      writeUint32(os, children.size());
+      for (size_t i = 0; i < children.size(); ++i) {
+	writeNode(os, children[i]);
+      }
+    }
+
+    /*Reads a saved script. Every count and length in it is checked against the bytes the stream has left before anything
+      is allocated for it, and subtrees are read with a stack of their open elements rather than by recursion.*/
+    class ScriptReader {
+
+      struct OpenElement {
+	ElementNode* elem;
+	uint32_t childrenLeft;
+      };
+
+      std::istream& is;
+      uint64_t remaining;			//bytes left in the stream, UINT64_MAX if it cannot seek
+      size_t maxDepth;
+      std::vector<OpenElement> open;
+
+      void consume(uint64_t length) {
+	if (length > remaining)
+	  throw XMLException("Truncated edit script");
+	if (remaining != UINT64_MAX)
+	  remaining -= length;
+      }
+
+      /*The node at the stream with its content and attributes; an element's child count is left in childCount*/
+      std::unique_ptr<Node> readContent(uint32_t& childCount) {
+	childCount = 0;
+	int kind = readByte();
+	switch (kind) {
+	  case TEXT_KIND:
+	    return std::unique_ptr<Node>(TextNode::createTextNode(readString()));
+	  case CDATA_KIND:
+	    return std::unique_ptr<Node>(CDATANode::createCDATANode(readString()));
+	  case COMMENT_KIND:
+	    return std::unique_ptr<Node>(CommentNode::createCommentNode(readString()));
+	  case ELEMENT_KIND:
+	    break;
+	  default:
+	    throw XMLException("Unknown node kind found in edit script");
+	}
+
+	std::unique_ptr<ElementNode> elem(ElementNode::createElementNode(readString()));
+	uint32_t id = readNamespace();
+	elem->setNamespaceId(id);
+	NamespaceTable::release(id);
+
+	/*name, value and namespace take at least a length each*/
+	uint32_t attributeCount = readCount(3 * sizeof(uint32_t));
+	for (uint32_t i = 0; i < attributeCount; ++i) {
+	  std::string name = readString();
+	  std::string value = readString();
+	  std::unique_ptr<Attribute> attrib(new Attribute(std::move(name), std::move(value)));
+	  id = readNamespace();
+	  attrib->setNamespaceId(id);
+	  NamespaceTable::release(id);
+	  elem->addAttribute(std::move(attrib));
+	}
+
+	/*a child takes at least its kind and a length*/
+	childCount = readCount(1 + sizeof(uint32_t));
+	return std::unique_ptr<Node>(elem.release());
+      }
+
+      public:
+      ScriptReader(std::istream& is, size_t maxDepth) : is(is), remaining(UINT64_MAX), maxDepth(maxDepth) {
+	std::streampos start = is.tellg();
+	if (start != std::streampos(-1) && is.seekg(0, std::ios::end)) {
+	  remaining = is.tellg() - start;
+	  is.seekg(start);
+	}
+	is.clear();
+      }
+
+      void readBytes(char* data, size_t length) {
+	consume(length);
+	is.read(data, length);
+	if (!is)
+	  throw XMLException("Truncated edit script");
+      }
+
+      int readByte() {
+	char byte;
+	readBytes(&byte, 1);
+	return (unsigned char)byte;
+      }
+
+      uint32_t readUint32() {
+	uint32_t value;
+	readBytes(reinterpret_cast<char*>(&value), sizeof(value));
+	return value;
+      }
+
+      uint64_t readUint64() {
+	uint64_t value;
+	readBytes(reinterpret_cast<char*>(&value), sizeof(value));
+	return value;
+      }
+
+      uint64_t getRemaining() const {
+	return remaining;
+      }
+
+      /*A count of items each taking at least itemSize bytes*/
+      uint32_t readCount(size_t itemSize) {
+	uint32_t count = readUint32();
+	if (remaining != UINT64_MAX && count > remaining / itemSize)
+	  throw XMLException("Truncated edit script");
+	return count;
+      }
+
+      /*Strings of streams that cannot seek are read a piece at a time, so memory follows the bytes actually there*/
+      std::string readString() {
+	uint32_t length = readUint32();
+	consume(length);
+	std::string str;
+	const size_t PIECE = 64 * 1024;
+	while (str.size() < length) {
+	  size_t size = str.size();
+	  size_t piece = std::min<size_t>(length - size, remaining == UINT64_MAX ? PIECE : length);
+	  str.resize(size + piece);
+	  is.read(&str[size], piece);
+	  if (!is)
+	    throw XMLException("Truncated edit script");
+	}
+	return str;
+      }
+
+      /*The caller gives the reference back once the node holds its own*/
+      uint32_t readNamespace() {
+	uint32_t id = NamespaceTable::intern(readString());
+	if (id == NamespaceTable::INVALID_NAMESPACE)
+	  throw XMLException(getErrorMessage(NAMESPACE_LIMIT_EXCEEDED));
+	return id;
+      }
+
+      /*Reads a subtree written by writeNode. Each node is added to its parent as soon as it is read, so the whole
+	subtree is freed with its root if the script turns out to be malformed.*/
+      std::unique_ptr<Node> readNode() {
+	std::unique_ptr<Node> root;
+	open.clear();
+	do {
+	  uint32_t childCount;
+	  std::unique_ptr<Node> node = readContent(childCount);
+	  Node* added = node.get();
+	  if (open.empty())
+	    root = std::move(node);
+	  else {
+	    open.back().elem->addChildNode(std::move(node));
+	    --open.back().childrenLeft;
+	  }
+
+	  if (childCount > 0) {
+	    if (open.size() + 1 > maxDepth)
+	      throw XMLException(getErrorMessage(DEPTH_LIMIT_EXCEEDED));
+	    OpenElement element = { static_cast<ElementNode*>(added), childCount };
+	    open.push_back(element);
+	  }
+	  while (!open.empty() && open.back().childrenLeft == 0)
+	    open.pop_back();
+	} while (!open.empty());
+	return root;
+      }
+    };
+  }
+
+  /**
+   * Function which computes the edit script turning one document into another. Child lists are compared by subtree hash,
+   * so unchanged subtrees are matched without being looked into, and only the changed ones are descended into. The root
+   * elements are always compared with each other when they have the same name, so the script never holds two roots at
+   * once.
+   *
+   *@param from The document the script starts from.
+   *@param to The document the script leads to.
+   *@return The edit script.
+   */
+  TreeDiff TreeDiff::diff(const Document& from, const Document& to)
+  {
+    TreeDiff script;
+    Differ differ(script.operations);
+
+    const std::vector<Node*>& fromTop = from.getChildren();
+    const std::vector<Node*>& toTop = to.getChildren();
+    size_t fromRoot = findRoot(from), toRoot = findRoot(to);
+
+    if (fromRoot == fromTop.size() || toRoot == toTop.size()) {
+      differ.diffChildren(fromTop, toTop, 0);
+      return script;
+    }
+
+    /*nodes before the root, the root, then nodes after it*/
+    differ.diffChildren(std::vector<Node*>(fromTop.begin(), fromTop.begin() + fromRoot),
+	std::vector<Node*>(toTop.begin(), toTop.begin() + toRoot), 0);
+
+    differ.path.push_back(toRoot);
+    if (canUpdate(fromTop[fromRoot], toTop[toRoot]))
+      differ.diffNode(fromTop[fromRoot], toTop[toRoot]);
+    else {
+      differ.add(DELETE_NODE, "", "");
+      differ.addInsert(toTop[toRoot]);
+    }
+    differ.path.pop_back();
+
+    differ.diffChildren(std::vector<Node*>(fromTop.begin() + fromRoot + 1, fromTop.end()),
+	std::vector<Node*>(toTop.begin() + toRoot + 1, toTop.end()), toRoot + 1);
+    return script;
+  }
+
+  /**
+   * Function which applies the edit script to a document, in place. The document must be equal to the one the script was
+   * computed from; paths that do not fit it raise an XMLException, possibly after part of the script was applied.
+   *
+   *@param doc The document to be changed.
+   */
+  void TreeDiff::apply(Document& doc) const
+  {
+    for (size_t n = 0; n < operations.size(); ++n) {
+      const Operation& op = operations[n];
+      if (op.path.empty())
+	throw XMLException("Edit script operation without a path");
+
+      switch (op.type) {
+
+	case INSERT_NODE: {
+	  Node* parent = findNode(doc, op.path, op.path.size() - 1);
+	  uint32_t index = op.path.back();
+	  std::unique_ptr<Node> node = op.node->clone();
+
+	  if (parent == nullptr) {
+	    if (index == doc.getChildren().size())
+	      doc.addChildNode(std::move(node));
+	    else
+	      doc.addChildNode(std::move(node), index);
+	  }
+	  else {
+	    if (index == (uint32_t)parent->getChildCount())
+	      parent->addChildNode(std::move(node));
+	    else
+	      parent->addChildNode(std::move(node), index);
+	  }
+	  break;
+	}
+
+	case DELETE_NODE: {
+	  Node* parent = findNode(doc, op.path, op.path.size() - 1);
+	  uint32_t index = op.path.back();
+
+	  if (parent == nullptr)
+	    doc.removeChildNode(index);
+	  else
+	    parent->removeChildNode(index);
+	  break;
+	}
+
+	case UPDATE_TEXT: {
+	  Node* node = findNode(doc, op.path, op.path.size());
+	  switch (getKind(node)) {
+	    case TEXT_KIND:
+	      static_cast<TextNode*>(node)->setText(op.value);
+	      break;
+	    case CDATA_KIND:
+	      static_cast<CDATANode*>(node)->setcdata(op.value);
+	      break;
+	    case COMMENT_KIND:
+	      static_cast<CommentNode*>(node)->setContent(op.value);
+	      break;
+	    default:
+	      throw XMLException("Edit script updates the text of an element");
+	  }
+	  break;
+	}
+
+	case SET_ATTRIBUTE:
+	case REMOVE_ATTRIBUTE: {
+	  ElementNode* elem = dynamic_cast<ElementNode*>(findNode(doc, op.path, op.path.size()));
+	  if (elem == nullptr)
+	    throw XMLException("Edit script changes an attribute of a node that is not an element");
+
+	  if (op.type == REMOVE_ATTRIBUTE)
+	    elem->removeAttribute(op.name);
+	  else if (Attribute* attrib = elem->getAttribute(op.name))
+	    attrib->setValue(op.value);
+	  else
+	    elem->addAttribute(op.name, op.value);
+	  break;
+	}
+
+	default:
+	  throw XMLException("Unknown edit script operation");
+      }
+    }
+  }
+
+  /**
+   * Function which tells whether the two documents compared were the same.
+   *
+   *@return true if the script has no operations.
+   */
+  bool TreeDiff::empty() const
+  {
+    return operations.empty();
+  }
+
+  /**
+   * Function which returns the number of operations in the script.
+   *
+   *@return The number of operations.
+   */
+  size_t TreeDiff::size() const
+  {
+    return operations.size();
+  }
+
+  /**
+   * Function which returns an operation of the script.
+   *
+   *@param n The number of the operation.
+   *@return The operation.
+   */
+  const TreeDiff::Operation& TreeDiff::getOperation(size_t n) const
+  {
+    if (n >= operations.size())
+      throw XMLException("Edit script operation out of range");
+    return operations[n];
+  }
+
+  /**
+   * Function which writes the script to a stream in a compact binary form, which load reads back.
+   *
+   *@param os The output stream, opened in binary mode.
+   */
+  void TreeDiff::save(std::ostream& os) const
+  {
+    uint64_t count = operations.size();
+    os.write(DIFF_MAGIC, sizeof(DIFF_MAGIC));
+    os.write(reinterpret_cast<const char*>(&count), sizeof(count));
+
+    for (size_t n = 0; n < operations.size(); ++n) {
+      const Operation& op = operations[n];
+      os.put(op.type);
+      writeUint32(os, op.path.size());
+      for (size_t i = 0; i < op.path.size(); ++i) {
+	writeUint32(os, op.path[i]);
+      }
+
+      switch (op.type) {
+	case INSERT_NODE:
+	  writeNode(os, op.node.get());
+	  break;
+	case UPDATE_TEXT:
+	  writeString(os, op.value);
+	  break;
+	case SET_ATTRIBUTE:
+	  writeString(os, op.name);
+	  writeString(os, op.value);
+	  break;
+	case REMOVE_ATTRIBUTE:
+	  writeString(os, op.name);
+	  break;
+	default:
+	  break;
+      }
+    }
+
+    if (!os)
+      throw XMLException("Error while writing edit script");
+  }
+
+  /**
+   * Function which reads a script written by save. The script may come from anywhere: its counts and lengths are checked
+   * against what the stream holds before they are trusted, and subtrees nested deeper than the limit are rejected, as the
+   * Node destructor and write could not walk them.
+   *
+   *@param is The input stream, opened in binary mode.
+   *@param limits Bounds on the subtrees; only maxDepth is used.
+   *@return The edit script.
+   */
+  TreeDiff TreeDiff::load(std::istream& is, const ParseLimits& limits)
+  {
+    ScriptReader reader(is, limits.maxDepth);
+    char magic[8];
+    if (reader.getRemaining() < sizeof(magic))
+      throw XMLException("Not an edit script");
+    reader.readBytes(magic, sizeof(magic));
+    if (memcmp(magic, DIFF_MAGIC, sizeof(magic)) != 0)
+      throw XMLException("Not an edit script");
+
+    /*an operation takes at least its type and path length*/
+    uint64_t count = reader.readUint64();
+    if (count > reader.getRemaining() / (1 + sizeof(uint32_t)))
+      throw XMLException("Truncated edit script");
+
+    TreeDiff script;
+    for (uint64_t n = 0; n < count; ++n) {
+      Operation op;
+      int type = reader.readByte();
+      if (type < INSERT_NODE || type > REMOVE_ATTRIBUTE)
+	throw XMLException("Unknown edit script operation");
+      op.type = static_cast<OperationType>(type);
+
+      uint32_t length = reader.readCount(sizeof(uint32_t));
+      if (length > limits.maxDepth)
+	throw XMLException(getErrorMessage(DEPTH_LIMIT_EXCEEDED));
+      op.path.resize(length);
+      for (size_t i = 0; i < op.path.size(); ++i) {
+	op.path[i] = reader.readUint32();
+      }
+
+      switch (op.type) {
+	case INSERT_NODE:
+	  op.node = reader.readNode();
+	  break;
+	case UPDATE_TEXT:
+	  op.value = reader.readString();
+	  break;
+	case SET_ATTRIBUTE:
+	  op.name = reader.readString();
+	  op.value = reader.readString();
+	  break;
+	case REMOVE_ATTRIBUTE:
+	  op.name = reader.readString();
+	  break;
+	default:
+	  break;
+      }
+      script.operations.push_back(std::move(op));
+    }
+    return script;
+  }
+
+}
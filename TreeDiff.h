@@ -0,0 +1,65 @@
+#ifndef __TREEDIFF_H__
+#define __TREEDIFF_H__
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <istream>
+#include <ostream>
+#include <cstdint>
+#include "ParseLimits.h"
+
+namespace tinyXMLpp {
+
+  class Document;
+  class Node;
+
+  /*Edit script turning one Document into another. Each operation
+    names its node by a path of child indexes starting at the top
+    level of the document, valid at the point the operation is applied,
+    so the operations must be applied in order.*/
+  class TreeDiff {
+
+    public:
+    enum OperationType {
+      INSERT_NODE,		//node is inserted at path
+      DELETE_NODE,		//the node at path is removed with its subtree
+      UPDATE_TEXT,		//text, CDATA or comment at path gets value
+      SET_ATTRIBUTE,		//attribute name of the element at path gets value
+      REMOVE_ATTRIBUTE		//attribute name is removed from the element at path
+    };
+
+    struct Operation {
+      OperationType type;
+      std::vector<uint32_t> path;
+      std::string name;
+      std::string value;
+      std::shared_ptr<const Node> node;	//subtree to insert, copied on each apply
+    };
+
+    private:
+    std::vector<Operation> operations;
+
+    public:
+    /*Compares two documents. Subtrees with the same hash are taken
+      as identical and skipped without being looked into.*/
+    static TreeDiff diff(const Document& from, const Document& to);
+
+    /*Applies the script in place to a document equal to the one it
+      was computed from*/
+    void apply(Document& doc) const;
+
+    bool empty() const;
+    size_t size() const;
+    const Operation& getOperation(size_t n) const;
+
+    /*Compact binary form of the script, to ship it elsewhere. load
+      accepts scripts from untrusted sources; subtrees and paths deeper
+      than limits.maxDepth are rejected.*/
+    void save(std::ostream& os) const;
+    static TreeDiff load(std::istream& is, const ParseLimits& limits = ParseLimits());
+  };
+
+}
+
+#endif
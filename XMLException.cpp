@@ -2,6 +2,16 @@
 
 namespace tinyXMLpp{
 
+  /**
+   * Constructor for the errors found in malformed input.
+   *
+   *@param error The error the parse stopped at.
+   */
+  XMLException::XMLException(const ParseError& error)
+    :runtime_error(describeError(error)),lineNumber(error.line),errorCode(error.code)
+  {
+  }
+
   /*const char* XMLException::what() const
     {
     return message.c_str();
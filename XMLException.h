@@ -5,18 +5,30 @@
 #include <string>
 #include <stdexcept>
 
+#include "ParseError.h"
+
 namespace tinyXMLpp{
 
   class XMLException:public std::runtime_error  {
 
     int lineNumber;
+    ParseErrorCode errorCode;
     //std::string message;
 
     public:
     //virtual const char* what() const throw();
     //XMLException(){};
-    XMLException(std::string message):runtime_error(message) {}
-    XMLException(std::string message, int lineNumber):runtime_error(message),lineNumber(lineNumber){}
+    XMLException(std::string message):runtime_error(message),lineNumber(0),errorCode(PARSE_OK) {}
+    XMLException(std::string message, int lineNumber):runtime_error(message),lineNumber(lineNumber),errorCode(PARSE_OK){}
+
+    /*Thrown for malformed input*/
+    XMLException(const ParseError& error);
+
+    /*0 when not known*/
+    int getLineNumber() const { return lineNumber; }
+
+    /*PARSE_OK unless thrown for malformed input*/
+    ParseErrorCode getErrorCode() const { return errorCode; }
 
   };
 
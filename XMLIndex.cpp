@@ -0,0 +1,256 @@
+#include "XMLIndex.h"
+#include "XMLTokenizer.h"
+#include "XMLException.h"
+#include "GzipStream.h"
+#include "ElementPath.h"
+
+#include <fstream>
+#include <cstring>
+
+namespace tinyXMLpp {
+
+  namespace {
+
+    const char INDEX_MAGIC[8] = { 'T', 'X', 'P', 'P', 'I', 'D', 'X', '1' };
+    const std::streamoff ENTRY_SIZE = sizeof(uint64_t) + sizeof(uint32_t);
+  }
+
+  /**
+   * Function which scans an XML stream once and records the offset and depth of every element at the given path. Subtrees
+   * which cannot hold a match, and the matched elements themselves, are skipped without being tokenized. The input is
+   * read past its byte order mark like the parser reads it, and the offsets count the mark, so they can be seeked to.
+   * UTF-16 input is rejected, since its offsets would not be those of the file.
+   *
+   *@param is The input stream, positioned at the start of the document.
+   *@param elementPath The path of the elements to be indexed.
+   *@return The index.
+   */
+  XMLIndex XMLIndex::build(std::istream& is, const std::string& elementPath)
+  {
+    ElementPath path(elementPath);
+
+    XMLIndex index;
+    index.elementPath = elementPath;
+
+    DecodedInput input(is);
+    if (input.getEncoding() != UTF8)
+      throw XMLException("UTF-16 documents cannot be indexed, since offsets into the transcoded text cannot be seeked to");
+    XMLTokenizer t(input.get());
+    uint32_t depth = 0;
+    TokenType type;
+
+    while ((type = t.getToken()) != ENDOFFILE) {
+
+      if (type == END_TAG) {
+	if (depth == 0)
+	  throw XMLException("Mismatched Tags! Error.. ");
+	--depth;
+      }
+
+      if (type != START_TAG)
+	continue;
+
+      switch (path.match(depth, t.getTagName())) {
+	case ElementPath::FULL_MATCH: {
+	  Entry entry;
+	  entry.offset = input.getMarkLength() + t.getTokenOffset();
+	  entry.depth = depth;
+	  index.entries.push_back(entry);
+	  t.skipElement();
+	  break;
+	}
+	case ElementPath::PARTIAL_MATCH:
+	  ++depth;
+	  break;
+	case ElementPath::NO_MATCH:
+	  t.skipElement();
+	  break;
+      }
+    }
+
+    return index;
+  }
+
+  /**
+   * Function which builds the index of a file and writes it to the sidecar file next to it.
+   *
+   *@param filePath The path to the XML file. It must not be compressed, since offsets into compressed data cannot be seeked to.
+   *@param elementPath The path of the elements to be indexed.
+   *@return The index.
+   */
+  XMLIndex XMLIndex::createSidecar(const std::string& filePath, const std::string& elementPath)
+  {
+    std::ifstream file(filePath.c_str(), std::ios::binary);
+    if (!file)
+      throw XMLException("Unable to open XML file " + filePath);
+    if (GzipInputBuffer::isCompressed(file))
+      throw XMLException("Compressed files cannot be indexed: " + filePath);
+
+    XMLIndex index = build(file, elementPath);
+    index.save(getSidecarPath(filePath));
+    return index;
+  }
+
+  /**
+   * Function which returns the path of the index file kept next to an XML file.
+   *
+   *@param filePath The path to the XML file.
+   *@return The path of its index file.
+   */
+  std::string XMLIndex::getSidecarPath(const std::string& filePath)
+  {
+    return filePath + ".idx";
+  }
+
+  /**
+   * Function which writes the index to a file.
+   *
+   *@param indexPath The path of the index file.
+   */
+  void XMLIndex::save(const std::string& indexPath) const
+  {
+    std::ofstream file(indexPath.c_str(), std::ios::binary);
+    if (!file)
+      throw XMLException("Unable to open index file " + indexPath);
+
+    uint64_t count = entries.size();
+    uint32_t pathLength = elementPath.size();
+    file.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    file.write(reinterpret_cast<const char*>(&pathLength), sizeof(pathLength));
+    file.write(elementPath.data(), pathLength);
+
+    /*entries are written field by field, so the file has no padding*/
+    for (size_t i = 0; i < entries.size(); ++i) {
+      file.write(reinterpret_cast<const char*>(&entries[i].offset), sizeof(entries[i].offset));
+      file.write(reinterpret_cast<const char*>(&entries[i].depth), sizeof(entries[i].depth));
+    }
+
+    if (!file)
+      throw XMLException("Error while writing index file " + indexPath);
+  }
+
+  namespace {
+    /*Number of bytes between the current position of the stream and its end*/
+    uint64_t remainingBytes(std::istream& file)
+    {
+      std::streampos here = file.tellg();
+      file.seekg(0, std::ios::end);
+      std::streampos end = file.tellg();
+      file.seekg(here);
+      return end > here ? uint64_t(end - here) : 0;
+    }
+
+    /*Reads and checks the header of an index file, leaving the stream at the first entry. The sizes in the header are
+      checked against the size of the file, so a corrupt header cannot make the reader allocate more than the file holds.*/
+    uint64_t readHeader(std::istream& file, const std::string& indexPath, std::string& elementPath)
+    {
+      char magic[8];
+      uint64_t count;
+      uint32_t pathLength;
+
+      file.read(magic, sizeof(magic));
+      if (!file || memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0)
+	throw XMLException("Not an XML index file: " + indexPath);
+
+      file.read(reinterpret_cast<char*>(&count), sizeof(count));
+      file.read(reinterpret_cast<char*>(&pathLength), sizeof(pathLength));
+      if (!file || pathLength > remainingBytes(file))
+	throw XMLException("Truncated index file " + indexPath);
+
+      elementPath.resize(pathLength);
+      if (pathLength > 0)
+	file.read(&elementPath[0], pathLength);
+      if (!file || count > remainingBytes(file) / ENTRY_SIZE)
+	throw XMLException("Truncated index file " + indexPath);
+      return count;
+    }
+  }
+
+  /**
+   * Function which reads a whole index file.
+   *
+   *@param indexPath The path of the index file.
+   *@return The index.
+   */
+  XMLIndex XMLIndex::load(const std::string& indexPath)
+  {
+    std::ifstream file(indexPath.c_str(), std::ios::binary);
+    if (!file)
+      throw XMLException("Unable to open index file " + indexPath);
+
+    XMLIndex index;
+    uint64_t count = readHeader(file, indexPath, index.elementPath);
+
+    index.entries.resize(count);
+    for (uint64_t i = 0; i < count; ++i) {
+      file.read(reinterpret_cast<char*>(&index.entries[i].offset), sizeof(uint64_t));
+      file.read(reinterpret_cast<char*>(&index.entries[i].depth), sizeof(uint32_t));
+    }
+    if (!file)
+      throw XMLException("Truncated index file " + indexPath);
+
+    return index;
+  }
+
+  /**
+   * Function which reads the nth entry of an index file, without loading the others.
+   *
+   *@param indexPath The path of the index file.
+   *@param n The number of the entry.
+   *@return The entry.
+   */
+  XMLIndex::Entry XMLIndex::readEntry(const std::string& indexPath, uint64_t n)
+  {
+    std::ifstream file(indexPath.c_str(), std::ios::binary);
+    if (!file)
+      throw XMLException("Unable to open index file " + indexPath);
+
+    std::string elementPath;
+    uint64_t count = readHeader(file, indexPath, elementPath);
+    if (n >= count)
+      throw XMLException("Index entry out of range");
+
+    Entry entry;
+    file.seekg(n * ENTRY_SIZE, std::ios::cur);
+    file.read(reinterpret_cast<char*>(&entry.offset), sizeof(entry.offset));
+    file.read(reinterpret_cast<char*>(&entry.depth), sizeof(entry.depth));
+    if (!file)
+      throw XMLException("Truncated index file " + indexPath);
+    return entry;
+  }
+
+  /**
+   * Function which returns the path the index was built for.
+   *
+   *@return The element path.
+   */
+  const std::string& XMLIndex::getElementPath() const
+  {
+    return elementPath;
+  }
+
+  /**
+   * Function which returns the number of indexed elements.
+   *
+   *@return The number of entries.
+   */
+  size_t XMLIndex::size() const
+  {
+    return entries.size();
+  }
+
+  /**
+   * Function which returns an entry of the index.
+   *
+   *@param n The number of the entry.
+   *@return The entry.
+   */
+  const XMLIndex::Entry& XMLIndex::getEntry(size_t n) const
+  {
+    if (n >= entries.size())
+      throw XMLException("Index entry out of range");
+    return entries[n];
+  }
+
+}
@@ -0,0 +1,56 @@
+#ifndef __XMLINDEX_H__
+#define __XMLINDEX_H__
+
+#include <string>
+#include <vector>
+#include <istream>
+#include <cstdint>
+
+namespace tinyXMLpp {
+
+  /*Byte offsets of the elements found at a path inside a large XML
+    file. Together with Parser::parseElementAt it gives random access
+    to any of them without tokenizing what comes before.
+
+    The path is an ElementPath, like "catalog/book" or "//book".
+    Elements nested inside a matched element are not indexed.
+
+    On disk the index is kept next to the file, as filePath + ".idx":
+      "TXPPIDX1" | uint64 count | uint32 path length | path | Entry[]
+    Entries are 12 bytes each, so entry n is read with a single seek.*/
+  class XMLIndex {
+
+    public:
+    struct Entry {
+      uint64_t offset;		//offset of the '<' of the start tag
+      uint32_t depth;		//number of ancestor elements
+    };
+
+    private:
+    std::string elementPath;
+    std::vector<Entry> entries;
+
+    public:
+    XMLIndex() {}
+
+    /*Scans a stream once, collecting the elements at elementPath*/
+    static XMLIndex build(std::istream& is, const std::string& elementPath);
+
+    /*Builds the index of a file and stores it in the sidecar file*/
+    static XMLIndex createSidecar(const std::string& filePath, const std::string& elementPath);
+    static std::string getSidecarPath(const std::string& filePath);
+
+    void save(const std::string& indexPath) const;
+    static XMLIndex load(const std::string& indexPath);
+
+    /*Reads a single entry straight from an index file*/
+    static Entry readEntry(const std::string& indexPath, uint64_t n);
+
+    const std::string& getElementPath() const;
+    size_t size() const;
+    const Entry& getEntry(size_t n) const;
+  };
+
+}
+
+#endif
@@ -1,6 +1,10 @@
 #include "XMLTokenizer.h"
 #include "XMLException.h"
 
+#include <limits>
+#include <algorithm>
+#include <cstring>
+
 namespace tinyXMLpp{
 
   /**
@@ -10,7 +14,7 @@ namespace tinyXMLpp{
    */
   int XMLTokenizer::peekChar()
   {
-    return inputStream.good()?inputStream.peek():-1;
+    return inputStream->good()?inputStream->peek():-1;
   }
 
 
@@ -21,7 +25,7 @@ namespace tinyXMLpp{
   void XMLTokenizer::skipUnimpChars()
   {
     int c;
-    while( ( (c = inputStream.get()) == '\n' || c == ' ' || c == '\t' ) && inputStream.good() );
+    while( ( (c = getChar()) == '\n' || c == ' ' || c == '\t' ) && inputStream->good() );
 
     pushBack(c);		
   }
@@ -38,7 +42,7 @@ namespace tinyXMLpp{
       skipUnimpChars();
     }
 
-    return inputStream.good()?inputStream.get():-1;
+    return inputStream->good()?getChar():-1;
   }
 
   /**
@@ -46,7 +50,7 @@ namespace tinyXMLpp{
    *
    *@return The comment Text
    */
-  std::string XMLTokenizer::getComment()
+  const std::string& XMLTokenizer::getComment() const
   {
     return this->text;
   }
@@ -56,7 +60,7 @@ namespace tinyXMLpp{
    *
    *@return The tag name of the XML element
    */
-  std::string XMLTokenizer::getTagName()
+  const std::string& XMLTokenizer::getTagName() const
   {
     return this->tagName;
   }
@@ -66,7 +70,7 @@ namespace tinyXMLpp{
    *
    *@return The XML text
    */
-  std::string XMLTokenizer::getText()
+  const std::string& XMLTokenizer::getText() const
   {
     return this->text;
   }
@@ -76,50 +80,54 @@ namespace tinyXMLpp{
    *
    *@return The XML CDATA
    */
-  std::string XMLTokenizer::getCDATA()
+  const std::string& XMLTokenizer::getCDATA() const
   {
     return this->text;
   }
 
   /**
-   * Function which returns the Attribute Value for the given attribute name
+   * Function which returns the Attribute Value for the given attribute name. Throws XMLException if the current tag has
+   * no such attribute.
    *
    *@param The attribute name whose value is returned
    *@return The attribute value whose name was given
    */
-  std::string XMLTokenizer::getAttributeValue(const std::string& attrName)
+  const std::string& XMLTokenizer::getAttributeValue(const std::string& attrName) const
   {
 
-    for(int i=0; i < this->attrVals.size() ; ++i){
+    for(int i=0; i < this->attrCount ; ++i){
       if(attrNames[i] == attrName){
 	return attrVals[i];
-	break;
       }
     }
 
-    return nullptr;
+    throw XMLException("No attribute named " + attrName + " in tag " + this->tagName);
   }
 
   /**
-   * Function which returns the Attribute Name for the given attribute index
+   * Function which returns the Attribute Name for the given attribute index. Throws XMLException if the index is out of range.
    *
    *@param The attribute index whose name is returned
    *@return The attribute name whose index was given
    */
-  std::string XMLTokenizer::getAttributeName(int idx)
+  const std::string& XMLTokenizer::getAttributeName(int idx) const
   {
-    return (attrNames.size() > idx) ? attrNames[idx]:nullptr;
+    if(idx < 0 || idx >= attrCount)
+      throw XMLException("Attribute index out of range in tag " + this->tagName);
+    return attrNames[idx];
   }
 
   /**
-   * Function which returns the Attribute Value for the given attribute index
+   * Function which returns the Attribute Value for the given attribute index. Throws XMLException if the index is out of range.
    *
    *@param The attribute index whose value is returned
    *@return The attribute value whose index was given
    */
-  std::string XMLTokenizer::getAttributeValue(int idx)
+  const std::string& XMLTokenizer::getAttributeValue(int idx) const
   {
-    return (attrVals.size() > idx) ? attrVals[idx]:nullptr;
+    if(idx < 0 || idx >= attrCount)
+      throw XMLException("Attribute index out of range in tag " + this->tagName);
+    return attrVals[idx];
   }
 
 
@@ -131,9 +139,241 @@ namespace tinyXMLpp{
   void XMLTokenizer::reset()
   {
     this->hasEndTag = false;
-    this->text = "";
-    this->attrNames.clear();
-    this->attrVals.clear();		
+    this->text.clear();
+    this->attrCount = 0;
+  }
+
+  /**
+   * Function which points the tokenizer at a new input stream and returns it to its initial state. The strings used for
+   * the token values keep the memory they grew to, so a tokenizer reused for many inputs stops allocating once warm.
+   *
+   *@param input The input stream to be tokenized.
+   */
+  void XMLTokenizer::setInput(std::istream& input)
+  {
+    reset();
+    this->inputStream = &input;
+    this->tokenType = BOF;
+    this->position = this->tokenStart = 0;
+    this->validatedTo = 0;
+    this->utf8.reset();
+    this->tagName.clear();
+    this->namespaces.clear();
+    this->popScope = false;
+    this->namespaceId = NamespaceTable::NO_NAMESPACE;
+    this->error = ParseError();
+    this->line = this->tokenLine = 1;
+    this->lineStart = this->previousLineStart = this->tokenLineStart = 0;
+  }
+
+  /**
+   * Function which chooses how malformed input is reported. Not throwing saves the cost of unwinding and building a
+   * message for input that is often malformed; the error is then read from getError once getToken returns ENDOFFILE.
+   *
+   *@param throwOnError true to throw XMLException, false to record the error and stop.
+   */
+  void XMLTokenizer::setThrowOnError(bool throwOnError)
+  {
+    this->throwOnError = throwOnError;
+  }
+
+  /**
+   * Function which returns the first error found in the input since it was set.
+   *
+   *@return The error, with the code PARSE_OK if there was none.
+   */
+  const ParseError& XMLTokenizer::getError() const
+  {
+    return error;
+  }
+
+  /**
+   * Function which records an error in the input. Only the first error is kept. Unless the tokenizer throws, the input
+   * stream is put in the failed state, so every read after the error sees the end of the input and the token being parsed
+   * is given up without any further checks.
+   *
+   *@param code What is wrong with the input.
+   *@param offset The byte offset at which it was found.
+   *@return false, so a caller can return it.
+   */
+  bool XMLTokenizer::setError(ParseErrorCode code, std::streamoff offset)
+  {
+    if(this->error.code == PARSE_OK){
+      /*whatever the early end of the input looked like, its cause was invalid UTF-16*/
+      if(inputInvalid())
+	code = INVALID_UTF16;
+      this->error = ParseError(code, offset);
+      locateError();
+    }
+
+    if(this->throwOnError)
+      throw XMLException(this->error);
+
+    inputStream->setstate(std::ios::failbit);
+    this->tokenType = ENDOFFILE;
+    return false;
+  }
+
+  /**
+   * Function which records an error found at the current position of the input.
+   *
+   *@param code What is wrong with the input.
+   *@return false.
+   */
+  bool XMLTokenizer::fail(ParseErrorCode code)
+  {
+    return setError(code, this->position);
+  }
+
+  /**
+   * Function which tells whether the input is transcoded UTF-16 that stopped at an invalid sequence, see DecodedInput.
+   *
+   *@return true if the input ended before its real end.
+   */
+  bool XMLTokenizer::inputInvalid() const
+  {
+    const Utf16InputBuffer* utf16 = dynamic_cast<const Utf16InputBuffer*>(inputStream->rdbuf());
+    return utf16 != nullptr && utf16->hasError();
+  }
+
+  /**
+   * Function which finds the line and column of the error from the newlines counted as the input was consumed, so the
+   * input is never read again. Errors are found at the current position or at the start of the current token; for any
+   * other offset before the current line, the line and column stay 0.
+   */
+  void XMLTokenizer::locateError()
+  {
+    if(error.offset >= this->lineStart){
+      error.line = this->line;
+      error.column = error.offset - this->lineStart + 1;
+    }
+    else if(error.offset == this->tokenStart){
+      error.line = this->tokenLine;
+      error.column = error.offset - this->tokenLineStart + 1;
+    }
+  }
+
+  /**
+   * Function which turns the UTF-8 validation of the input on or off.
+   *
+   *@param validate Whether bytes read from the input should be checked to be well formed UTF-8.
+   */
+  void XMLTokenizer::setValidateUTF8(bool validate)
+  {
+    this->validateUTF8 = validate;
+    this->utf8.reset();
+    this->validatedTo = this->position;
+  }
+
+  /**
+   * Function which chooses the tokenizer features to leave out. Each flag is tested once per token, so the work a skipped
+   * feature does for every character of the input is not done at all.
+   *
+   *@param flags The ParseFlags or'ed together, PARSE_DEFAULT for all features.
+   */
+  void XMLTokenizer::setFlags(unsigned flags)
+  {
+    this->flags = flags;
+    setValidateUTF8(!(flags & PARSE_NO_VALIDATION));
+  }
+
+  /**
+   * Function which returns the tokenizer features left out.
+   *
+   *@return The ParseFlags or'ed together.
+   */
+  unsigned XMLTokenizer::getFlags() const
+  {
+    return flags;
+  }
+
+  /**
+   * Function which sets the bounds on the sizes of names, text and attribute lists. A token that grows past one of them is
+   * an error, found as soon as the limit is passed, before more memory is taken.
+   *
+   *@param limits The limits; the depth and node count are not checked by the tokenizer.
+   */
+  void XMLTokenizer::setLimits(const ParseLimits& limits)
+  {
+    this->limits = limits;
+    this->namespaces.setMaxURIs(limits.maxNamespaces);
+  }
+
+  /**
+   * Function which drops the namespace bindings collected from the input. setInput does this too, but a tokenizer kept
+   * for later inputs would otherwise keep the URIs of the last one in the NamespaceTable until then.
+   */
+  void XMLTokenizer::releaseNamespaces()
+  {
+    this->namespaces.clear();
+    this->popScope = false;
+    this->namespaceId = NamespaceTable::NO_NAMESPACE;
+  }
+
+  /**
+   * Function which turns namespace processing on or off. The bindings collected so far are dropped, so it should be called
+   * before tokenizing starts.
+   *
+   *@param aware Whether prefixes should be resolved to namespaces.
+   */
+  void XMLTokenizer::setNamespaceAware(bool aware)
+  {
+    this->namespaceAware = aware;
+    this->namespaces.clear();
+    this->popScope = false;
+    this->namespaceId = NamespaceTable::NO_NAMESPACE;
+  }
+
+  /**
+   * Function which returns the namespace the current start tag is in.
+   *
+   *@return The namespace id of the element.
+   */
+  uint32_t XMLTokenizer::getNamespaceId() const
+  {
+    return namespaceId;
+  }
+
+  /**
+   * Function which returns the namespace of an attribute of the current start tag.
+   *
+   *@param idx The index of the attribute.
+   *@return The namespace id of the attribute.
+   */
+  uint32_t XMLTokenizer::getAttributeNamespaceId(int idx) const
+  {
+    if(idx < 0 || idx >= attrCount)
+      throw XMLException("Attribute index out of range");
+    return namespaceAware ? attrNamespaces[idx] : NamespaceTable::NO_NAMESPACE;
+  }
+
+  /**
+   * Function which opens the namespace scope of the start tag just read. The xmlns attributes are bound first, since they
+   * apply to the tag they are declared on, then the tag and its attributes are resolved.
+   *
+   *@return false if a declaration is invalid or a prefix is not bound.
+   */
+  bool XMLTokenizer::resolveNamespaces()
+  {
+    namespaces.push();
+    for(int i = 0; i < attrCount; ++i){
+      ParseErrorCode code = namespaces.declare(attrNames[i], attrVals[i]);
+      if(code != PARSE_OK)
+	return fail(code);
+    }
+
+    namespaceId = namespaces.resolveElement(tagName);
+    if(namespaceId == NamespaceTable::INVALID_NAMESPACE)
+      return fail(UNBOUND_PREFIX);
+
+    if(attrNamespaces.size() < attrNames.size())
+      attrNamespaces.resize(attrNames.size());
+    for(int i = 0; i < attrCount; ++i){
+      attrNamespaces[i] = namespaces.resolveAttribute(attrNames[i]);
+      if(attrNamespaces[i] == NamespaceTable::INVALID_NAMESPACE)
+	return fail(UNBOUND_PREFIX);
+    }
+    return true;
   }
 
   /**
@@ -141,9 +381,55 @@ namespace tinyXMLpp{
    *	
    *@return The number of attributes.
    */
-  int XMLTokenizer::getAttributeCount()
+  int XMLTokenizer::getAttributeCount() const
+  {
+    return attrCount;
+  }
+
+  /**
+   * Function which returns the byte offset at which the current token starts, counted from where the tokenizer started
+   * reading its input. For a start tag this is the offset of its '<'.
+   *
+   *@return The byte offset of the start of the current token.
+   */
+  std::streamoff XMLTokenizer::getTokenOffset() const
+  {
+    return tokenStart;
+  }
+
+  /**
+   * Function which returns the number of bytes consumed so far, which is also the offset just past the current token.
+   *
+   *@return The byte offset of the next unread character.
+   */
+  std::streamoff XMLTokenizer::getOffset() const
+  {
+    return position;
+  }
+
+  /**
+   * Function which returns the byte offset at which the content of the current text, CDATA or comment token starts. The
+   * content is copied byte for byte from the input, so it can also be read from there.
+   *
+   *@return The byte offset of the first byte of the content.
+   */
+  std::streamoff XMLTokenizer::getTextOffset() const
+  {
+    return textStart;
+  }
+
+  /**
+   * Function which returns the byte offset at which the value of an attribute of the current start tag starts, right after
+   * its opening quote. Throws XMLException if the index is out of range.
+   *
+   *@param idx The attribute index.
+   *@return The byte offset of the first byte of the value.
+   */
+  std::streamoff XMLTokenizer::getAttributeValueOffset(int idx) const
   {
-    return attrNames.size();
+    if(idx < 0 || idx >= attrCount)
+      throw XMLException("Attribute index out of range in tag " + this->tagName);
+    return attrValStarts[idx];
   }
 
   /**
@@ -154,15 +440,50 @@ namespace tinyXMLpp{
   {
     reset();
 
-    /*read all chars till '<' or EOF*/
     int c;
+    if(this->flags & PARSE_NO_TEXT){
+      /*the '<' is only peeked at, the next token starts with it*/
+      while( ((c = peekChar()) != -1) && c != '<' )
+	readChar(false);
+      if(c == -1 && this->validateUTF8 && !this->utf8.isComplete()){
+	fail(INVALID_UTF8);
+	return;
+      }
+      this->tokenType = (c == -1) ? ENDOFFILE : TEXT;
+      this->skipped = (c != -1);
+      return;
+    }
+
+    if(this->flags & PARSE_TRIM_WHITESPACE){
+      while( (c = peekChar()) == ' ' || c == '\t' || c == '\r' || c == '\n' )
+	readChar(false);
+    }
+    this->textStart = this->position;
+
+    /*read all chars till '<' or EOF*/
+    bool validate = !(this->flags & PARSE_NO_VALIDATION);
     while( ((c = peekChar()) != -1) && c != '<' ){
-      if(c == '<' || c== '&')
-	throw XMLException("Invalid Characters found in XML " + c);
+      if(c == '&' && validate){
+	fail(INVALID_TEXT);
+	return;
+      }
+      if(this->text.size() >= limits.maxTextLength){
+	fail(TEXT_LIMIT_EXCEEDED);
+	return;
+      }
       this->text += (char)c;
       readChar(false);
     }
 
+    /*peeking finds the end of the input without going through getChar*/
+    if(c == -1 && this->validateUTF8 && !this->utf8.isComplete()){
+      fail(INVALID_UTF8);
+      return;
+    }
+
+    if(this->flags & PARSE_TRIM_WHITESPACE)
+      this->text.erase(this->text.find_last_not_of(" \t\r\n") + 1);
+
     if(c == -1 && this->text.length() == 0)
       this->tokenType = ENDOFFILE;
     else
@@ -178,14 +499,9 @@ namespace tinyXMLpp{
   {
 
     int c;
-    std::string attrName;
-    std::string attrValue;
 
     while(true){
 
-      attrName = "";
-      attrValue = "";
-
       /*eat whitespace characters before attrName*/
       c = readChar(true);				
 
@@ -194,16 +510,34 @@ namespace tinyXMLpp{
 	return false;
       else if( c == '/' && readChar(false) == '>')
 	return true;
-      else if( !isalnum(c) ) 
-	throw XMLException("Non alpha-numeric characters found in attribute name" + attrName);
-
-      while( isalnum(c) ){						
+      else if( c == -1 )
+	return fail(UNEXPECTED_EOF);
+      else if( !isNameByte(c) ) 
+	return fail(INVALID_NAME);
+
+      if((size_t)attrCount >= limits.maxAttributes)
+	return fail(ATTRIBUTE_LIMIT_EXCEEDED);
+
+      /*reuse the slot of an earlier tag if there is one*/
+      if((size_t)attrCount == attrNames.size()){
+	attrNames.push_back(std::string());
+	attrVals.push_back(std::string());
+	attrValStarts.push_back(0);
+      }
+      std::string& attrName = attrNames[attrCount];
+      std::string& attrValue = attrVals[attrCount];
+      attrName.clear();
+      attrValue.clear();
+
+      while( isNameByte(c) ){						
+	if(attrName.size() >= limits.maxNameLength)
+	  return fail(NAME_LIMIT_EXCEEDED);
 	attrName += c;
 	c = readChar(false);
       }			
 
-      if(attrName.length() == 0)
-	throw XMLException("Attribute name missing for tag" + this->tagName);
+      if(!(this->flags & PARSE_NO_VALIDATION) && !isValidName(attrName))
+	return fail(INVALID_NAME);
 
       /*eat whitespace*/
       if( c != '='){				
@@ -216,16 +550,23 @@ namespace tinyXMLpp{
 	c = readChar(true);
 
 	if( c != '"' && c != '\'') 
-	  throw XMLException("Unexpected character found while looking for attribute value for " + attrName);
-	while(  ( c = readChar(false) ) != '\'' && c != '"' ){
+	  return fail(c == -1 ? UNEXPECTED_EOF : MISSING_ATTRIBUTE_VALUE);
+
+	/*the value ends at the same kind of quote it started with*/
+	int quote = c;
+	attrValStarts[attrCount] = this->position;
+	while(  ( c = readChar(false) ) != quote ){
+	  if(c == -1)
+	    return fail(UNEXPECTED_EOF);
+	  if(attrValue.size() >= limits.maxTextLength)
+	    return fail(TEXT_LIMIT_EXCEEDED);
 	  attrValue += c;
 	}
 
       }else
-	throw XMLException("Expected '=' after" + attrName +".But found illegal character");
+	return fail(c == -1 ? UNEXPECTED_EOF : MISSING_ATTRIBUTE_VALUE);
 
-      this->attrNames.push_back(attrName);
-      this->attrVals.push_back(attrValue);
+      ++attrCount;
 
     }
 
@@ -247,10 +588,12 @@ namespace tinyXMLpp{
       return;
     }
 
-    if(c != '<') 
-      throw XMLException("Unexpected character while parsing start tag.");
+    if(c != '<'){
+      fail(INVALID_CHARACTER);
+      return;
+    }
 
-    this->tagName = "";
+    this->tagName.clear();
     while(	(c = peekChar() ) != ' ' && 
 	c != '\t' &&
 	c != '>'  && 
@@ -258,18 +601,27 @@ namespace tinyXMLpp{
 	c != -1   &&
 	c != '\n'
 	){
-      if(isalnum(c))
-	this->tagName += c;
-      else
-	throw XMLException("Non alpha-numeric characters found in the tagname:" + this->tagName);
+      if(!isNameByte(c)){
+	fail(INVALID_NAME);
+	return;
+      }
+      if(this->tagName.size() >= limits.maxNameLength){
+	fail(NAME_LIMIT_EXCEEDED);
+	return;
+      }
+      this->tagName += c;
 
       readChar(false);
     }
 
-    if(this->tagName.length() == 0)
-      throw XMLException("Tag name missing while parsing");
-    else if(c == -1)
-      throw XMLException("Unexpected EOF while parsing start tag " + this->tagName + ".");
+    if(c == -1){
+      fail(UNEXPECTED_EOF);
+      return;
+    }
+    else if(!(this->flags & PARSE_NO_VALIDATION) && !isValidName(this->tagName)){
+      fail(INVALID_NAME);
+      return;
+    }
 
     /*skip unimportant characters after the tag name*/
     c = readChar(true);
@@ -280,14 +632,20 @@ namespace tinyXMLpp{
       if((c = readChar(false)) == '>'){
 	this->hasEndTag = true;
 	this->tokenType = START_TAG;
-      }else
-	throw XMLException("Tag" + this->tagName + "has invalid characters");
+      }else{
+	fail(c == -1 ? UNEXPECTED_EOF : INVALID_CHARACTER);
+	return;
+      }
     }else{		
       pushBack(c);
       this->hasEndTag = parseAttributes();
+      if(this->error.code != PARSE_OK)
+	return;
       this->tokenType = START_TAG;
     }
 
+    if(this->namespaceAware)
+      resolveNamespaces();
   }
 
   /**
@@ -297,7 +655,46 @@ namespace tinyXMLpp{
    */
   void XMLTokenizer::pushBack(int c)
   {
-    inputStream.putback(c);
+    if(c == -1)
+      return;
+
+    inputStream->putback(c);
+    if(!inputStream->fail()){
+      --position;
+      if(c == '\n'){
+	--line;
+	lineStart = previousLineStart;
+      }
+    }
+  }
+
+  /**
+   * Function which removes the next character from the input stream, keeping count of the bytes consumed. Bytes read for
+   * the first time are fed to the UTF-8 validator; characters pushed back and read again are not checked twice.
+   *
+   *@return The next character from the input stream, or -1 at the end of the input or after an error.
+   */
+  int XMLTokenizer::getChar()
+  {
+    int c = inputStream->get();
+    if(c != -1){
+      ++position;
+      if(c == '\n'){
+	++line;
+	previousLineStart = lineStart;
+	lineStart = position;
+      }
+      if(validateUTF8 && position > validatedTo){
+	validatedTo = position;
+	if(!utf8.add(c)){
+	  fail(INVALID_UTF8);
+	  return -1;
+	}
+      }
+    }
+    else if(validateUTF8 && !utf8.isComplete() && this->error.code == PARSE_OK)
+      fail(INVALID_UTF8);
+    return c;
   }
 
   /**
@@ -314,23 +711,32 @@ namespace tinyXMLpp{
       return;
     }
 
-    if(c != '<' || (c=readChar(false) != '/')) 
-      throw XMLException("XML malformed. Invalid characters while parsing the end tag");
+    if(c != '<' || (c=readChar(false) != '/')){
+      fail(INVALID_CHARACTER);
+      return;
+    }
 
-    this->tagName = "";
+    this->tagName.clear();
     while(true){
 
       c = readChar(false);
-      if(isalnum(c))				
+      if(isNameByte(c)){
+	if(this->tagName.size() >= limits.maxNameLength){
+	  fail(NAME_LIMIT_EXCEEDED);
+	  return;
+	}
 	this->tagName += c;			
+      }
       else if (c == '>')
 	break;
       else{
 	c = readChar(true);
 	if(c == '>') 
 	  break;
-	else
-	  throw XMLException("XML malformed. Tag " + this->tagName + "not closed");
+	else{
+	  fail(c == -1 ? UNEXPECTED_EOF : INVALID_CHARACTER);
+	  return;
+	}
       }
     }
 
@@ -382,6 +788,13 @@ namespace tinyXMLpp{
   void XMLTokenizer::parseCDATA()
   {
     reset();
+    this->textStart = this->position;
+
+    if(this->flags & PARSE_SKIP_CDATA){
+      this->skipped = skipPast(']', '>');
+      this->tokenType = CDATA;
+      return;
+    }
 
     /*read until ]]>*/
     int c;
@@ -391,6 +804,10 @@ namespace tinyXMLpp{
 	break;
       }
 
+      if(this->text.size() >= limits.maxTextLength){
+	fail(TEXT_LIMIT_EXCEEDED);
+	return;
+      }
       this->text += c;
       readChar(false);
     }
@@ -399,7 +816,7 @@ namespace tinyXMLpp{
     if( c != -1)
       this->tokenType = CDATA;
     else
-      throw XMLException("Unexpected EOF while parsing CDATA " + this->text);
+      fail(UNEXPECTED_EOF);
   }
 
   /**
@@ -409,6 +826,13 @@ namespace tinyXMLpp{
   void XMLTokenizer::parseComment()
   {
     reset();
+    this->textStart = this->position;
+
+    if(this->flags & PARSE_SKIP_COMMENTS){
+      this->skipped = skipPast('-', '>');
+      this->tokenType = COMMENT;
+      return;
+    }
 
     /*read until -->*/
     int c;
@@ -419,10 +843,16 @@ namespace tinyXMLpp{
 	  //this->text += c;
 	  readChar(false);
 	  break;
-	}else
-	  throw XMLException(" '--' found in XML Comment ");
+	}else{
+	  fail(INVALID_COMMENT);
+	  return;
+	}
       }
 
+      if(this->text.size() >= limits.maxTextLength){
+	fail(TEXT_LIMIT_EXCEEDED);
+	return;
+      }
       this->text += c;
       readChar(false);
     }
@@ -430,20 +860,20 @@ namespace tinyXMLpp{
     if( c != -1)
       this->tokenType = COMMENT;
     else
-      throw XMLException("Unexpected EOF while parsing comment " + this->text);
+      fail(UNEXPECTED_EOF);
   }
 
   /**
-   * Function which returns the next token type from the input stream. Simulates a state machine.
-   * The value of the token is exposed through the various member functions.
+   * Function which reads the token that follows the current one. Simulates a state machine: the type of the current token
+   * tells what may come next. The value of the token is exposed through the various member functions.
    */
-  TokenType XMLTokenizer::getToken() 
+  void XMLTokenizer::nextToken()
   {
     /*Comment can be 'next state' of any state*/
     if(tryMatch("<!--"))
     {
       parseComment();
-      return this->tokenType;
+      return;
     }
 
     /*switch on the current state (token type)*/
@@ -515,9 +945,195 @@ namespace tinyXMLpp{
 	throw XMLException("Unrecognized token(s) in the XML");
 
     }
+  }
+
+  /**
+   * Function which returns the next token type from the input stream. Tokens the flags ask to skip are stepped over here,
+   * one after the other, without being returned.
+   */
+  TokenType XMLTokenizer::getToken() 
+  {
+    if(this->error.code != PARSE_OK)
+      return ENDOFFILE;
+
+    /*the bindings of an element stay visible until its end tag has been handed out*/
+    if(this->popScope){
+      this->namespaces.pop();
+      this->popScope = false;
+    }
+
+    do{
+      this->tokenStart = this->position;
+      this->tokenLine = this->line;
+      this->tokenLineStart = this->lineStart;
+      this->skipped = false;
+      nextToken();
+    }while(this->skipped && this->error.code == PARSE_OK);
+
+    if(this->tokenType == ENDOFFILE && this->error.code == PARSE_OK && inputInvalid())
+      setError(INVALID_UTF16, this->position);
+
+    if(this->error.code != PARSE_OK)
+      this->tokenType = ENDOFFILE;
+    else if(this->tokenType == END_TAG && this->namespaceAware)
+      this->popScope = true;
 
     /*return the token type.*/
     return this->tokenType;
   }
 
+  /**
+   * Function which tells whether the next token is the END_TAG of a self closing element, which getToken returns without
+   * reading the input.
+   *
+   *@return true right after a start tag like <a/>.
+   */
+  bool XMLTokenizer::hasPendingEndTag() const
+  {
+    return this->tokenType == START_TAG && this->hasEndTag && this->error.code == PARSE_OK;
+  }
+
+  /**
+   * Function which skips characters up to and including the first occurrence of a single delimiter. The characters are
+   * taken a block at a time, only to count the newlines among them.
+   *
+   *@param last The delimiter.
+   *@return false if the input ended first.
+   */
+  bool XMLTokenizer::skipPast(char last)
+  {
+    char block[4096];
+    while(inputStream->good()){
+      inputStream->get(block, sizeof(block), last);
+      std::streamsize n = inputStream->gcount();
+      for(const char* p = block; (p = static_cast<const char*>(memchr(p, '\n', block + n - p))) != nullptr; ++p){
+	++line;
+	lineStart = position + (p - block) + 1;
+      }
+      position += n;
+
+      if(inputStream->eof())
+	break;
+      /*get fails when the delimiter comes first, the stream was good before*/
+      if(n == 0)
+	inputStream->clear();
+      if(inputStream->peek() == (unsigned char)last){
+	inputStream->get();
+	++position;
+	break;
+      }
+    }
+
+    /*skipped bytes are not validated, the delimiter always ends a character*/
+    utf8.reset();
+    validatedTo = position;
+    if(!inputStream->good())
+      return fail(UNEXPECTED_EOF);
+    return true;
+  }
+
+  /**
+   * Function which skips characters up to and including the first occurrence of a terminator made of a character given
+   * at least a number of times followed by another one, like "-->", "]]>" or the "?>" of a processing instruction.
+   *
+   *@param repeated The character that starts the terminator.
+   *@param last The character that ends the terminator.
+   *@param times How many times at least repeated comes before last.
+   *@return false if the input ended first.
+   */
+  bool XMLTokenizer::skipPast(char repeated, char last, int times)
+  {
+    int run = 0;
+    while(true){
+      if(run == 0){
+	if(!skipPast(repeated))
+	  return false;
+	run = 1;
+	continue;
+      }
+
+      int c = getChar();
+      if(c == -1)
+	return fail(UNEXPECTED_EOF);
+
+      if(c == repeated)
+	++run;
+      else if(c == last && run >= times)
+	return true;
+      else
+	run = 0;
+    }
+  }
+
+  /**
+   * Function which skips the element whose start tag was just returned by getToken, along with everything inside it. Only
+   * a depth counter is kept: the input is scanned for '<' and each markup construct is stepped over without copying it.
+   * Quoted attribute values are honoured, so a '>' inside them does not end a tag, and processing instructions end at
+   * their "?>" without counting as elements.
+   */
+  void XMLTokenizer::skipElement()
+  {
+    if(this->tokenType != START_TAG)
+      throw XMLException("skipElement can only be called right after a start tag");
+
+    bool selfClosing = this->hasEndTag;
+    reset();
+    this->tokenType = END_TAG;
+    this->popScope = this->namespaceAware;
+
+    /*<tag/> has nothing left to skip*/
+    if(selfClosing)
+      return;
+
+    int depth = 1;
+    bool more = true;
+    while(depth > 0 && more){
+
+      if(!skipPast('<'))
+	return;
+      int c = getChar();
+
+      if(c == '/'){
+	more = skipPast('>');
+	--depth;
+      }
+      else if(c == '!'){
+	c = getChar();
+	if(c == '-')
+	  more = skipPast('-', '>');		//comment
+	else if(c == '[')
+	  more = skipPast(']', '>');		//CDATA section
+	else
+	  more = skipPast('>');
+      }
+      else if(c == '?')
+	more = skipPast('?', '>', 1);		//processing instruction
+      else if(c == -1){
+	fail(UNEXPECTED_EOF);
+	return;
+      }
+      else{
+	/*nested start tag, self closing if the '>' follows a '/'*/
+	int prev = c, quote = 0;
+	while((c = getChar()) != -1){
+	  if(quote){
+	    if(c == quote)
+	      quote = 0;
+	  }
+	  else if(c == '"' || c == '\'')
+	    quote = c;
+	  else if(c == '>')
+	    break;
+	  prev = c;
+	}
+	if(c == -1){
+	  fail(UNEXPECTED_EOF);
+	  return;
+	}
+	if(prev != '/')
+	  ++depth;
+      }
+    }
+  }
+
 }
@@ -5,23 +5,64 @@
 #include <vector>
 #include <fstream>
 
+#include "Encoding.h"
+#include "Namespace.h"
+#include "ParseError.h"
+#include "ParseLimits.h"
+
 namespace tinyXMLpp{
 
   enum TokenType { BOF, START_TAG, END_TAG, TEXT, CDATA, COMMENT, ENDOFFILE };
 
+  /*Tokenizer features a caller can do without, or'ed together for
+    XMLTokenizer::setFlags. Skipped tokens are stepped over without
+    being copied and never returned by getToken.*/
+  enum ParseFlags {
+    PARSE_DEFAULT = 0,
+    PARSE_SKIP_COMMENTS = 1,
+    PARSE_SKIP_CDATA = 2,
+    PARSE_NO_VALIDATION = 4,		//no UTF-8, name or '&' checks
+    PARSE_TRIM_WHITESPACE = 8,		//text is trimmed, whitespace only text is dropped
+    PARSE_NO_TEXT = 16
+  };
+
   class XMLTokenizer{
 
-    std::istream& inputStream;
+    std::istream* inputStream;
     TokenType tokenType;
     std::string tagName;
-    std::vector<std::string> attrNames;
-    std::vector<std::string> attrVals;
+    std::vector<std::string> attrNames;	//slots are reused between tags, only the
+    std::vector<std::string> attrVals;	//first attrCount entries are valid
+    std::vector<std::streamoff> attrValStarts;
+    int attrCount;
     std::string text;		
+    std::streamoff textStart;		//where the content of a text, CDATA or comment token starts
     bool hasEndTag;
+    std::streamoff position;		//bytes consumed from the input
+    std::streamoff tokenStart;
+    Utf8Validator utf8;
+    bool validateUTF8;
+    std::streamoff validatedTo;		//bytes up to here were already checked
+    NamespaceScope namespaces;
+    bool namespaceAware;
+    bool popScope;			//the last token closed an element, its scope ends before the next one
+    uint32_t namespaceId;
+    std::vector<uint32_t> attrNamespaces;
+    bool throwOnError;
+    ParseError error;			//first error found in the input
+    int line;				//line of the next byte, from 1
+    std::streamoff lineStart;		//offset of the first byte of that line
+    std::streamoff previousLineStart;	//of the line before, for a newline pushed back
+    int tokenLine;			//line and line start where the current token began
+    std::streamoff tokenLineStart;
+    ParseLimits limits;
+    unsigned flags;			//ParseFlags
+    bool skipped;			//the token just read is one the flags skip
 
     void reset();
     int readChar(bool skipWS);
     int peekChar();
+    int getChar();
     bool tryMatch(const std::string& str);
 
     void pushBack(int c);
@@ -32,25 +73,101 @@ namespace tinyXMLpp{
     void parseCDATA();		
     void parseComment();
     void skipUnimpChars();
+    bool skipPast(char repeated, char last, int times = 2);
+    bool skipPast(char last);
+    bool resolveNamespaces();
+    bool fail(ParseErrorCode code);
+    void locateError();
+    bool inputInvalid() const;
+    void nextToken();
 
     public:
     /*Constructor to initialize the Tokenizer*/
+    XMLTokenizer(): 
+      inputStream(nullptr), tokenType(BOF), attrCount(0), textStart(0), hasEndTag(false), position(0), tokenStart(0),
+      validateUTF8(true), validatedTo(0), namespaceAware(true), popScope(false), namespaceId(0),
+      throwOnError(true), line(1), lineStart(0), previousLineStart(0), tokenLine(1), tokenLineStart(0),
+      flags(PARSE_DEFAULT), skipped(false) { };
     XMLTokenizer(std::istream& input): 
-      inputStream(input), tokenType(BOF) { };
+      inputStream(&input), tokenType(BOF), attrCount(0), textStart(0), hasEndTag(false), position(0), tokenStart(0),
+      validateUTF8(true), validatedTo(0), namespaceAware(true), popScope(false), namespaceId(0),
+      throwOnError(true), line(1), lineStart(0), previousLineStart(0), tokenLine(1), tokenLineStart(0),
+      flags(PARSE_DEFAULT), skipped(false) { };
+
+    /*Starts tokenizing a new input stream. The scratch buffers
+      keep their capacity from the previous input.*/
+    void setInput(std::istream& input);
+
+    /*Drops the namespace bindings read from the input, with their
+      references to the NamespaceTable. Called once the nodes built
+      from the tokens hold references of their own.*/
+    void releaseNamespaces();
+
+    /*Turns the UTF-8 check of the input on or off. It is on by
+      default; input known to be valid can skip it.*/
+    void setValidateUTF8(bool validate);
+
+    /*Turns namespace processing on or off. It is on by default: the
+      prefixes of start tags and attributes are resolved against the
+      xmlns declarations in scope, and unbound prefixes are errors.*/
+    void setNamespaceAware(bool aware);
+
+    /*Features to leave out, see ParseFlags. PARSE_NO_VALIDATION
+      also turns the UTF-8 check off.*/
+    void setFlags(unsigned flags);
+    unsigned getFlags() const;
+
+    /*Bounds on names, text and attributes, see ParseLimits*/
+    void setLimits(const ParseLimits& limits);
+
+    /*Malformed input throws XMLException by default. Without throwing,
+      the first error is recorded, the input stream is left failed and
+      getToken returns ENDOFFILE from then on; getError tells that
+      apart from the real end of the input.*/
+    void setThrowOnError(bool throwOnError);
+    const ParseError& getError() const;
+
+    /*Records an error found by the consumer of the tokens, such as
+      mismatched tags, the same way as the tokenizer's own. Returns
+      false when it does not throw.*/
+    bool setError(ParseErrorCode code, std::streamoff offset);
 
     /*returns the token type of the next token from 
       the input stream*/
     TokenType getToken();
 
+    /*Called right after a START_TAG token, skips the rest of the
+      element up to and including its end tag. No token values are
+      built; the tokenizer is left as if the END_TAG had been read.*/
+    void skipElement();
+
     /*Methods which expose the Tokens based on the Token type*/
-    std::string getTagName();
-    std::string getAttributeValue(const std::string& attrName);
-    int getAttributeCount();
-    std::string getAttributeName(int idx);
-    std::string getAttributeValue(int idx);
-    std::string getText();
-    std::string getCDATA();
-    std::string getComment();
+    const std::string& getTagName() const;
+    const std::string& getAttributeValue(const std::string& attrName) const;
+    int getAttributeCount() const;
+    const std::string& getAttributeName(int idx) const;
+    const std::string& getAttributeValue(int idx) const;
+    const std::string& getText() const;
+    const std::string& getCDATA() const;
+    const std::string& getComment() const;
+
+    /*Namespace ids of the current start tag and its attributes, see
+      NamespaceTable. Always NO_NAMESPACE with namespaces off.*/
+    uint32_t getNamespaceId() const;
+    uint32_t getAttributeNamespaceId(int idx) const;
+
+    /*true after a self closing start tag, whose END_TAG comes next
+      without reading any more input*/
+    bool hasPendingEndTag() const;
+
+    /*Byte offsets, counted from where the tokenizer started reading*/
+    std::streamoff getTokenOffset() const;
+    std::streamoff getOffset() const;
+
+    /*Where the values start, without their markup. Each value is the
+      bytes of the input from there on, as many as its length.*/
+    std::streamoff getTextOffset() const;
+    std::streamoff getAttributeValueOffset(int idx) const;
 
   };
 
@@ -0,0 +1,164 @@
+#include "XMLWriter.h"
+#include "XMLException.h"
+
+namespace tinyXMLpp {
+
+  /**
+   * Constructor
+   *
+   *@param os The output stream to which the XML is written.
+   *@param bufferSize The number of bytes gathered before they are written to the stream.
+   */
+  XMLWriter::XMLWriter(std::ostream& os, size_t bufferSize) : os(os), capacity(bufferSize), startTagOpen(false)
+  {
+    buffer.reserve(capacity);
+  }
+
+  /**
+   * Destructor. Whatever is still buffered is written out; errors at this point are ignored, so call flush to see them.
+   */
+  XMLWriter::~XMLWriter()
+  {
+    try {
+      flush();
+    }
+    catch (...) {
+    }
+  }
+
+  /**
+   * Function which adds bytes to the buffer, writing the buffer out first when they do not fit. Pieces larger than the
+   * buffer go straight to the stream.
+   *
+   *@param data The bytes to be written.
+   *@param length The number of bytes.
+   */
+  void XMLWriter::append(const char* data, size_t length)
+  {
+    if (buffer.size() + length > capacity) {
+      flush();
+      if (length > capacity) {
+	os.write(data, length);
+	return;
+      }
+    }
+    buffer.append(data, length);
+  }
+
+  /**
+   * Function which adds a string to the buffer.
+   *
+   *@param str The string to be written.
+   */
+  void XMLWriter::append(const std::string& str)
+  {
+    append(str.data(), str.size());
+  }
+
+  /**
+   * Function which ends the last start tag, if it is still open.
+   */
+  void XMLWriter::closeStartTag()
+  {
+    if (startTagOpen) {
+      append(">", 1);
+      startTagOpen = false;
+    }
+  }
+
+  /**
+   * Function which writes the start of a start tag. Its attributes may be added until anything else is written.
+   *
+   *@param name The name of the element.
+   */
+  void XMLWriter::startElement(const std::string& name)
+  {
+    closeStartTag();
+    append("<", 1);
+    append(name);
+    startTagOpen = true;
+  }
+
+  /**
+   * Function which writes an attribute of the element started last.
+   *
+   *@param name The name of the attribute.
+   *@param value The value of the attribute.
+   */
+  void XMLWriter::addAttribute(const std::string& name, const std::string& value)
+  {
+    if (!startTagOpen)
+      throw XMLException("Attributes can only be written right after the start tag");
+    append(" ", 1);
+    append(name);
+    append("=\"", 2);
+    append(value);
+    append("\"", 1);
+  }
+
+  /**
+   * Function which writes an end tag.
+   *
+   *@param name The name of the element.
+   */
+  void XMLWriter::endElement(const std::string& name)
+  {
+    closeStartTag();
+    append("</", 2);
+    append(name);
+    append(">", 1);
+  }
+
+  /**
+   * Function which writes text content.
+   *
+   *@param text The text.
+   */
+  void XMLWriter::addText(const std::string& text)
+  {
+    if (text.empty())
+      return;
+    closeStartTag();
+    append(text);
+  }
+
+  /**
+   * Function which writes a CDATA section.
+   *
+   *@param cdata The content of the section.
+   */
+  void XMLWriter::addCDATA(const std::string& cdata)
+  {
+    closeStartTag();
+    append("<![CDATA[", 9);
+    append(cdata);
+    append("]]>\n", 4);
+  }
+
+  /**
+   * Function which writes a comment.
+   *
+   *@param comment The content of the comment.
+   */
+  void XMLWriter::addComment(const std::string& comment)
+  {
+    closeStartTag();
+    append("<!--", 4);
+    append(comment);
+    append("-->", 3);
+  }
+
+  /**
+   * Function which writes the buffered output to the stream. An open start tag stays open.
+   */
+  void XMLWriter::flush()
+  {
+    if (!buffer.empty()) {
+      os.write(buffer.data(), buffer.size());
+      buffer.clear();
+    }
+    if (!os)
+      throw XMLException("Error while writing XML output");
+  }
+
+}
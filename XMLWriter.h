@@ -0,0 +1,42 @@
+#ifndef __XMLWRITER_H__
+#define __XMLWRITER_H__
+
+#include <string>
+#include <ostream>
+
+namespace tinyXMLpp {
+
+  /*Writes XML to a stream piece by piece, without building nodes. The
+    output goes through a fixed size buffer, and has the same layout as
+    Document::write.*/
+  class XMLWriter {
+
+    std::ostream& os;
+    std::string buffer;
+    size_t capacity;
+    bool startTagOpen;		//the '>' of the last start tag is not written yet
+
+    void append(const char* data, size_t length);
+    void append(const std::string& str);
+    void closeStartTag();
+
+    public:
+    XMLWriter(std::ostream& os, size_t bufferSize = 64 * 1024);
+    ~XMLWriter();
+
+    /*Attributes follow the start tag they belong to*/
+    void startElement(const std::string& name);
+    void addAttribute(const std::string& name, const std::string& value);
+    void endElement(const std::string& name);
+
+    void addText(const std::string& text);
+    void addCDATA(const std::string& cdata);
+    void addComment(const std::string& comment);
+
+    /*Writes the buffered output to the stream*/
+    void flush();
+  };
+
+}
+
+#endif
@@ -8,5 +8,21 @@
 #include "TextNode.h"
 #include "CommentNode.h"
 #include "CDATANode.h"
+#include "Snapshot.h"
+#include "BatchParser.h"
+#include "FrozenDocument.h"
+#include "FlatDocument.h"
+#include "Binding.h"
+#include "ElementPath.h"
+#include "XMLIndex.h"
+#include "RecordReader.h"
+#include "XMLWriter.h"
+#include "TransformPipeline.h"
+#include "AsyncParser.h"
+#include "Encoding.h"
+#include "Namespace.h"
+#include "TreeDiff.h"
+#include "ParseError.h"
+#include "DocumentPublisher.h"
 
 #endif